@@ -210,6 +210,18 @@ void getComponents(Field* f, MeshEntity* e, int node, double* components)
   f->getData()->getNodeComponents(e,node,components);
 }
 
+std::size_t setComponents(Field* f, int dimension,
+    std::size_t begin, std::size_t end, double const* components)
+{
+  return f->getData()->setRange(dimension, begin, end, components);
+}
+
+std::size_t getComponents(Field* f, int dimension,
+    std::size_t begin, std::size_t end, double* components)
+{
+  return f->getData()->getRange(dimension, begin, end, components);
+}
+
 Element* createElement(Field* f, MeshElement* e)
 {
   return f->getElement(e);
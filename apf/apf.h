@@ -36,6 +36,8 @@ class VectorElement;
 /** \brief Mesh Elements represent the mesh coordinate vector field. */
 typedef VectorElement MeshElement;
 class FieldShape;
+class GeometryCache;
+class ShapeTable;
 struct Sharing;
 
 /** \brief Destroys an apf::Mesh.
@@ -222,6 +224,25 @@ void setComponents(Field* f, MeshEntity* e, int node, double const* components);
  */
 void getComponents(Field* f, MeshEntity* e, int node, double* components);
 
+/** \brief Set the values of a range of entities at once.
+  \details the entities are those at positions [begin, end) of
+  iteration over (dimension), and (components) holds all
+  the node values of each in turn, as many per entity as
+  its type has nodes in apf::getShape times apf::countComponents.
+  For fields stored as tags of a mesh without deleted entities,
+  such as a freshly loaded MDS mesh, this is a single copy into
+  the tag storage with no work per entity.
+  \returns the number of values read from (components) */
+std::size_t setComponents(Field* f, int dimension,
+    std::size_t begin, std::size_t end, double const* components);
+
+/** \brief Copy the values of a range of entities at once.
+  \details the counterpart of the range version of apf::setComponents,
+  every entity in the range must have values.
+  \returns the number of values written to (components) */
+std::size_t getComponents(Field* f, int dimension,
+    std::size_t begin, std::size_t end, double* components);
+
 /** \brief Create a Field Element from a Mesh Element.
   *
   * \details A Field Element object caches elemental data for
@@ -372,6 +393,13 @@ class Integrator
     void process(Mesh* m);
     /** \brief Run the Integrator over a Mesh Element. */
     void process(MeshElement* e);
+    /** \brief Run the Integrator over the local elements of a cache.
+      *
+      * \details the differential volumes come from the cache,
+      * which must be of the same order as the Integrator.
+      * It is filled again first if the mesh has changed.
+      */
+    void process(GeometryCache* cache);
     /** \brief User callback: element entry.
       *
       * \details APF will call this function every time the
@@ -407,6 +435,8 @@ class Integrator
   protected:
     int order;
     int ipnode;
+  private:
+    void process(MeshElement* e, ShapeTable const* table);
 };
 
 /** \brief Measures the volume, area, or length of a Mesh Element.
@@ -542,6 +572,27 @@ void writeVtkFiles(const char* prefix, Mesh* m, int cellDim = -1);
 void writeVtkFiles(const char* prefix, Mesh* m,
     std::vector<std::string> writeFields, int cellDim = -1);
 
+/** \brief Write a set of parallel VTK Unstructured Mesh files from an apf::Mesh
+  * with raw binary data appended to each .vtu file and zlib compression
+  * (if LION_COMPRESS=ON)
+  * \details The data are not base64 encoded, so the files are a quarter
+  * smaller than those of apf::writeVtkFiles and take less time to write.
+  * Large arrays are compressed in blocks, in parallel when OpenMP is enabled.
+  * Nodal fields whose shape differs from the mesh shape will
+  * not be output. Fields with incomplete data will not be output.
+  */
+void writeAppendedVtkFiles(const char* prefix, Mesh* m, int cellDim = -1);
+
+/** \brief Write a set of parallel VTK Unstructured Mesh files from an apf::Mesh
+  * with raw binary data appended to each .vtu file and zlib compression
+  * (if LION_COMPRESS=ON)
+  * \details Only fields whose name appears in the vector writeFields will be
+  * output. Nodal fields whose shape differs from the mesh shape will not be
+  * output. Fields with incomplete data will not be output.
+  */
+void writeAppendedVtkFiles(const char* prefix, Mesh* m,
+    std::vector<std::string> writeFields, int cellDim = -1);
+
 /** \brief Output just the .vtu file with ASCII encoding for this part.
   \details this function is useful for debugging large parallel meshes.
   */
@@ -9,12 +9,18 @@
 #include "apfCavityOp.h"
 #include "apf.h"
 #include "apfMesh2.h"
+#include <pcu_util.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace apf {
 
 CavityOp::CavityOp(Mesh* m, bool cm):
   mesh(m),
   isRequesting(false),
+  isRecording(false),
+  threads(1),
   canModify(cm),
   movedByDeletion(false),
   iterator(0),
@@ -66,6 +72,9 @@ void CavityOp::applyLocallyWithModification(int d)
 
 void CavityOp::preDeletion(MeshEntity* e)
 {
+  /* threads apply cavities from lists, not the iterator */
+  if ( ! this->iterator)
+    return;
   Mesh2* mesh2 = static_cast<Mesh2*>(mesh);
   if (( ! mesh2->isDone(this->iterator))&&
       (e == mesh2->deref(this->iterator)))
@@ -94,19 +103,256 @@ void CavityOp::applyLocallyWithoutModification(int d)
   mesh->end(entities);
 }
 
-void CavityOp::applyToDimension(int d)
+CavityOp* CavityOp::makeThreadCopy()
+{
+  return 0;
+}
+
+int CavityOp::getMaxCreated(int)
+{
+  return 0;
+}
+
+void CavityOp::setThreads(int n)
+{
+  PCU_ALWAYS_ASSERT(n > 0);
+  threads = n;
+}
+
+bool CavityOp::canApplyOnThreads()
+{
+#ifdef _OPENMP
+  if (threads < 2 || ( ! canModify))
+    return false;
+  return static_cast<Mesh2*>(mesh)->canModifyOnThreads();
+#else
+  return false;
+#endif
+}
+
+static int getThread()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/* the vertices of the entity and of the elements
+   adjacent to the entities it requested */
+void CavityOp::getClosureVertices(MeshEntity* e,
+    std::vector<MeshEntity*>& vertices)
+{
+  Downward down;
+  int n = 1;
+  if (getDimension(mesh, e) == 0)
+    down[0] = e;
+  else
+    n = mesh->getDownward(e, 0, down);
+  vertices.assign(down, down + n);
+  int dim = mesh->getDimension();
+  for (size_t i = 0; i < cavity.size(); ++i)
+  {
+    Adjacent elements;
+    mesh->getAdjacent(cavity[i], dim, elements);
+    for (size_t j = 0; j < elements.getSize(); ++j)
+    {
+      n = mesh->getDownward(elements[j], 0, down);
+      vertices.insert(vertices.end(), down, down + n);
+    }
+  }
+}
+
+/* runs setEntity on all candidates, leaving the
+   closure vertices of those that returned OK */
+void CavityOp::evaluateOnThreads(std::vector<MeshEntity*>& candidates,
+    std::vector<CavityOp*>& copies,
+    std::vector<std::vector<MeshEntity*> >& closures)
+{
+  long n = candidates.size();
+  closures.assign(n, std::vector<MeshEntity*>());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(copies.size()) schedule(dynamic, 64)
+#endif
+  for (long i = 0; i < n; ++i)
+  {
+    CavityOp* op = copies[getThread()];
+    op->cavity.clear();
+    if (op->setEntity(candidates[i]) == OK)
+      op->getClosureVertices(candidates[i], closures[i]);
+  }
+}
+
+void CavityOp::applyOnThreads(std::vector<MeshEntity*>& selected,
+    std::vector<CavityOp*>& copies)
+{
+  Mesh2* mesh2 = static_cast<Mesh2*>(mesh);
+  for (int type = 0; type < Mesh::TYPES; ++type)
+  {
+    int most = getMaxCreated(type);
+    if (most)
+      mesh2->reserve(type, selected.size() * most);
+  }
+  long n = selected.size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(copies.size()) schedule(dynamic, 16)
+#endif
+  for (long i = 0; i < n; ++i)
+  {
+    CavityOp* op = copies[getThread()];
+    op->cavity.clear();
+    if (op->setEntity(selected[i]) == OK)
+      op->apply();
+  }
+}
+
+/* the loop that requests non-local cavities,
+   with the requests of all threads gathered here */
+void CavityOp::requestOnThreads(int d, std::vector<CavityOp*>& copies)
+{
+  std::vector<MeshEntity*> owned;
+  MeshEntity* e;
+  MeshIterator* it = mesh->begin(d);
+  while ((e = mesh->iterate(it)))
+    if (sharing->isOwned(e))
+      owned.push_back(e);
+  mesh->end(it);
+  for (size_t i = 0; i < copies.size(); ++i)
+  {
+    copies[i]->isRecording = false;
+    copies[i]->isRequesting = true;
+  }
+  long n = owned.size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(copies.size()) schedule(dynamic, 64)
+#endif
+  for (long i = 0; i < n; ++i)
+    copies[getThread()]->setEntity(owned[i]);
+  for (size_t i = 0; i < copies.size(); ++i)
+  {
+    Requests& r = copies[i]->requests;
+    requests.insert(requests.end(), r.begin(), r.end());
+  }
+}
+
+static int getClaim(Mesh* m, MeshTag* claims, MeshEntity* v)
+{
+  if ( ! m->hasTag(v, claims))
+    return 0;
+  int round;
+  m->getIntTag(v, claims, &round);
+  return round;
+}
+
+/* applies the local cavities in rounds. Each round evaluates
+   the candidates on threads, then picks in order the cavities
+   whose closures share no vertex with a cavity picked before,
+   and applies those on threads. Candidates that were passed
+   over are tried again in the next round, if they still exist.
+   Entities created by the operator are not visited. */
+void CavityOp::applyLocallyOnThreads(int d)
+{
+  std::vector<CavityOp*> copies;
+  for (int i = 0; i < threads; ++i)
+  {
+    CavityOp* copy = makeThreadCopy();
+    if ( ! copy)
+      break;
+    copy->sharing = sharing;
+    copy->iterator = 0;
+    copy->requests.clear();
+    copy->isRequesting = false;
+    copy->isRecording = true;
+    copies.push_back(copy);
+  }
+  if (int(copies.size()) < threads)
+  {
+    for (size_t i = 0; i < copies.size(); ++i)
+      delete copies[i];
+    applyLocallyWithModification(d);
+    return;
+  }
+  static_cast<Mesh2*>(mesh)->requireUnfrozen();
+  MeshTag* claims = mesh->createIntTag("apf_cavity_claim", 1);
+  MeshTag* deferred = mesh->createIntTag("apf_cavity_deferred", 1);
+  std::vector<MeshEntity*> candidates;
+  MeshEntity* e;
+  MeshIterator* it = mesh->begin(d);
+  while ((e = mesh->iterate(it)))
+    if (sharing->isOwned(e))
+      candidates.push_back(e);
+  mesh->end(it);
+  std::vector<std::vector<MeshEntity*> > closures;
+  std::vector<MeshEntity*> selected;
+  for (int round = 1; ! candidates.empty(); ++round)
+  {
+    evaluateOnThreads(candidates, copies, closures);
+    selected.clear();
+    bool isDeferring = false;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+      std::vector<MeshEntity*>& closure = closures[i];
+      if (closure.empty())
+        continue;
+      bool isFree = true;
+      for (size_t j = 0; j < closure.size(); ++j)
+        if (getClaim(mesh, claims, closure[j]) == round)
+        {
+          isFree = false;
+          break;
+        }
+      if (isFree)
+      {
+        for (size_t j = 0; j < closure.size(); ++j)
+          mesh->setIntTag(closure[j], claims, &round);
+        selected.push_back(candidates[i]);
+      }
+      else
+      {
+        mesh->setIntTag(candidates[i], deferred, &round);
+        isDeferring = true;
+      }
+    }
+    closures.clear();
+    applyOnThreads(selected, copies);
+    candidates.clear();
+    if ( ! isDeferring)
+      break;
+    it = mesh->begin(d);
+    while ((e = mesh->iterate(it)))
+      if (mesh->hasTag(e, deferred))
+      {
+        mesh->removeTag(e, deferred);
+        candidates.push_back(e);
+      }
+    mesh->end(it);
+  }
+  removeTagFromDimension(mesh, claims, 0);
+  mesh->destroyTag(claims);
+  mesh->destroyTag(deferred);
+  requestOnThreads(d, copies);
+  for (size_t i = 0; i < copies.size(); ++i)
+    delete copies[i];
+}
+
+int CavityOp::applyToDimension(int d)
 {
   /* the iteration count of this loop is hard to predict,
    * but typical cavity definitions should cause a small
    * constant number of iterations that does not grow
    * with parallelism
    */
+  int passes = 0;
   do {
+    ++passes;
     delete sharing;
     sharing = apf::getSharing(mesh);
     /* apply the operator to all local cavities
        and request missing cavity elements */
-    if (this->canModify)
+    if (this->canApplyOnThreads())
+      this->applyLocallyOnThreads(d);
+    else if (this->canModify)
       this->applyLocallyWithModification(d);
     else
       this->applyLocallyWithoutModification(d);
@@ -118,6 +364,7 @@ void CavityOp::applyToDimension(int d)
   } while (tryToPull());
   delete sharing;
   sharing = 0;
+  return passes;
 }
 
 bool CavityOp::requestLocality(MeshEntity** entities, int count)
@@ -126,6 +373,8 @@ bool CavityOp::requestLocality(MeshEntity** entities, int count)
   for (int i=0; i < count; ++i)
     if (sharing->isShared(entities[i]))
       areLocal = false;
+  if (isRecording)
+    cavity.insert(cavity.end(), entities, entities + count);
   if (isRequesting && ( ! areLocal))
     for (int i=0; i < count; ++i)
       requests.insert(requests.end(),entities,entities+count);
@@ -63,6 +63,18 @@ namespace apf {
    mesh modifying operators should call preDeletion(e) before
    actually deleting an entity to prevent a crash due to
    iterator invalidation.
+
+   A mesh modifying operator can also be applied by several
+   threads, see CavityOp::setThreads. Each thread uses its own
+   copy of the operator from makeThreadCopy(). The cavity is
+   taken to be the elements adjacent to the entities given to
+   requestLocality, so those must include every entity whose
+   upward adjacencies setEntity or apply use. Cavities are applied
+   at the same time only if their closures share no vertex, so
+   setEntity and apply must not touch the mesh outside of the
+   closure, and anything else they write has to be thread-safe.
+   MDS reads and sets the tags of different entities
+   on threads without locking.
 */
 
 /** \brief user-defined mesh cavity operator */
@@ -73,6 +85,9 @@ class CavityOp
       \param canModify true iff the operator can create or
                        destroy mesh entities */
     CavityOp(Mesh* m, bool canModify = false);
+    /** \brief destructor, virtual for the copies
+      from makeThreadCopy, which are deleted through this class */
+    virtual ~CavityOp() {}
     /** \brief outcome of a setEntity call */
     enum Outcome {
       /** \brief skip the given entity */
@@ -85,12 +100,29 @@ class CavityOp
     virtual Outcome setEntity(MeshEntity* e) = 0;
     /** \brief apply the operator on the (now local) cavity */
     virtual void apply() = 0;
-    /** \brief parallel collective operation over entities of one dimension */
-    void applyToDimension(int d);
+    /** \brief parallel collective operation over entities of one dimension
+      \returns the number of passes over the entities, which is
+               one more than the number of times cavities were pulled */
+    int applyToDimension(int d);
     /** \brief within setEntity, require that entities be made local */
     bool requestLocality(MeshEntity** entities, int count);
     /** \brief call before deleting a mesh entity during the operation */
     void preDeletion(MeshEntity* e);
+    /** \brief a copy of this operator for one thread to use
+      \details the default returns zero, which keeps the
+      operator on one thread. The copy is deleted afterwards. */
+    virtual CavityOp* makeThreadCopy();
+    /** \brief at most how many entities of an apf::Mesh::Type
+      one apply() call creates, the default is zero
+      \details room for them is made before applying cavities
+      on threads, since the mesh storage must not move then */
+    virtual int getMaxCreated(int type);
+    /** \brief apply the operator on this many threads
+      \details this takes effect for mesh modifying operators
+      that override makeThreadCopy on meshes that can be modified
+      on threads, and requires building with ENABLE_OPENMP.
+      Otherwise, and by default, one thread is used. */
+    void setThreads(int n);
     /** \brief mesh pointer for convenience */
     Mesh* mesh;
   private:
@@ -102,6 +134,20 @@ class CavityOp
     bool tryToPull();
     void applyLocallyWithModification(int d);
     void applyLocallyWithoutModification(int d);
+    bool canApplyOnThreads();
+    void applyLocallyOnThreads(int d);
+    void evaluateOnThreads(std::vector<MeshEntity*>& candidates,
+        std::vector<CavityOp*>& copies,
+        std::vector<std::vector<MeshEntity*> >& closures);
+    void applyOnThreads(std::vector<MeshEntity*>& selected,
+        std::vector<CavityOp*>& copies);
+    void requestOnThreads(int d, std::vector<CavityOp*>& copies);
+    void getClosureVertices(MeshEntity* e,
+        std::vector<MeshEntity*>& vertices);
+    /* entities given to requestLocality, kept for threads */
+    std::vector<MeshEntity*> cavity;
+    bool isRecording;
+    int threads;
     bool canModify;
     bool movedByDeletion;
     MeshIterator* iterator;
@@ -3,59 +3,92 @@
 #include "apfMesh2.h"
 #include "apf.h"
 #include "apfNumbering.h"
+#include <pcu_util.h>
 #include <map>
+#include <algorithm>
 
 namespace apf {
 
-typedef int Gid;
+/* the vertices of a GlobalToVert copied into arrays sorted
+   by global id, so that the lookups done for every element
+   and message are binary searches over contiguous memory
+   rather than walks down the tree */
+struct SortedVerts
+{
+  SortedVerts(GlobalToVert& globalToVert)
+  {
+    gids.reserve(globalToVert.size());
+    verts.reserve(globalToVert.size());
+    APF_ITERATE(GlobalToVert, globalToVert, it) {
+      gids.push_back(it->first);
+      verts.push_back(it->second);
+    }
+  }
+  MeshEntity* find(Gid gid)
+  {
+    std::vector<Gid>::iterator it =
+      std::lower_bound(gids.begin(), gids.end(), gid);
+    PCU_ALWAYS_ASSERT(it != gids.end() && *it == gid);
+    return verts[it - gids.begin()];
+  }
+  std::vector<Gid> gids;
+  std::vector<MeshEntity*> verts;
+};
 
 static void constructVerts(
     Mesh2* m, const Gid* conn, int nelem, int etype,
     GlobalToVert& result)
 {
   ModelEntity* interior = m->findModelEntity(m->getDimension(), 0);
-  int end = nelem * apf::Mesh::adjacentCount[etype][0];
-  for (int i = 0; i < end; ++i)
-    if ( ! result.count(conn[i]))
-      result[conn[i]] = m->createVert_(interior);
+  size_t end = size_t(nelem) * apf::Mesh::adjacentCount[etype][0];
+  std::vector<Gid> gids(conn, conn + end);
+  std::sort(gids.begin(), gids.end());
+  gids.erase(std::unique(gids.begin(), gids.end()), gids.end());
+  /* inserting in order next to the last insertion
+     keeps this linear in the number of vertices */
+  GlobalToVert::iterator hint = result.begin();
+  for (size_t i = 0; i < gids.size(); ++i) {
+    hint = result.insert(hint, std::make_pair(gids[i], (MeshEntity*)0));
+    if (!hint->second)
+      hint->second = m->createVert_(interior);
+  }
 }
 
 static void constructElements(
     Mesh2* m, const Gid* conn, int nelem, int etype,
-    GlobalToVert& globalToVert)
+    SortedVerts& globalToVert)
 {
   ModelEntity* interior = m->findModelEntity(m->getDimension(), 0);
   int nev = apf::Mesh::adjacentCount[etype][0];
   for (int i = 0; i < nelem; ++i) {
     Downward verts;
-    int offset = i * nev;
+    size_t offset = size_t(i) * nev;
     for (int j = 0; j < nev; ++j)
-      verts[j] = globalToVert[conn[j + offset]];
+      verts[j] = globalToVert.find(conn[j + offset]);
     buildElement(m, interior, etype, verts);
   }
 }
 
-static Gid getMax(const GlobalToVert& globalToVert)
+static Gid getMax(const SortedVerts& globalToVert)
 {
   Gid max = -1;
-  APF_CONST_ITERATE(GlobalToVert, globalToVert, it)
-    max = std::max(max, it->first);
-  return PCU_Max_Int(max); // this is type-dependent
+  if (!globalToVert.gids.empty())
+    max = globalToVert.gids.back();
+  return PCU_Max_Long(max); // this is type-dependent
 }
 
-
 /* algorithm courtesy of Sebastian Rettenberger:
    use brokers/routers for the vertex global ids.
    Although we have used this trick before (see mpas/apfMPAS.cc),
    I didn't think to use it here, so credit is given. */
-static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
+static void constructResidence(Mesh2* m, SortedVerts& globalToVert)
 {
   Gid max = getMax(globalToVert);
   Gid total = max + 1;
   int peers = PCU_Comm_Peers();
-  int quotient = total / peers;
-  int remainder = total % peers;
-  int mySize = quotient;
+  Gid quotient = total / peers;
+  Gid remainder = total % peers;
+  Gid mySize = quotient;
   int self = PCU_Comm_Self();
   if (self == (peers - 1))
     mySize += remainder;
@@ -64,17 +97,17 @@ static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
   /* if we have a vertex, send its global id to the
      broker for that global id */
   PCU_Comm_Begin();
-  APF_ITERATE(GlobalToVert, globalToVert, it) {
-    int gid = it->first;
-    int to = std::min(peers - 1, gid / quotient);
+  for (size_t i = 0; i < globalToVert.gids.size(); ++i) {
+    Gid gid = globalToVert.gids[i];
+    int to = std::min(Gid(peers - 1), gid / quotient);
     PCU_COMM_PACK(to, gid);
   }
   PCU_Comm_Send();
-  int myOffset = self * quotient;
+  Gid myOffset = self * quotient;
   /* brokers store all the part ids that sent messages
      for each global id */
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     int from = PCU_Comm_Sender();
     tmpParts.at(gid - myOffset).push_back(from);
@@ -82,11 +115,11 @@ static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
   /* for each global id, send all associated part ids
      to all associated parts */
   PCU_Comm_Begin();
-  for (int i = 0; i < mySize; ++i) {
+  for (Gid i = 0; i < mySize; ++i) {
     std::vector<int>& parts = tmpParts[i];
     for (size_t j = 0; j < parts.size(); ++j) {
       int to = parts[j];
-      int gid = i + myOffset;
+      Gid gid = i + myOffset;
       int nparts = parts.size();
       PCU_COMM_PACK(to, gid);
       PCU_COMM_PACK(to, nparts);
@@ -99,7 +132,7 @@ static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
      lookup the vertex and classify it on the partition
      model entity for that set of parts */
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     int nparts;
     PCU_COMM_UNPACK(nparts);
@@ -109,7 +142,7 @@ static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
       PCU_COMM_UNPACK(part);
       residence.insert(part);
     }
-    MeshEntity* vert = globalToVert[gid];
+    MeshEntity* vert = globalToVert.find(gid);
     m->setResidence(vert, residence);
   }
 }
@@ -117,13 +150,13 @@ static void constructResidence(Mesh2* m, GlobalToVert& globalToVert)
 /* given correct residence from the above algorithm,
    negotiate remote copies by exchanging (gid,pointer)
    pairs with parts in the residence of the vertex */
-static void constructRemotes(Mesh2* m, GlobalToVert& globalToVert)
+static void constructRemotes(Mesh2* m, SortedVerts& globalToVert)
 {
   int self = PCU_Comm_Self();
   PCU_Comm_Begin();
-  APF_ITERATE(GlobalToVert, globalToVert, it) {
-    int gid = it->first;
-    MeshEntity* vert = it->second;
+  for (size_t i = 0; i < globalToVert.gids.size(); ++i) {
+    Gid gid = globalToVert.gids[i];
+    MeshEntity* vert = globalToVert.verts[i];
     Parts residence;
     m->getResidence(vert, residence);
     APF_ITERATE(Parts, residence, rit)
@@ -134,23 +167,24 @@ static void constructRemotes(Mesh2* m, GlobalToVert& globalToVert)
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     MeshEntity* remote;
     PCU_COMM_UNPACK(remote);
     int from = PCU_Comm_Sender();
-    MeshEntity* vert = globalToVert[gid];
+    MeshEntity* vert = globalToVert.find(gid);
     m->addRemote(vert, from, remote);
   }
 }
 
-void construct(Mesh2* m, const int* conn, int nelem, int etype,
+void construct(Mesh2* m, const Gid* conn, int nelem, int etype,
     GlobalToVert& globalToVert)
 {
   constructVerts(m, conn, nelem, etype, globalToVert);
-  constructElements(m, conn, nelem, etype, globalToVert);
-  constructResidence(m, globalToVert);
-  constructRemotes(m, globalToVert);
+  SortedVerts sorted(globalToVert);
+  constructElements(m, conn, nelem, etype, sorted);
+  constructResidence(m, sorted);
+  constructRemotes(m, sorted);
   stitchMesh(m);
   m->acceptChanges();
 }
@@ -158,26 +192,27 @@ void construct(Mesh2* m, const int* conn, int nelem, int etype,
 void setCoords(Mesh2* m, const double* coords, int nverts,
     GlobalToVert& globalToVert)
 {
-  Gid max = getMax(globalToVert);
+  SortedVerts sorted(globalToVert);
+  Gid max = getMax(sorted);
   Gid total = max + 1;
   int peers = PCU_Comm_Peers();
-  int quotient = total / peers;
-  int remainder = total % peers;
-  int mySize = quotient;
+  Gid quotient = total / peers;
+  Gid remainder = total % peers;
+  Gid mySize = quotient;
   int self = PCU_Comm_Self();
   if (self == (peers - 1))
     mySize += remainder;
-  int myOffset = self * quotient;
+  Gid myOffset = self * quotient;
 
   /* Force each peer to have exactly mySize verts.
      This means we might need to send and recv some coords */
   double* c = new double[mySize*3];
 
-  int start = PCU_Exscan_Int(nverts);
+  Gid start = PCU_Exscan_Long(nverts);
 
   PCU_Comm_Begin();
-  int to = std::min(peers - 1, start / quotient);
-  int n = std::min((to+1)*quotient-start, nverts);
+  int to = std::min(Gid(peers - 1), start / quotient);
+  int n = std::min((to+1)*quotient-start, Gid(nverts));
   while (nverts > 0) {
     PCU_COMM_PACK(to, start);
     PCU_COMM_PACK(to, n);
@@ -187,7 +222,7 @@ void setCoords(Mesh2* m, const double* coords, int nverts,
     start += n;
     coords += n*3;
     to = std::min(peers - 1, to + 1);
-    n = std::min(quotient, nverts);
+    n = std::min(quotient, Gid(nverts));
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
@@ -200,14 +235,14 @@ void setCoords(Mesh2* m, const double* coords, int nverts,
   typedef std::vector< std::vector<int> > TmpParts;
   TmpParts tmpParts(mySize);
   PCU_Comm_Begin();
-  APF_CONST_ITERATE(GlobalToVert, globalToVert, it) {
-    int gid = it->first;
-    int to = std::min(peers - 1, gid / quotient);
+  for (size_t i = 0; i < sorted.gids.size(); ++i) {
+    Gid gid = sorted.gids[i];
+    int to = std::min(Gid(peers - 1), gid / quotient);
     PCU_COMM_PACK(to, gid);
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     int from = PCU_Comm_Sender();
     tmpParts.at(gid - myOffset).push_back(from);
@@ -215,29 +250,29 @@ void setCoords(Mesh2* m, const double* coords, int nverts,
   
   /* Send the coords to everybody who want them */
   PCU_Comm_Begin();
-  for (int i = 0; i < mySize; ++i) {
+  for (Gid i = 0; i < mySize; ++i) {
     std::vector<int>& parts = tmpParts[i];
     for (size_t j = 0; j < parts.size(); ++j) {
       int to = parts[j];
-      int gid = i + myOffset;
+      Gid gid = i + myOffset;
       PCU_COMM_PACK(to, gid);
       PCU_Comm_Pack(to, &c[i*3], 3*sizeof(double));
     }
   }
   PCU_Comm_Send();
   while (PCU_Comm_Receive()) {
-    int gid;
+    Gid gid;
     PCU_COMM_UNPACK(gid);
     double v[3];
     PCU_Comm_Unpack(v, sizeof(v));
     Vector3 vv(v);
-    m->setPoint(globalToVert[gid], 0, vv);
+    m->setPoint(sorted.find(gid), 0, vv);
   }
 
   delete [] c;
 }
 
-void destruct(Mesh2* m, int*& conn, int& nelem, int &etype)
+void destruct(Mesh2* m, Gid*& conn, int& nelem, int &etype)
 {
   int dim = m->getDimension();
   nelem = m->count(dim);
@@ -27,8 +27,14 @@ class MeshEntity;
   tool. */
 void convert(Mesh *in, Mesh2 *out);
 
+/** \brief a global vertex id
+  \details this is 64 bits wide where long is, as with
+  apf::GlobalNumbering, so meshes may have more than
+  2^31 vertices */
+typedef long Gid;
+
 /** \brief a map from global ids to vertex objects */
-typedef std::map<int, MeshEntity*> GlobalToVert;
+typedef std::map<Gid, MeshEntity*> GlobalToVert;
 
 /** \brief construct a mesh from just a connectivity array
   \details this function is here to interface with very
@@ -42,9 +48,12 @@ typedef std::map<int, MeshEntity*> GlobalToVert;
   algorithm, no processor incurs memory or runtime costs
   proportional to the global mesh size.
 
+  Vertices are looked up in a sorted array during construction,
+  so only the returned map is a tree, and it is filled in order.
+
   Note that all vertices will have zero coordinates, so
   it is often good to use apf::setCoords after this. */
-void construct(Mesh2* m, const int* conn, int nelem, int etype,
+void construct(Mesh2* m, const Gid* conn, int nelem, int etype,
     GlobalToVert& globalToVert);
 
 /** \brief Assign coordinates to the mesh
@@ -60,7 +69,7 @@ void setCoords(Mesh2* m, const double* coords, int nverts,
 
 /** \brief convert an apf::Mesh2 object into a connectivity array
   \details this is useful for debugging the apf::convert function */
-void destruct(Mesh2* m, int*& conn, int& nelem, int &etype);
+void destruct(Mesh2* m, Gid*& conn, int& nelem, int &etype);
 
 /** \brief get a contiguous set of global vertex coordinates
   \details this is used for debugging apf::setCoords */
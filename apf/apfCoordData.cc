@@ -41,6 +41,7 @@ void CoordData::set(MeshEntity* e, double const* data)
      place to have support for changing coordinates */
   Vector3 const* v = reinterpret_cast<Vector3 const*>(data);
   static_cast<Mesh2*>(mesh)->setPoint_(e,0,*v);
+  mesh->changedGeometry();
 }
 
 }
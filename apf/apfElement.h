@@ -32,6 +32,7 @@ class Element
     MeshEntity* getEntity() {return entity;}
     Mesh* getMesh() {return mesh;}
     EntityShape* getShape() {return shape;}
+    FieldShape* getFieldShape() {return field->getShape();}
     void getComponents(Vector3 const& xi, double* c);
   protected:
     void init(Field* f, MeshEntity* e, VectorElement* p);
@@ -227,6 +227,48 @@ int FieldDataOf<T>::getElementData(MeshEntity* entity, NewArray<T>& data)
   return n;
 }
 
+/* the fallback visits entities one at a time, and has
+   to iterate past the first (begin) of them as well */
+template <class T>
+std::size_t FieldDataOf<T>::getRange(int dim, std::size_t begin,
+    std::size_t end, T* values)
+{
+  Mesh* m = field->getMesh();
+  MeshIterator* it = m->begin(dim);
+  for (std::size_t i = 0; i < begin; ++i)
+    m->iterate(it);
+  std::size_t n = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    MeshEntity* e = m->iterate(it);
+    int ne = field->countValuesOn(e);
+    if (ne)
+      get(e, values + n);
+    n += ne;
+  }
+  m->end(it);
+  return n;
+}
+
+template <class T>
+std::size_t FieldDataOf<T>::setRange(int dim, std::size_t begin,
+    std::size_t end, T const* values)
+{
+  Mesh* m = field->getMesh();
+  MeshIterator* it = m->begin(dim);
+  for (std::size_t i = 0; i < begin; ++i)
+    m->iterate(it);
+  std::size_t n = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    MeshEntity* e = m->iterate(it);
+    int ne = field->countValuesOn(e);
+    if (ne)
+      set(e, values + n);
+    n += ne;
+  }
+  m->end(it);
+  return n;
+}
+
 template class FieldDataOf<double>;
 template class FieldDataOf<int>;
 template class FieldDataOf<long>;
@@ -55,6 +55,13 @@ class FieldDataOf : public FieldData
     void setNodeComponents(MeshEntity* e, int node, T const* components);
     void getNodeComponents(MeshEntity* e, int node, T* components);
     int getElementData(MeshEntity* entity, NewArray<T>& data);
+    /* the values of the entities at positions [begin, end) of
+       iteration over (dim), one entity after another.
+       Returns the number of values copied */
+    virtual std::size_t getRange(int dim, std::size_t begin, std::size_t end,
+        T* values);
+    virtual std::size_t setRange(int dim, std::size_t begin, std::size_t end,
+        T const* values);
 };
 
 } //namespace apf
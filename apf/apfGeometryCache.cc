@@ -0,0 +1,99 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#include "apfGeometryCache.h"
+#include "apf.h"
+#include "apfElement.h"
+#include "apfField.h"
+#include "apfFieldData.h"
+#include "apfIntegrate.h"
+#include "apfShape.h"
+#include "apfVectorElement.h"
+#include <pcu_util.h>
+
+namespace apf {
+
+GeometryCache::GeometryCache(Mesh* m, int dim, int o):
+  mesh(m),
+  dimension(dim),
+  order(o)
+{
+  PCU_ALWAYS_ASSERT(dim > 0 && dim <= m->getDimension());
+  fill();
+}
+
+bool GeometryCache::isValid()
+{
+  /* destroying elements without acceptChanges
+     is only noticed by the count */
+  return version == mesh->getGeometryVersion() &&
+         elements.size() == mesh->count(dimension);
+}
+
+void GeometryCache::update()
+{
+  if (!isValid())
+    fill();
+}
+
+void GeometryCache::fill()
+{
+  version = mesh->getGeometryVersion();
+  elements.clear();
+  offsets.assign(1, 0);
+  Integration const* rules[Mesh::TYPES] = {};
+  MeshEntity* e;
+  MeshIterator* it = mesh->begin(dimension);
+  while ((e = mesh->iterate(it))) {
+    int type = mesh->getType(e);
+    if (!rules[type]) {
+      EntityIntegration const* ei = getIntegration(type);
+      rules[type] = ei ? ei->getAccurate(order) : 0;
+      if (!rules[type])
+        fail("apf::GeometryCache: no integration of the requested order\n");
+    }
+    elements.push_back(e);
+    offsets.push_back(offsets.back() + rules[type]->countPoints());
+  }
+  mesh->end(it);
+  jacobians.resize(offsets.back());
+  inverses.resize(offsets.back());
+  determinants.resize(offsets.back());
+  FieldShape* s = mesh->getShape();
+  FieldDataOf<double>* coords = mesh->getCoordinateField()->getData();
+  ShapeTable const* tables[Mesh::TYPES];
+  for (int type = 0; type < Mesh::TYPES; ++type)
+    tables[type] = rules[type] ? getShapeTable(s, type, order) : 0;
+  NewArray<double> x;
+  NewArray<Vector3> g;
+  for (std::size_t i = 0; i < elements.size(); ++i) {
+    e = elements[i];
+    int type = mesh->getType(e);
+    EntityShape* es = s->getEntityShape(type);
+    int nen = es->countNodes();
+    coords->getElementData(e, x);
+    Vector3 const* nodes = reinterpret_cast<Vector3 const*>(&x[0]);
+    for (int p = 0; p < countPoints(i); ++p) {
+      Vector3 const* localGradients;
+      if (tables[type])
+        localGradients = tables[type]->getLocalGradients(p);
+      else {
+        es->getLocalGradients(mesh, e, rules[type]->getPoint(p)->param, g);
+        localGradients = &g[0];
+      }
+      std::size_t k = offsets[i] + p;
+      Matrix3x3& J = jacobians[k];
+      J = tensorProduct(localGradients[0], nodes[0]);
+      for (int n = 1; n < nen; ++n)
+        J = J + tensorProduct(localGradients[n], nodes[n]);
+      inverses[k] = apf::getJacobianInverse(J, dimension);
+      determinants[k] = getJacobianDeterminant(J, dimension);
+    }
+  }
+}
+
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 Scientific Computation Research Center
+ *
+ * This work is open source software, licensed under the terms of the
+ * BSD license as described in the LICENSE file in the top-level directory.
+ */
+
+#ifndef APFGEOMETRYCACHE_H
+#define APFGEOMETRYCACHE_H
+
+/** \file apfGeometryCache.h
+  \brief Element Jacobians stored for reuse */
+
+#include "apfMesh.h"
+#include "apfMatrix.h"
+#include <vector>
+
+namespace apf {
+
+/** \brief the Jacobians, their inverses and determinants
+           of all elements of one dimension at integration points
+  \details the cache is filled in one pass over the elements, one
+           element type at a time. Coordinate shapes that are the
+           same on every element (see apf::getShapeTable) are
+           evaluated once per type rather than once per point.
+           Elements are numbered in the order of Mesh::begin.
+           The cache stays valid until the mesh coordinates or elements
+           change, as counted by Mesh::getGeometryVersion, and
+           update() fills it again after that. */
+class GeometryCache
+{
+  public:
+    /** \brief fill a cache for elements of (dim) at the points
+               of integration rules of (order)
+      \details this fails if some element type has no rule
+               of that order */
+    GeometryCache(Mesh* m, int dim, int order);
+    /** \brief true if nothing changed since the cache was filled */
+    bool isValid();
+    /** \brief fill the cache again if it is no longer valid */
+    void update();
+    Mesh* getMesh() {return mesh;}
+    int getDimension() {return dimension;}
+    int getOrder() {return order;}
+    std::size_t countElements() {return elements.size();}
+    MeshEntity* getElement(std::size_t i) {return elements[i];}
+    int countPoints(std::size_t i)
+    {
+      return offsets[i + 1] - offsets[i];
+    }
+    Matrix3x3 const& getJacobian(std::size_t i, int point)
+    {
+      return jacobians[offsets[i] + point];
+    }
+    /** \brief see apf::getJacobianInverse */
+    Matrix3x3 const& getJacobianInverse(std::size_t i, int point)
+    {
+      return inverses[offsets[i] + point];
+    }
+    /** \brief the differential volume, as apf::getDV */
+    double getDV(std::size_t i, int point)
+    {
+      return determinants[offsets[i] + point];
+    }
+  private:
+    void fill();
+    Mesh* mesh;
+    int dimension;
+    int order;
+    std::size_t version;
+    std::vector<MeshEntity*> elements;
+    std::vector<std::size_t> offsets;
+    std::vector<Matrix3x3> jacobians;
+    std::vector<Matrix3x3> inverses;
+    std::vector<double> determinants;
+};
+
+}
+
+#endif
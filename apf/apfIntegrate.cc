@@ -8,6 +8,10 @@
 #include "apfIntegrate.h"
 #include "apfMesh.h"
 #include "apf.h"
+#include "apfShape.h"
+#include "apfVectorElement.h"
+#include "apfGeometryCache.h"
+#include <pcu_util.h>
 
 namespace apf {
 
@@ -643,13 +647,21 @@ void Integrator::parallelReduce()
 void Integrator::process(Mesh* m)
 {
   int d = m->getDimension();
+  /* the tables are shared by all elements of a type,
+     so they are looked up once here rather than per element */
+  ShapeTable const* tables[Mesh::TYPES];
+  for (int type = 0; type < Mesh::TYPES; ++type)
+    if (Mesh::typeDimension[type] == d)
+      tables[type] = getShapeTable(m->getShape(), type, this->order);
+    else
+      tables[type] = 0;
   MeshEntity* entity;
   MeshIterator* elements = m->begin(d);
   while ((entity = m->iterate(elements)))
   {
     if ( ! m->isOwned(entity)) continue;
     MeshElement* e = createMeshElement(m,entity);
-    this->process(e);
+    this->process(e, tables[m->getType(entity)]);
     destroyMeshElement(e);
   }
   m->end(elements);
@@ -657,6 +669,11 @@ void Integrator::process(Mesh* m)
 }
 
 void Integrator::process(MeshElement* e)
+{
+  this->process(e, 0);
+}
+
+void Integrator::process(MeshElement* e, ShapeTable const* table)
 {
   this->inElement(e);
   int np = countIntPoints(e,this->order);
@@ -666,12 +683,45 @@ void Integrator::process(MeshElement* e)
     Vector3 point;
     getIntPoint(e,this->order,p,point);
     double w = getIntWeight(e,this->order,p);
-    double dV = getDV(e,point);
+    double dV;
+    /* with tabulated coordinate gradients, the Jacobian at
+       each point is just a sum over the element nodes */
+    if (table) {
+      Matrix3x3 J;
+      e->getJacobian(table->getLocalGradients(p), J);
+      dV = getJacobianDeterminant(J, e->getDimension());
+    } else
+      dV = getDV(e,point);
     this->atPoint(point,w,dV);
   }
   this->outElement();
 }
 
+void Integrator::process(GeometryCache* cache)
+{
+  PCU_ALWAYS_ASSERT(cache->getOrder() == this->order);
+  cache->update();
+  Mesh* m = cache->getMesh();
+  for (std::size_t i = 0; i < cache->countElements(); ++i)
+  {
+    MeshEntity* entity = cache->getElement(i);
+    if ( ! m->isOwned(entity)) continue;
+    MeshElement* e = createMeshElement(m,entity);
+    this->inElement(e);
+    for (int p=0; p < cache->countPoints(i); ++p)
+    {
+      ipnode = p;
+      Vector3 point;
+      getIntPoint(e,this->order,p,point);
+      double w = getIntWeight(e,this->order,p);
+      this->atPoint(point,w,cache->getDV(i,p));
+    }
+    this->outElement();
+    destroyMeshElement(e);
+  }
+  this->parallelReduce();
+}
+
 class Measurer : public Integrator
 {
   public:
@@ -148,6 +148,7 @@ void Mesh::init(FieldShape* s)
   baseP->init("coordinates",this,s,data);
   data->init(baseP);
   hasFrozenFields = false;
+  geometryVersion = 0;
 }
 
 Mesh::~Mesh()
@@ -251,6 +252,43 @@ void Mesh::getPoint(MeshEntity* e, int node, Vector3& p)
   getVector(coordinateField,e,node,p);
 }
 
+void Mesh::getNeighbors(int dimension, std::vector<int>& parts,
+    std::vector<std::size_t>& counts)
+{
+  typedef std::map<int, std::size_t> Counts;
+  Counts shared;
+  MeshEntity* e;
+  MeshIterator* it = begin(dimension);
+  while ((e = iterate(it))) {
+    Copies remotes;
+    getRemotes(e, remotes);
+    APF_ITERATE(Copies, remotes, rit)
+      ++shared[rit->first];
+  }
+  end(it);
+  parts.clear();
+  counts.clear();
+  APF_ITERATE(Counts, shared, sit) {
+    parts.push_back(sit->first);
+    counts.push_back(sit->second);
+  }
+}
+
+void Mesh::getSharedWith(int dimension, int part,
+    std::vector<MeshEntity*>& entities)
+{
+  entities.clear();
+  MeshEntity* e;
+  MeshIterator* it = begin(dimension);
+  while ((e = iterate(it))) {
+    Copies remotes;
+    getRemotes(e, remotes);
+    if (remotes.count(part))
+      entities.push_back(e);
+  }
+  end(it);
+}
+
 FieldShape* Mesh::getShape() const
 {
   return coordinateField->getShape();
@@ -663,6 +701,7 @@ void Mesh::setCoordinateField(Field* field)
 {
   delete coordinateField;
   coordinateField = field;
+  changedGeometry();
 }
 
 void Mesh::changeShape(FieldShape* newShape, bool project)
@@ -691,6 +730,7 @@ void Mesh::changeShape(FieldShape* newShape, bool project)
         this, newShape, new TagDataOf<double>());
   }
   coordinateField = newCoordinateField;
+  changedGeometry();
 }
 
 void changeMeshShape(Mesh* m, FieldShape* newShape, bool project)
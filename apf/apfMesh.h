@@ -223,6 +223,17 @@ class Mesh
       \details this includes parts with remote copies and the
                current part as well */
     virtual void getResidence(MeshEntity* e, Parts& residence) = 0;
+    /** \brief get the parts sharing entities of one dimension with this one
+        \details (parts) is in increasing order and (counts) holds how many
+        entities of (dimension) each of them shares with this part.
+        The default visits every entity; meshes that index their
+        part boundaries answer from that index. */
+    virtual void getNeighbors(int dimension, std::vector<int>& parts,
+        std::vector<std::size_t>& counts);
+    /** \brief get the entities of one dimension shared with a part
+        \details they are given in iteration order */
+    virtual void getSharedWith(int dimension, int part,
+        std::vector<MeshEntity*>& entities);
     /** \brief Creates a double array tag over the mesh given a name and size */
     virtual MeshTag* createDoubleTag(const char* name, int size) = 0;
     /** \brief Creates an int array tag over the mesh given a name and size */
@@ -254,6 +265,21 @@ class Mesh
     virtual bool hasTag(MeshEntity* e, MeshTag* tag) = 0;
     /** \brief renames a tag */
     virtual void renameTag(MeshTag* tag, const char* newName) = 0;
+    /** \brief get the values of a tag on all entities of one type at once
+        \details meshes that keep tag values in one array per type,
+        in iteration order, return that array for (type) and set
+        (count) to the number of entities of (type). If (give) is true
+        the entities [begin,end) in iteration order are first given
+        the tag, otherwise zero is returned unless they all have it.
+        Zero is also returned whenever the array would not be in
+        iteration order, and by meshes without such storage,
+        in which case callers should visit entities one at a time. */
+    virtual void* getTagArray(MeshTag*, int, std::size_t, std::size_t,
+        bool, std::size_t& count)
+    {
+      count = 0;
+      return 0;
+    }
     /** \brief returns the checksum of a tag for the specificed topological type */
     virtual unsigned getTagChecksum(MeshTag* tag, int type) = 0;
     /** \brief Tag data type enumeration */
@@ -317,6 +343,16 @@ class Mesh
     /** \brief make a new coordinate field.
         \param project whether to project coordinate values from the old field */
     void changeShape(FieldShape* newShape, bool project = true);
+    /** \brief count changes to the coordinates and elements
+      \details caches of element geometry such as apf::GeometryCache
+               compare it to the count they were filled at.
+               Mesh2::setPoint, displaceMesh, changeShape and
+               Mesh2::acceptChanges advance it. */
+    std::size_t getGeometryVersion() {return geometryVersion;}
+    /** \brief advance the geometry count after changing
+               coordinates some other way, for example by writing
+               a high-order coordinate field directly */
+    void changedGeometry() {++geometryVersion;}
     /** \brief Migrate elements.
        \param plan a mapping from local elements
                    to part IDs, which will be deleted during migration */
@@ -381,6 +417,7 @@ class Mesh
     bool hasFrozenFields;
   protected:
     Field* coordinateField;
+    std::size_t geometryVersion;
     std::vector<Field*> fields;
     std::vector<Numbering*> numberings;
     std::vector<GlobalNumbering*> globalNumberings;
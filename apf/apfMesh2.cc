@@ -14,6 +14,7 @@ namespace apf
 void Mesh2::setPoint(MeshEntity* e, int node, Vector3 const& p)
 {
   setVector(Mesh::coordinateField,e,node,p);
+  changedGeometry();
 }
 
 MeshEntity* Mesh2::createVertex(ModelEntity* c, Vector3 const& point,
@@ -28,6 +29,7 @@ MeshEntity* Mesh2::createVertex(ModelEntity* c, Vector3 const& point,
 void displaceMesh(Mesh2* m, Field* d, double factor)
 {
   m->getCoordinateField()->axpy(factor,d);
+  m->changedGeometry();
 }
 
 MeshEntity* makeOrFind(
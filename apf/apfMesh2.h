@@ -111,6 +111,20 @@ class Mesh2 : public Mesh
     virtual void clearMatches(MeshEntity* e) = 0;
 /** \brief Remove all entities */
     virtual void clear_() = 0;
+/** \brief Whether several threads may modify the mesh at once
+  \details this is only allowed when each thread creates and destroys
+  entities in its own cavity and no two cavities share an entity,
+  see apf::CavityOp::setThreads */
+    virtual bool canModifyOnThreads() {return false;}
+/** \brief Make room for (count) more entities of a type
+  \details until then, creating that many entities of (type) does not
+  move any storage, so threads can read the mesh while others
+  create entities in it. The default does nothing. */
+    virtual void reserve(int type, std::size_t count)
+    {
+      (void)type;
+      (void)count;
+    }
 /** \brief Implementation-defined synchronization after modification
   \details users are encouraged to call this function after finishing
   mesh modifications so that all structures are properly updated before
@@ -136,6 +150,11 @@ void migrateSilent(Mesh2* m, Migration* plan);
   be performed as several consecutive migrations. */
 void setMigrationLimit(size_t maxElements);
 
+/** \brief the number of elements this part has sent with apf::migrate
+  \details this is a running total, the difference between two
+  calls gives the migration volume of what happened in between. */
+size_t countMigratedElements();
+
 class Field;
 
 /** \brief add a field (times a factor) to the mesh coordinates
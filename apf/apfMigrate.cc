@@ -11,6 +11,7 @@
 #include "apf.h"
 #include <pcu_util.h>
 #include <cstdlib>
+#include <cstring>
 
 namespace apf {
 
@@ -161,29 +162,110 @@ static Parts makeResidence(int part)
   return r;
 }
 
-void packParts(int to, Parts& parts)
+/* writes packed data in place, into space
+   reserved with PCU_Comm_Reserve */
+class Packer
+{
+  public:
+    Packer(int t, size_t bound):
+      to(t)
+    {
+      start = at = static_cast<char*>(PCU_Comm_Reserve(to, bound));
+    }
+    template <class T>
+    void pack(T const& o)
+    {
+      write(&o, sizeof(o));
+    }
+    void write(void const* p, size_t n)
+    {
+      memcpy(at, p, n);
+      at += n;
+    }
+    void commit()
+    {
+      PCU_Comm_Commit(to, at - start);
+    }
+  private:
+    int to;
+    char* start;
+    char* at;
+};
+
+/* reads packed data in place from the
+   received buffer given by PCU_Comm_Span */
+class Unpacker
+{
+  public:
+    Unpacker()
+    {
+      size_t n;
+      start = at = static_cast<char const*>(PCU_Comm_Span(&n));
+      end = start + n;
+    }
+    template <class T>
+    void unpack(T& o)
+    {
+      read(&o, sizeof(o));
+    }
+    void read(void* p, size_t n)
+    {
+      PCU_ALWAYS_ASSERT(at + n <= end);
+      memcpy(p, at, n);
+      at += n;
+    }
+    void extract()
+    {
+      PCU_Comm_Extract(at - start);
+    }
+  private:
+    char const* start;
+    char const* at;
+    char const* end;
+};
+
+static size_t partsBound(Parts& parts)
+{
+  return sizeof(size_t) + parts.size() * sizeof(int);
+}
+
+static void packParts(Packer& p, Parts& parts)
 {
   size_t n = parts.size();
-  PCU_COMM_PACK(to,n);
+  p.pack(n);
   APF_ITERATE(Parts,parts,it)
   {
-    int p = *it;
-    PCU_COMM_PACK(to,p);
+    int part = *it;
+    p.pack(part);
   }
 }
 
-void unpackParts(Parts& parts)
+void packParts(int to, Parts& parts)
+{
+  Packer p(to, partsBound(parts));
+  packParts(p, parts);
+  p.commit();
+}
+
+static void unpackParts(Unpacker& u, Parts& parts)
 {
   size_t n;
-  PCU_COMM_UNPACK(n);
+  u.unpack(n);
   for (size_t i=0;i<n;++i)
   {
     int p;
-    PCU_COMM_UNPACK(p);
+    u.unpack(p);
     parts.insert(p);
   }
 }
 
+void unpackParts(Parts& parts)
+{
+  Unpacker u;
+  unpackParts(u, parts);
+  u.extract();
+}
+
 /* for every entity in the affected closure,
    this function changes the residence to be
    the union of all upward adjacent residences
@@ -256,60 +338,87 @@ void split(
       newParts.insert(*it);
 }
 
+static size_t commonBound(Parts& residence)
+{
+  return sizeof(MeshEntity*) + 2 * sizeof(int) + partsBound(residence);
+}
+
 static void packCommon(
     Mesh2* m,
-    int to,
-    MeshEntity* e)
+    Packer& p,
+    MeshEntity* e,
+    Parts& residence)
 {
-  PCU_COMM_PACK(to,e);
+  p.pack(e);
   ModelEntity* me = m->toModel(e);
   int modelType = m->getModelType(me);
-  PCU_COMM_PACK(to,modelType);
+  p.pack(modelType);
   int modelTag = m->getModelTag(me);
-  PCU_COMM_PACK(to,modelTag);
-  Parts residence;
-  m->getResidence(e,residence);
-  packParts(to,residence);
+  p.pack(modelTag);
+  packParts(p,residence);
 }
 
-void unpackCommon(
+static void unpackCommon(
     Mesh2* m,
+    Unpacker& u,
     MeshEntity*& sender,
     ModelEntity*& c,
     Parts& residence)
 {
-  PCU_COMM_UNPACK(sender);
+  u.unpack(sender);
   int modelType,modelTag;
-  PCU_COMM_UNPACK(modelType);
-  PCU_COMM_UNPACK(modelTag);
+  u.unpack(modelType);
+  u.unpack(modelTag);
   c = m->findModelEntity(modelType,modelTag);
-  unpackParts(residence);
+  unpackParts(u,residence);
+}
+
+void unpackCommon(
+    Mesh2* m,
+    MeshEntity*& sender,
+    ModelEntity*& c,
+    Parts& residence)
+{
+  Unpacker u;
+  unpackCommon(m,u,sender,c,residence);
+  u.extract();
 }
 
 static void packVertex(
     Mesh2* m,
-    int to,
+    Packer& p,
     MeshEntity* e)
 {
-  Vector3 p;
-  m->getPoint(e,0,p);
-  PCU_COMM_PACK(to,p);
-  m->getParam(e,p);
-  PCU_COMM_PACK(to,p);
+  Vector3 x;
+  m->getPoint(e,0,x);
+  p.pack(x);
+  m->getParam(e,x);
+  p.pack(x);
 }
 
-MeshEntity* unpackVertex(
+static MeshEntity* unpackVertex(
     Mesh2* m,
+    Unpacker& u,
     ModelEntity* c)
 {
   Vector3 point;
-  PCU_COMM_UNPACK(point);
+  u.unpack(point);
   Vector3 param;
-  PCU_COMM_UNPACK(param);
+  u.unpack(param);
   return m->createVertex(c,point,param);
 }
 
-static void packReference(
+MeshEntity* unpackVertex(
+    Mesh2* m,
+    ModelEntity* c)
+{
+  Unpacker u;
+  MeshEntity* v = unpackVertex(m,u,c);
+  u.extract();
+  return v;
+}
+
+static MeshEntity* getReference(
     Mesh2* m,
     int to,
     MeshEntity* e)
@@ -318,60 +427,77 @@ static void packReference(
   m->getRemotes(e,remotes);
   Copies::iterator found = remotes.find(to);
   if (found!=remotes.end())
-  {
-    MeshEntity* remote = found->second;
-    PCU_COMM_PACK(to,remote);
-  }
-  else
-  {
-    Copies ghosts;
-    m->getGhosts(e,ghosts);
-    found = ghosts.find(to);
-    PCU_ALWAYS_ASSERT(found!=ghosts.end());
-    MeshEntity* ghost = found->second;
-    PCU_COMM_PACK(to,ghost);
-  }
+    return found->second;
+  Copies ghosts;
+  m->getGhosts(e,ghosts);
+  found = ghosts.find(to);
+  PCU_ALWAYS_ASSERT(found!=ghosts.end());
+  return found->second;
 }
 
-static void packDownward(Mesh2* m, int to, MeshEntity* e)
+static void packDownward(Mesh2* m, Packer& p, int to,
+    int n, Downward& down)
 {
-  Downward down;
-  int d = getDimension(m, e);
-  int n = m->getDownward(e,d-1,down);
-  PCU_COMM_PACK(to,n);
+  p.pack(n);
   for (int i=0; i < n; ++i)
-    packReference(m,to,down[i]);
+  {
+    MeshEntity* reference = getReference(m,to,down[i]);
+    p.pack(reference);
+  }
 }
 
 static void unpackDownward(
+    Unpacker& u,
     Downward& entities)
 {
   int n;
-  PCU_COMM_UNPACK(n);
+  u.unpack(n);
   for (int i=0; i < n; ++i)
-    PCU_COMM_UNPACK(entities[i]);
+    u.unpack(entities[i]);
 }
 
-static void packNonVertex(
+static MeshEntity* unpackNonVertex(
     Mesh2* m,
-    int to,
-    MeshEntity* e)
+    Unpacker& u,
+    int type, ModelEntity* c)
 {
-  packDownward(m,to,e);
+  Downward down;
+  unpackDownward(u,down);
+  return m->createEntity(type,c,down);
 }
 
 MeshEntity* unpackNonVertex(
     Mesh2* m,
     int type, ModelEntity* c)
 {
-  Downward down;
-  unpackDownward(down);
-  return m->createEntity(type,c,down);
+  Unpacker u;
+  MeshEntity* e = unpackNonVertex(m,u,type,c);
+  u.extract();
+  return e;
+}
+
+/* bounds the packed size of all the tags,
+   whether or not a given entity has them */
+static size_t tagsBound(
+    Mesh2* m,
+    DynamicArray<MeshTag*>& tags)
+{
+  size_t bound = sizeof(size_t);
+  for (size_t i=0; i < tags.getSize(); ++i)
+  {
+    bound += sizeof(size_t);
+    int size = m->getTagSize(tags[i]);
+    if (m->getTagType(tags[i]) == Mesh2::DOUBLE)
+      bound += size * sizeof(double);
+    if (m->getTagType(tags[i]) == Mesh2::INT)
+      bound += size * sizeof(int);
+  }
+  return bound;
 }
 
 static void packTags(
     Mesh2* m,
-    int to,
+    Packer& p,
     MeshEntity* e,
     DynamicArray<MeshTag*>& tags)
 {
@@ -380,95 +506,119 @@ static void packTags(
   for (size_t i=0; i < total; ++i)
     if (m->hasTag(e,tags[i]))
       ++n;
-  PCU_COMM_PACK(to,n);
+  p.pack(n);
   for (size_t i=0; i < total; ++i)
   {
     MeshTag* tag = tags[i];
     if (m->hasTag(e,tag))
     {
-      PCU_COMM_PACK(to,i);
+      p.pack(i);
       int type = m->getTagType(tag);
       int size = m->getTagSize(tag);
       if (type == Mesh2::DOUBLE)
       {
         DynamicArray<double> d(size);
         m->getDoubleTag(e,tag,&(d[0]));
-        PCU_Comm_Pack(to,&(d[0]),size*sizeof(double));
+        p.write(&(d[0]),size*sizeof(double));
       }
       if (type == Mesh2::INT)
       {
         DynamicArray<int> d(size);
         m->getIntTag(e,tag,&(d[0]));
-        PCU_Comm_Pack(to,&(d[0]),size*sizeof(int));
+        p.write(&(d[0]),size*sizeof(int));
       }
     }
   }
 }
 
+static size_t remotesBound(Copies& remotes)
+{
+  return sizeof(size_t)
+    + remotes.size() * (sizeof(int) + sizeof(MeshEntity*));
+}
+
 // seol
-void packRemotes(
-    Mesh2* m,
-    int to,
-    MeshEntity* e)
+static void packRemotes(
+    Packer& p,
+    Copies& remotes)
 {
-  Copies remotes;
-  m->getRemotes(e,remotes);
   size_t n = remotes.size();
-  PCU_COMM_PACK(to,n);
+  p.pack(n);
   APF_ITERATE(Copies,remotes,rit)
   {
-    int p=rit->first;
+    int part=rit->first;
     MeshEntity* remote = rit->second;
-    PCU_COMM_PACK(to,p);
-    PCU_COMM_PACK(to,remote);
+    p.pack(part);
+    p.pack(remote);
   }
 }
 
-void unpackRemotes(Mesh2* m, MeshEntity* e)
+static void unpackRemotes(Mesh2* m, Unpacker& u, MeshEntity* e)
 {
   size_t n;
-  PCU_COMM_UNPACK(n);
+  u.unpack(n);
   for (size_t i=0; i < n; ++i)
   {
     int p;
-    PCU_COMM_UNPACK(p);
+    u.unpack(p);
     MeshEntity* r;
-    PCU_COMM_UNPACK(r);
+    u.unpack(r);
     m->addRemote(e, p, r);
   }
 }
 
-void unpackTags(
+void unpackRemotes(Mesh2* m, MeshEntity* e)
+{
+  Unpacker u;
+  unpackRemotes(m,u,e);
+  u.extract();
+}
+
+static void unpackTags(
     Mesh2* m,
+    Unpacker& u,
     MeshEntity* e,
     DynamicArray<MeshTag*>& tags)
 {
   size_t n;
-  PCU_COMM_UNPACK(n);
+  u.unpack(n);
   PCU_ALWAYS_ASSERT_VERBOSE(n<=tags.size(),
       "A tag was created that does not exist on all processes.");
   for (size_t t=0; t < n; ++t)
   {
     size_t i;
-    PCU_COMM_UNPACK(i);
+    u.unpack(i);
     MeshTag* tag = tags[i];
     int type = m->getTagType(tag);
     int size = m->getTagSize(tag);
     if (type == Mesh2::DOUBLE)
     {
       DynamicArray<double> d(size);
-      PCU_Comm_Unpack(&(d[0]),size*sizeof(double));
+      u.read(&(d[0]),size*sizeof(double));
       m->setDoubleTag(e,tag,&(d[0]));
     }
     if (type == Mesh2::INT)
     {
       DynamicArray<int> d(size);
-      PCU_Comm_Unpack(&(d[0]),size*sizeof(int));
+      u.read(&(d[0]),size*sizeof(int));
       m->setIntTag(e,tag,&(d[0]));
     }
   }
 }
 
+void unpackTags(
+    Mesh2* m,
+    MeshEntity* e,
+    DynamicArray<MeshTag*>& tags)
+{
+  Unpacker u;
+  unpackTags(m,u,e,tags);
+  u.extract();
+}
+
+/* the entity is written into space reserved for
+   a bound on its size, which is cheap to compute
+   once its residence and adjacencies are known */
 void packEntity(
     Mesh2* m,
     int to,
@@ -477,15 +627,35 @@ void packEntity(
     bool ghosting)
 {
   int type = m->getType(e);
-  PCU_COMM_PACK(to,type);
-  packCommon(m,to,e);
+  Parts residence;
+  m->getResidence(e,residence);
+  size_t bound = sizeof(int) + commonBound(residence) + tagsBound(m,tags);
+  Downward down;
+  int n = 0;
   if (type == Mesh::VERTEX)
-    packVertex(m,to,e);
+    bound += 2 * sizeof(Vector3);
   else
-    packNonVertex(m,to,e);
-  packTags(m,to,e,tags);
+  {
+    n = m->getDownward(e,getDimension(m, e)-1,down);
+    bound += sizeof(int) + n * sizeof(MeshEntity*);
+  }
+  Copies remotes;
+  if (ghosting)
+  {
+    m->getRemotes(e,remotes);
+    bound += remotesBound(remotes);
+  }
+  Packer p(to, bound);
+  p.pack(type);
+  packCommon(m,p,e,residence);
+  if (type == Mesh::VERTEX)
+    packVertex(m,p,e);
+  else
+    packDownward(m,p,to,n,down);
+  packTags(m,p,e,tags);
   if (ghosting) 
-    packRemotes(m, to, e);
+    packRemotes(p,remotes);
+  p.commit();
 }
 
 static MeshEntity* unpackEntity(
@@ -493,20 +663,21 @@ static MeshEntity* unpackEntity(
     DynamicArray<MeshTag*>& tags)
 {
   int from = PCU_Comm_Sender();
+  Unpacker u;
   int type;
-  PCU_COMM_UNPACK(type);
+  u.unpack(type);
   MeshEntity* sender;
   ModelEntity* c;
   Parts residence;
-  unpackCommon(m,sender,c,residence);
+  unpackCommon(m,u,sender,c,residence);
   MeshEntity* entity;
   if (type == Mesh::VERTEX)
-    entity = unpackVertex(m,c);
+    entity = unpackVertex(m,u,c);
   else
-    entity = unpackNonVertex(m,type,c);
+    entity = unpackNonVertex(m,u,type,c);
   m->setResidence(entity,residence);
-  unpackTags(m,entity,tags);
-  Copies remotes;
+  unpackTags(m,u,entity,tags);
+  u.extract();
   /* temporarily store the sender as
      the only remote copy */
   m->addRemote(entity, from, sender);
@@ -838,9 +1009,17 @@ void deleteOldEntities(
     }
 }
 
+static size_t migratedElements = 0;
+
+size_t countMigratedElements()
+{
+  return migratedElements;
+}
+
 /* this is the main migration routine */
 static void migrate1(Mesh2* m, Migration* plan)
 {
+  migratedElements += plan->count();
   EntityVector affected[4];
   getAffected(m,plan,affected);
   EntityVector senders[4];
@@ -30,6 +30,114 @@ void EntityShape::alignSharedNodes(Mesh* m,
   fail("unimplemented alignSharedNodes\n");
 }
 
+void EntityShape::getValuesAtPoints(Mesh* m, MeshEntity* e,
+    int n, Vector3 const* xi, double* values) const
+{
+  int nen = countNodes();
+  NewArray<double> v;
+  for (int i = 0; i < n; ++i) {
+    getValues(m, e, xi[i], v);
+    for (int j = 0; j < nen; ++j)
+      values[i * nen + j] = v[j];
+  }
+}
+
+void EntityShape::getLocalGradientsAtPoints(Mesh* m, MeshEntity* e,
+    int n, Vector3 const* xi, Vector3* grads) const
+{
+  int nen = countNodes();
+  NewArray<Vector3> g;
+  for (int i = 0; i < n; ++i) {
+    getLocalGradients(m, e, xi[i], g);
+    /* vertices have no gradients to give */
+    for (int j = 0; j < nen; ++j)
+      grads[i * nen + j] = j < (int)g.size() ? g[j] : Vector3(0,0,0);
+  }
+}
+
+bool EntityShape::hasFixedValues() const
+{
+  return false;
+}
+
+ShapeTable::ShapeTable(EntityShape* s, Integration const* in)
+{
+  np = in->countPoints();
+  nen = s->countNodes();
+  NewArray<Vector3> xi(np);
+  for (int i = 0; i < np; ++i)
+    xi[i] = in->getPoint(i)->param;
+  values.allocate(np * nen);
+  grads.allocate(np * nen);
+  s->getValuesAtPoints(0, 0, np, &xi[0], &values[0]);
+  s->getLocalGradientsAtPoints(0, 0, np, &xi[0], &grads[0]);
+}
+
+namespace {
+
+struct ShapeTableKey
+{
+  FieldShape* shape;
+  int shapeOrder;
+  int type;
+  int order;
+  bool operator<(ShapeTableKey const& o) const
+  {
+    if (shape != o.shape) return shape < o.shape;
+    if (shapeOrder != o.shapeOrder) return shapeOrder < o.shapeOrder;
+    if (type != o.type) return type < o.type;
+    return order < o.order;
+  }
+};
+
+/* these live until the program exits */
+class ShapeTables
+{
+  public:
+    ~ShapeTables()
+    {
+      std::map<ShapeTableKey, ShapeTable*>::iterator it;
+      for (it = tables.begin(); it != tables.end(); ++it)
+        delete it->second;
+    }
+    std::map<ShapeTableKey, ShapeTable*> tables;
+};
+
+ShapeTables shapeTables;
+
+ShapeTable* findShapeTable(ShapeTableKey const& key, EntityShape* es)
+{
+  std::map<ShapeTableKey, ShapeTable*>& tables = shapeTables.tables;
+  std::map<ShapeTableKey, ShapeTable*>::iterator it = tables.find(key);
+  if (it != tables.end())
+    return it->second;
+  EntityIntegration const* ei = getIntegration(key.type);
+  Integration const* in = ei ? ei->getAccurate(key.order) : 0;
+  if (!in)
+    return 0;
+  ShapeTable* t = new ShapeTable(es, in);
+  tables[key] = t;
+  return t;
+}
+
+}
+
+ShapeTable const* getShapeTable(FieldShape* s, int type, int order)
+{
+  EntityShape* es = s->getEntityShape(type);
+  if (!es || !es->hasFixedValues())
+    return 0;
+  /* shapes such as crv::getBezier change order in place */
+  ShapeTableKey key = {s, s->getOrder(), type, order};
+  ShapeTable* t;
+  /* threads such as those of spr::setThreads come here at once */
+#ifdef _OPENMP
+#pragma omp critical (apf_shape_tables)
+#endif
+  t = findShapeTable(key, es);
+  return t;
+}
+
 FieldShape::~FieldShape()
 {
 }
@@ -86,6 +194,7 @@ class Linear : public FieldShape
             Vector3 const&, NewArray<Vector3>&) const
         {
         }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 1;}
     };
     class Edge : public EntityShape
@@ -105,6 +214,23 @@ class Linear : public FieldShape
           grads[0] = Vector3(-0.5,0,0);
           grads[1] = Vector3( 0.5,0,0);
         }
+        void getValuesAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, double* values) const
+        {
+          for (int i = 0; i < n; ++i) {
+            values[2 * i + 0] = (1.0 - xi[i][0]) / 2.0;
+            values[2 * i + 1] = (1.0 + xi[i][0]) / 2.0;
+          }
+        }
+        void getLocalGradientsAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const*, Vector3* grads) const
+        {
+          for (int i = 0; i < n; ++i) {
+            grads[2 * i + 0] = Vector3(-0.5,0,0);
+            grads[2 * i + 1] = Vector3( 0.5,0,0);
+          }
+        }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 2;}
     };
     class Triangle : public EntityShape
@@ -126,6 +252,25 @@ class Linear : public FieldShape
           grads[1] = Vector3( 1, 0,0);
           grads[2] = Vector3( 0, 1,0);
         }
+        void getValuesAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, double* values) const
+        {
+          for (int i = 0; i < n; ++i) {
+            values[3 * i + 0] = 1 - xi[i][0] - xi[i][1];
+            values[3 * i + 1] = xi[i][0];
+            values[3 * i + 2] = xi[i][1];
+          }
+        }
+        void getLocalGradientsAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const*, Vector3* grads) const
+        {
+          for (int i = 0; i < n; ++i) {
+            grads[3 * i + 0] = Vector3(-1,-1,0);
+            grads[3 * i + 1] = Vector3( 1, 0,0);
+            grads[3 * i + 2] = Vector3( 0, 1,0);
+          }
+        }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 3;}
     };
     class Quad : public EntityShape
@@ -158,6 +303,7 @@ class Linear : public FieldShape
           grads[2] = Vector3( l1y, l1x,0)/4;
           grads[3] = Vector3(-l1y, l0x,0)/4;
         }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 4;}
     };
     class Tetrahedron : public EntityShape
@@ -181,6 +327,27 @@ class Linear : public FieldShape
           grads[2] = Vector3( 0, 1, 0);
           grads[3] = Vector3( 0, 0, 1);
         }
+        void getValuesAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, double* values) const
+        {
+          for (int i = 0; i < n; ++i) {
+            values[4 * i + 0] = 1 - xi[i][0] - xi[i][1] - xi[i][2];
+            values[4 * i + 1] = xi[i][0];
+            values[4 * i + 2] = xi[i][1];
+            values[4 * i + 3] = xi[i][2];
+          }
+        }
+        void getLocalGradientsAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const*, Vector3* grads) const
+        {
+          for (int i = 0; i < n; ++i) {
+            grads[4 * i + 0] = Vector3(-1,-1,-1);
+            grads[4 * i + 1] = Vector3( 1, 0, 0);
+            grads[4 * i + 2] = Vector3( 0, 1, 0);
+            grads[4 * i + 3] = Vector3( 0, 0, 1);
+          }
+        }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 4;}
     };
     class Prism : public EntityShape
@@ -228,6 +395,7 @@ class Linear : public FieldShape
           grads[4] = tg[1] * up   + eg[1] * nt[1];
           grads[5] = tg[2] * up   + eg[1] * nt[2];
         }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 6;}
     };
     class Pyramid : public EntityShape
@@ -265,6 +433,7 @@ class Linear : public FieldShape
           grads[3] = Vector3(-l1y * l0z,  l0x * l0z, -l0x * l1y) / 8;
           grads[4] = Vector3(0,0,0.5);
         }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 5;}
     };
     class Hexahedron : public EntityShape
@@ -309,6 +478,7 @@ class Linear : public FieldShape
           grads[6] = Vector3( l1y * l1z,  l1x * l1z,  l1x * l1y) / 8;
           grads[7] = Vector3(-l1y * l1z,  l0x * l1z,  l0x * l1y) / 8;
         }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 8;}
     };
     EntityShape* getEntityShape(int type)
@@ -376,6 +546,17 @@ class QuadraticBase : public FieldShape
           grads[1] = Vector3((2*xi[0]+1)/2.0,0,0);
           grads[2] = Vector3(-2*xi[0],0,0);
         }
+        void getValuesAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, double* values) const
+        {
+          for (int i = 0; i < n; ++i) {
+            double x = xi[i][0];
+            values[3 * i + 0] = -x*(1-x)/2.0;
+            values[3 * i + 1] =  x*(1+x)/2.0;
+            values[3 * i + 2] = 1-x*x;
+          }
+        }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 3;}
     };
     class Triangle : public EntityShape
@@ -406,6 +587,39 @@ class QuadraticBase : public FieldShape
           grads[4] = Vector3(4*xi[1],4*xi[0],0);
           grads[5] = Vector3(-4*xi[1],4*(xi2-xi[1]),0);
         }
+        void getValuesAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, double* values) const
+        {
+          for (int i = 0; i < n; ++i) {
+            double x0 = xi[i][0];
+            double x1 = xi[i][1];
+            double x2 = 1-x0-x1;
+            double* v = values + 6 * i;
+            v[0] = x2*(2*x2-1);
+            v[1] = x0*(2*x0-1);
+            v[2] = x1*(2*x1-1);
+            v[3] = 4*x0*x2;
+            v[4] = 4*x0*x1;
+            v[5] = 4*x1*x2;
+          }
+        }
+        void getLocalGradientsAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, Vector3* grads) const
+        {
+          for (int i = 0; i < n; ++i) {
+            double x0 = xi[i][0];
+            double x1 = xi[i][1];
+            double x2 = 1-x0-x1;
+            Vector3* g = grads + 6 * i;
+            g[0] = Vector3(-4*x2+1,-4*x2+1,0);
+            g[1] = Vector3(4*x0-1,0,0);
+            g[2] = Vector3(0,4*x1-1,0);
+            g[3] = Vector3(4*(x2-x0),-4*x0,0);
+            g[4] = Vector3(4*x1,4*x0,0);
+            g[5] = Vector3(-4*x1,4*(x2-x1),0);
+          }
+        }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 6;}
     };
     class Tetrahedron : public EntityShape
@@ -445,6 +659,50 @@ class QuadraticBase : public FieldShape
           grads[8] = Vector3(4*xi[2],0,4*xi[0]);
           grads[9] = Vector3(0,4*xi[2],4*xi[1]);
         }
+        void getValuesAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, double* values) const
+        {
+          for (int i = 0; i < n; ++i) {
+            double x0 = xi[i][0];
+            double x1 = xi[i][1];
+            double x2 = xi[i][2];
+            double x3 = 1-x0-x1-x2;
+            double* v = values + 10 * i;
+            v[0] = x3*(2*x3-1);
+            v[1] = x0*(2*x0-1);
+            v[2] = x1*(2*x1-1);
+            v[3] = x2*(2*x2-1);
+            v[4] = 4*x0*x3;
+            v[5] = 4*x0*x1;
+            v[6] = 4*x1*x3;
+            v[7] = 4*x2*x3;
+            v[8] = 4*x2*x0;
+            v[9] = 4*x1*x2;
+          }
+        }
+        void getLocalGradientsAtPoints(Mesh*, MeshEntity*,
+            int n, Vector3 const* xi, Vector3* grads) const
+        {
+          for (int i = 0; i < n; ++i) {
+            double x0 = xi[i][0];
+            double x1 = xi[i][1];
+            double x2 = xi[i][2];
+            double x3 = 1-x0-x1-x2;
+            double d3 = 1-4*x3;
+            Vector3* g = grads + 10 * i;
+            g[0] = Vector3(d3,d3,d3);
+            g[1] = Vector3(4*x0-1,0,0);
+            g[2] = Vector3(0,4*x1-1,0);
+            g[3] = Vector3(0,0,4*x2-1);
+            g[4] = Vector3(4*x3-4*x0,-4*x0,-4*x0);
+            g[5] = Vector3(4*x1,4*x0,0);
+            g[6] = Vector3(-4*x1,4*x3-4*x1,-4*x1);
+            g[7] = Vector3(-4*x2,-4*x2,4*x3-4*x2);
+            g[8] = Vector3(4*x2,0,4*x0);
+            g[9] = Vector3(0,4*x2,4*x1);
+          }
+        }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 10;}
     };
     EntityShape* getEntityShape(int type)
@@ -544,6 +802,7 @@ class LagrangeQuadratic : public QuadraticBase
               -2.0*e*(1-(n*n)),
               -2.0*n*(1-(e*e)), 0.0);
         }
+        bool hasFixedValues() const {return true;}
         int countNodes() const {return 9;}
     };
     EntityShape* getEntityShape(int type)
@@ -616,6 +875,7 @@ class SerendipityQuadratic : public QuadraticBase
         grads[6] = Vector3(-xi[0] - xi[0]*xi[1],  0.5 - xi[0]*xi[0]/2.0, 0.0);
         grads[7] = Vector3(xi[1]*xi[1]/2.0 - 0.5,   xi[0]*xi[1] - xi[1], 0.0);
       }
+      bool hasFixedValues() const {return true;}
       int countNodes() const {return 8;}
     };
     EntityShape* getEntityShape(int type)
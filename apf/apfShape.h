@@ -19,6 +19,7 @@ namespace apf {
 
 class Mesh;
 class MeshEntity;
+class Integration;
 
 /** \brief Shape functions over this element */
 class EntityShape
@@ -42,6 +43,32 @@ class EntityShape
         MeshEntity* e,
         Vector3 const& xi,
         NewArray<Vector3>& grads) const = 0;
+/** \brief evaluate element shape functions at several points
+ \param n the number of points
+ \param xi the parent element coordinates of each point
+ \param values the values at the first point, followed by those at
+               the second point, etc., (n * countNodes()) in all.
+ \details the default calls getValues once per point;
+          shapes override it to evaluate all points in one loop */
+    virtual void getValuesAtPoints(
+        Mesh* m,
+        MeshEntity* e,
+        int n,
+        Vector3 const* xi,
+        double* values) const;
+/** \brief evaluate element shape function gradients at several points
+ \details the layout follows apf::EntityShape::getValuesAtPoints */
+    virtual void getLocalGradientsAtPoints(
+        Mesh* m,
+        MeshEntity* e,
+        int n,
+        Vector3 const* xi,
+        Vector3* grads) const;
+/** \brief return true if the values and gradients at a point do not
+           depend on which entity is given
+    \details this allows them to be tabulated once per entity type,
+             see apf::getShapeTable */
+    virtual bool hasFixedValues() const;
 /** \brief return the number of nodes affecting this element
     \details in a linear mesh, there are two nodes affecting
              and edge, three nodes affecting a triangle,
@@ -99,6 +126,44 @@ class FieldShape
     void registerSelf(const char* name);
 };
 
+/** \brief shape function values and gradients tabulated at the
+           points of an integration rule
+  \details the values of all nodes at one point are contiguous,
+           as in apf::EntityShape::getValuesAtPoints */
+class ShapeTable
+{
+  public:
+    ShapeTable(EntityShape* s, Integration const* in);
+    int countPoints() const {return np;}
+    int countNodes() const {return nen;}
+    double const* getValues(int point) const
+    {
+      return &values[point * nen];
+    }
+    Vector3 const* getLocalGradients(int point) const
+    {
+      return &grads[point * nen];
+    }
+  private:
+    int np;
+    int nen;
+    NewArray<double> values;
+    NewArray<Vector3> grads;
+};
+
+/** \brief get the shape functions of an entity type tabulated at
+           the integration points of some order
+  \details the points are those of
+           apf::getIntegration(type)->getAccurate(order).
+           Tables are built on first use and kept until the program
+           exits. Threads may call this at the same time, though
+           each call takes a lock, so loops over elements should
+           look the tables up once per type before they start.
+           Zero is returned if the shapes of this type do not have
+           fixed values (apf::EntityShape::hasFixedValues) or
+           there is no integration of this order. */
+ShapeTable const* getShapeTable(FieldShape* s, int type, int order);
+
 /** \brief Get the Lagrangian shape function of some polynomial order
  \details we have only first and second order so far */
 FieldShape* getLagrange(int order);
@@ -57,6 +57,26 @@ MeshTag* TagData::makeOrFindTag(const char* name, int size)
   return maker->make(mesh,name,size);
 }
 
+/* the tag array of the only type of dimension (dim) that
+   has entities, if the entities [begin,end) have nodes of this field */
+void* TagData::getArray(int dim, std::size_t begin, std::size_t end,
+    bool give, int& type)
+{
+  std::size_t total = mesh->count(dim);
+  for (type = Mesh::VERTEX; type < Mesh::TYPES; ++type) {
+    if (Mesh::typeDimension[type] != dim || !tags[type])
+      continue;
+    std::size_t count;
+    void* a = mesh->getTagArray(tags[type], type, begin, end, give,
+        count);
+    if (count == total)
+      return a;
+    if (count)
+      return 0;
+  }
+  return 0;
+}
+
 static const char* typePostfix[Mesh::TYPES] =
 {"ver","edg","tri","qua","tet","hex","pri","pyr"};
 
@@ -9,6 +9,7 @@
 #define APFTAGDATA_H
 
 #include "apfFieldData.h"
+#include <algorithm>
 
 namespace apf {
 
@@ -89,6 +90,8 @@ class TagData
     void removeEntity(MeshEntity* e);
     MeshTag* getTag(MeshEntity* e);
     MeshTag* makeOrFindTag(const char* name, int size);
+    void* getArray(int dim, std::size_t begin, std::size_t end,
+        bool give, int& type);
     void rename(const char* newName);
   private:
     void createTags(const char* name, int components);
@@ -125,6 +128,28 @@ class TagDataOf : public FieldDataOf<T>
     {
       helper.set(mesh,e,tagData.getTag(e),data);
     }
+    virtual std::size_t getRange(int dim, std::size_t begin,
+        std::size_t end, T* values)
+    {
+      int type;
+      T* a = static_cast<T*>(tagData.getArray(dim, begin, end, false, type));
+      if (!a)
+        return FieldDataOf<T>::getRange(dim, begin, end, values);
+      std::size_t n = this->countValuesOn(type);
+      std::copy(a + begin * n, a + end * n, values);
+      return (end - begin) * n;
+    }
+    virtual std::size_t setRange(int dim, std::size_t begin,
+        std::size_t end, T const* values)
+    {
+      int type;
+      T* a = static_cast<T*>(tagData.getArray(dim, begin, end, true, type));
+      if (!a)
+        return FieldDataOf<T>::setRange(dim, begin, end, values);
+      std::size_t n = this->countValuesOn(type);
+      std::copy(values, values + (end - begin) * n, a + begin * n);
+      return (end - begin) * n;
+    }
     virtual bool isFrozen()
     {
       return false;
@@ -138,6 +163,11 @@ class TagDataOf : public FieldDataOf<T>
       tagData.rename(newName);
     }
   private:
+    std::size_t countValuesOn(int type)
+    {
+      FieldBase* f = this->FieldData::field;
+      return f->getShape()->countNodesOn(type) * f->countComponents();
+    }
     Mesh* mesh;
     TagData tagData;
     TagHelper<T> helper;
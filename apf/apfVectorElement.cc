@@ -44,6 +44,13 @@ void VectorElement::curl(Vector3 const& xi, Vector3& c)
 void VectorElement::gradHelper(
     NewArray<Vector3>& nodalGradients,
     Matrix3x3& g)
+{
+  gradHelper(&nodalGradients[0], g);
+}
+
+void VectorElement::gradHelper(
+    Vector3 const* nodalGradients,
+    Matrix3x3& g)
 {
   Vector3* nodeValues = getNodeValues();
   g = tensorProduct(nodalGradients[0],nodeValues[0]);
@@ -65,6 +72,13 @@ void VectorElement::getJacobian(Vector3 const& xi, Matrix3x3& J)
   gradHelper(localGradients,J);
 }
 
+/* for local gradients that were already evaluated,
+   for example from an apf::ShapeTable */
+void VectorElement::getJacobian(Vector3 const* localGradients, Matrix3x3& J)
+{
+  gradHelper(localGradients,J);
+}
+
 double getJacobianDeterminant(Matrix3x3 const& J, int dimension)
 {
   if (dimension == 3)
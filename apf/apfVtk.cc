@@ -17,8 +17,16 @@
 #include <fstream>
 #include <pcu_util.h>
 #include <cstdlib>
+#include <cerrno>
+#include <algorithm>
 #include <stdint.h>
+#include <string.h>
 #include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // === includes for safe_mkdir ===
 #include <reel.h>
@@ -86,21 +94,24 @@ static void describeArray(
     std::ostream& file,
     const char* name,
     int type,
-    int size,
-    bool isWritingBinary = false)
+    int size)
 {
   file << "type=\"";
   const char* typeNames[3] = {"Float64","Int32","Int64"};
   file << typeNames[type];
   file << "\" Name=\"" << name;
-  file << "\" NumberOfComponents=\"" << size;
+  file << "\" NumberOfComponents=\"" << size << '"';
+}
+
+static void describeFormat(std::ostream& file, bool isWritingBinary)
+{
   if (isWritingBinary)
   {
-    file << "\" format=\"binary\"";
+    file << " format=\"binary\"";
   }
   else
   {
-    file << "\" format=\"ascii\"";
+    file << " format=\"ascii\"";
   }
 }
 
@@ -112,7 +123,8 @@ static void writePDataArray(
     bool isWritingBinary = false)
 {
   file << "<PDataArray ";
-  describeArray(file,name,type,size,isWritingBinary);
+  describeArray(file,name,type,size);
+  describeFormat(file,isWritingBinary);
   file << "/>\n";
 }
 
@@ -125,8 +137,8 @@ static void writePDataArray(
   describeArray(file,
       f->getName(),
       f->getScalarType(),
-      f->countComponents(),
-      isWritingBinary);
+      f->countComponents());
+  describeFormat(file,isWritingBinary);
   file << "/>\n";
 }
 
@@ -306,48 +318,312 @@ static void writePvtuFile(const char* prefix,
   file << "</VTKFile>\n";
 }
 
-static void writeDataHeader(std::ostream& file,
+/* one piece of a .vtu file: the text that comes before
+   an array and the array itself, if any */
+struct VtuChunk
+{
+  std::string text;
+  char* data;
+  unsigned long bytes;
+  std::vector<char> header;
+  std::vector<char> body;
+  char ready;
+};
+
+/* compressed arrays are split into blocks of this size,
+   which are compressed in parallel */
+static unsigned long const compressionBlockSize = 1 << 18;
+
+static void compressBlock(char* out, unsigned long outLen,
+    const char* in, unsigned long len, long* compressedLen)
+{
+  lion::compress(out, outLen, in, len);
+  *compressedLen = outLen;
+}
+
+static void compressChunk(VtuChunk* c)
+{
+  //build the data header and compress the data
+  unsigned long nblocks = 1;
+  if (c->bytes > compressionBlockSize)
+    nblocks = (c->bytes + compressionBlockSize - 1) / compressionBlockSize;
+  unsigned long blockSize = nblocks == 1 ? c->bytes : compressionBlockSize;
+  std::vector<long> lensToEncode(3 + nblocks);
+  lensToEncode[0] = nblocks; //number of blocks
+  lensToEncode[1] = blockSize; //size of each block before compression
+  lensToEncode[2] = c->bytes - (nblocks - 1) * blockSize;
+      //size of the final block before compression
+  unsigned long slot = lion::compressBound(blockSize);
+  c->body.resize(nblocks * slot);
+  for (unsigned long i = 0; i < nblocks; ++i)
+  {
+    char* out = &c->body[i * slot];
+    const char* in = c->data + i * blockSize;
+    unsigned long len = (i + 1 == nblocks) ? lensToEncode[2] : blockSize;
+    long* compressedLen = &lensToEncode[3 + i];
+        //the sizes of the compressed blocks
+#ifdef _OPENMP
+#pragma omp task
+#endif
+    compressBlock(out, slot, in, len, compressedLen);
+  }
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+  //pack the compressed blocks together
+  unsigned long at = 0;
+  for (unsigned long i = 0; i < nblocks; ++i)
+  {
+    memmove(&c->body[at], &c->body[i * slot], lensToEncode[3 + i]);
+    at += lensToEncode[3 + i];
+  }
+  c->body.resize(at);
+  char* h = (char*)&lensToEncode[0];
+  c->header.assign(h, h + lensToEncode.size() * sizeof(long));
+  delete [] c->data;
+  c->data = 0;
+}
+
+static void appendEncoded(std::vector<char>& out,
+    const char* data, unsigned long bytes)
+{
+  std::size_t at = out.size();
+  out.resize(at + lion::base64EncodedLength(bytes));
+  lion::base64Encode(data, bytes, &out[at]);
+}
+
+/* leaves the length header and the (compressed) data in the
+   chunk, base64 encoded unless they are to be appended raw */
+static void encodeChunk(VtuChunk* c, bool isAppending)
+{
+  if (!c->data)
+    return;
+  if ( lion::can_compress )
+    compressChunk(c);
+  else
+  {
+    unsigned int dataLenBytes = c->bytes;
+    char* h = (char*)&dataLenBytes;
+    c->header.assign(h, h + sizeof(dataLenBytes));
+  }
+  if (isAppending)
+    return;
+  const char* body = c->data;
+  unsigned long bodyBytes = c->bytes;
+  if (!body)
+  {
+    body = &c->body[0];
+    bodyBytes = c->body.size();
+  }
+  std::vector<char> encoded;
+  encoded.reserve(lion::base64EncodedLength(c->header.size()) +
+      lion::base64EncodedLength(bodyBytes) + 1);
+  appendEncoded(encoded, &c->header[0], c->header.size());
+  appendEncoded(encoded, body, bodyBytes);
+  encoded.push_back('\n');
+  c->header.swap(encoded);
+  std::vector<char>().swap(c->body);
+  delete [] c->data;
+  c->data = 0;
+}
+
+static void writeAll(int fd, const char* p, std::size_t n)
+{
+  while (n)
+  {
+    ssize_t w = ::write(fd, p, n);
+    if (w < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      reel_fail("apf: could not write vtu file: %s\n", strerror(errno));
+    }
+    p += w;
+    n -= w;
+  }
+}
+
+static unsigned long countChunkBytes(VtuChunk* c)
+{
+  return c->header.size() + c->body.size() + (c->data ? c->bytes : 0);
+}
+
+static void writeChunk(int fd, VtuChunk* c)
+{
+  writeAll(fd, c->text.data(), c->text.size());
+  if (!c->header.empty())
+    writeAll(fd, &c->header[0], c->header.size());
+  if (!c->body.empty())
+    writeAll(fd, &c->body[0], c->body.size());
+  if (c->data)
+    writeAll(fd, c->data, c->bytes);
+  delete [] c->data;
+  delete c;
+}
+
+/* The .vtu piece goes straight to its file descriptor.
+   XML text collects in the stream until an array comes along.
+   The array is then compressed and encoded by an OpenMP task
+   while the next one is gathered, and a second task writes the
+   text and the encoded array after all earlier chunks.
+   Without OpenMP the tasks just run where they are created.
+
+   When appending, the arrays are kept raw until all the XML is
+   out, since their offsets are only known once they have been
+   compressed. The text is kept in segments split where the
+   offsets go. */
+class VtuStream : public std::stringstream
+{
+  public:
+    VtuStream(const char* path, bool isAppending):
+      appending(isAppending),
+      inFlight(0)
+    {
+      fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0)
+        reel_fail("apf: could not open \"%s\": %s\n", path, strerror(errno));
+    }
+    bool isAppending() {return appending;}
+    /* a zeroed buffer which writeArray takes back */
+    template <class T>
+    T* allocate(std::size_t n)
+    {
+      return reinterpret_cast<T*>(new char[n * sizeof(T)]());
+    }
+    template <class T>
+    void writeArray(T* data, std::size_t n)
+    {
+      post(reinterpret_cast<char*>(data), n * sizeof(T));
+    }
+    /* hands the text over to be written once there
+       is enough of it, for ASCII files */
+    void flushText(std::size_t atLeast)
+    {
+      if (!appending && std::size_t(tellp()) >= atLeast)
+        post(0, 0);
+    }
+    /* the offset of the next array goes here */
+    void markOffset()
+    {
+      segments.push_back(str());
+      str("");
+    }
+    /* writes the XML so far with the array offsets filled in,
+       then the <AppendedData> section */
+    void writeAppendedData()
+    {
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+      PCU_ALWAYS_ASSERT(segments.size() == appended.size());
+      unsigned long offset = 0;
+      for (std::size_t i = 0; i < segments.size(); ++i)
+      {
+        std::stringstream ss;
+        ss << offset;
+        segments[i] += ss.str();
+        writeAll(fd, segments[i].data(), segments[i].size());
+        offset += countChunkBytes(appended[i]);
+      }
+      std::vector<std::string>().swap(segments);
+      *this << "<AppendedData encoding=\"raw\">\n_";
+      std::string text = str();
+      str("");
+      writeAll(fd, text.data(), text.size());
+      for (std::size_t i = 0; i < appended.size(); ++i)
+        writeChunk(fd, appended[i]);
+      appended.clear();
+      *this << "\n</AppendedData>\n";
+    }
+    /* waits for all chunks to be written and closes the file */
+    void close()
+    {
+      post(0, 0);
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+      if (::close(fd) != 0)
+        reel_fail("apf: could not close vtu file: %s\n", strerror(errno));
+    }
+  private:
+    void post(char* data, unsigned long bytes)
+    {
+      VtuChunk* c = new VtuChunk();
+      c->data = data;
+      c->bytes = bytes;
+      if (appending && data)
+      {
+#ifdef _OPENMP
+#pragma omp task firstprivate(c)
+#endif
+        encodeChunk(c, true);
+        appended.push_back(c);
+        return;
+      }
+      c->text = str();
+      str("");
+      char* ready = &c->ready;
+      char* order = &writeOrder;
+      int f = fd;
+      (void)ready;
+      (void)order;
+#ifdef _OPENMP
+#pragma omp task firstprivate(c) depend(out: ready[0])
+#endif
+      encodeChunk(c, false);
+#ifdef _OPENMP
+#pragma omp task firstprivate(c, f) depend(in: ready[0]) depend(inout: order[0])
+#endif
+      writeChunk(f, c);
+      /* bound the memory held by arrays waiting to be written */
+      if (++inFlight == maxInFlight)
+      {
+#ifdef _OPENMP
+#pragma omp taskwait
+#endif
+        inFlight = 0;
+      }
+    }
+    enum { maxInFlight = 8 };
+    int fd;
+    bool appending;
+    int inFlight;
+    char writeOrder;
+    std::vector<std::string> segments;
+    std::vector<VtuChunk*> appended;
+};
+
+/* appended arrays are described by their offset
+   into the <AppendedData> section */
+static void writeFormat(VtuStream& file, bool isWritingBinary)
+{
+  if (isWritingBinary && file.isAppending())
+  {
+    file << " format=\"appended\" offset=\"";
+    file.markOffset();
+    file << '"';
+  }
+  else
+    describeFormat(file, isWritingBinary);
+}
+
+static void writeDataHeader(VtuStream& file,
     const char* name,
     int type,
     int size,
     bool isWritingBinary = false)
 {
   file << "<DataArray ";
-  describeArray(file,name,type,size,isWritingBinary);
+  describeArray(file,name,type,size);
+  writeFormat(file,isWritingBinary);
   file << ">\n";
 }
 
-static void writeEncodedArray(std::ostream& file,
-    unsigned int dataLenBytes,
-    char* dataToEncode)
+static void writeDataFooter(VtuStream& file)
 {
-  if ( lion::can_compress )
-  {
-    //build the data header and compress dataToEncode
-    long lensToEncode[4];
-    lensToEncode[0] = 1; //data is compressed in one block
-    lensToEncode[1] = dataLenBytes; //size of each block before compression
-    lensToEncode[2] = dataLenBytes; //size of the final block before compression
-    unsigned long dataCompressedLen = lion::compressBound(dataLenBytes);
-        //gets the size to allocate for the compressed data array
-    char* dataCompressed = new char[dataCompressedLen]();
-    lion::compress( (void*)dataCompressed,
-        dataCompressedLen,
-        (void*)dataToEncode,
-        dataLenBytes);
-        //compresses and sets dataCompressedLen to the size of the correct length
-    lensToEncode[3] = dataCompressedLen; //size of the compressed block
-    //encode and output the compressed data
-    file << lion::base64Encode( (char*)lensToEncode, sizeof(lensToEncode) );
-    file << lion::base64Encode( dataCompressed, dataCompressedLen ) << '\n';
-    delete[] dataCompressed;
-  }
-  else
-  {
-    //not compressing, encode and output
-    file << lion::base64Encode( (char*)&dataLenBytes, sizeof(dataLenBytes) );
-    file << lion::base64Encode( dataToEncode, dataLenBytes ) << '\n';
-  }
+  file << "</DataArray>\n";
+  /* ASCII arrays are written out as they come */
+  file.flushText(1 << 22);
 }
 
 /* Paraview/VTK has trouble with sub-normal double precision floating point
@@ -372,50 +648,53 @@ static long workaround(long v)
   return v;
 }
 
+/* the nodes come from an overlap numbering of the field's own shape,
+   so they list every node of each dimension in iteration order,
+   which is what FieldDataOf::getRange produces */
 template <class T>
-static void writeNodalField(std::ostream& file,
+static void getNodalData(FieldBase* f, DynamicArray<Node>& nodes, T* values)
+{
+  Mesh* m = f->getMesh();
+  FieldShape* s = f->getShape();
+  FieldDataOf<T>* data = static_cast<FieldDataOf<T>*>(f->getData());
+  std::size_t n = 0;
+  for (int d = 0; d < 4; ++d)
+    if (s->hasNodesIn(d))
+      n += data->getRange(d, 0, m->count(d), values + n);
+  PCU_ALWAYS_ASSERT(n == nodes.getSize() * f->countComponents());
+}
+
+template <class T>
+static void writeNodalField(VtuStream& file,
     FieldBase* f,
     DynamicArray<Node>& nodes,
     bool isWritingBinary = false)
 {
   int nc = f->countComponents();
   writeDataHeader(file,f->getName(),f->getScalarType(),nc,isWritingBinary);
-  NewArray<T> nodalData(nc);
-  FieldDataOf<T>* data = static_cast<FieldDataOf<T>*>(f->getData());
+  unsigned int dataLen = nc * nodes.getSize();
+  T* nodalData = file.allocate<T>(dataLen);
+  getNodalData(f, nodes, nodalData);
   if (isWritingBinary)
   {
-    unsigned int dataLen = nc * nodes.getSize();
-    unsigned int dataLenBytes = dataLen*sizeof(T);
-    T* dataToEncode = new T[dataLen]();
-    unsigned int dataIndex = 0;
-    for (size_t i = 0; i < nodes.getSize(); ++i)
-    {
-      data->getNodeComponents(nodes[i].entity,nodes[i].node,&(nodalData[0]));
-      for (int j = 0; j < nc; ++j)
-      {
-        dataToEncode[dataIndex] = nodalData[j];
-        dataIndex++;
-      }
-    }
-    writeEncodedArray(file, dataLenBytes, (char*)dataToEncode);
-    delete [] dataToEncode;
+    file.writeArray(nodalData, dataLen);
   }
   else
   {
     for (size_t i = 0; i < nodes.getSize(); ++i)
     {
-      data->getNodeComponents(nodes[i].entity,nodes[i].node,&(nodalData[0]));
       for (int j = 0; j < nc; ++j)
       {
-        file << workaround(nodalData[j]) << ' ';
+        file << workaround(nodalData[i * nc + j]) << ' ';
       }
       file << '\n';
     }
+    delete [] reinterpret_cast<char*>(nodalData);
   }
-  file << "</DataArray>\n";
+  writeDataFooter(file);
 }
 
-static void writePoints(std::ostream& file,
+static void writePoints(VtuStream& file,
     Mesh* m,
     DynamicArray<Node>& nodes,
     bool isWritingBinary = false)
@@ -430,20 +709,13 @@ static int countElementNodes(Numbering* n, MeshEntity* e)
   return n->getShape()->getEntityShape(n->getMesh()->getType(e))->countNodes();
 }
 
-static void writeConnectivity(std::ostream& file,
+static void writeConnectivity(VtuStream& file,
     Numbering* n,
     bool isWritingBinary,
     int cellDim)
 {
   file << "<DataArray type=\"Int32\" Name=\"connectivity\"";
-  if (isWritingBinary)
-  {
-    file << " format=\"binary\"";
-  }
-  else
-  {
-    file << " format=\"ascii\"";
-  }
+  writeFormat(file, isWritingBinary);
   file << ">\n";
   Mesh* m = n->getMesh();
   MeshEntity* e;
@@ -456,8 +728,7 @@ static void writeConnectivity(std::ostream& file,
       dataLen += countElementNodes(n,e);
     }
     m->end(elements);
-    unsigned int dataLenBytes = dataLen*sizeof(int);
-    int* dataToEncode = new int[dataLen]();
+    int* dataToEncode = file.allocate<int>(dataLen);
     elements = m->begin(cellDim);
     unsigned int dataIndex = 0;
     while ((e = m->iterate(elements)))
@@ -472,8 +743,7 @@ static void writeConnectivity(std::ostream& file,
       }
     }
     m->end(elements);
-    writeEncodedArray(file, dataLenBytes, (char*)dataToEncode);
-    delete [] dataToEncode;
+    file.writeArray(dataToEncode, dataLen);
   }
   else
   {
@@ -491,23 +761,16 @@ static void writeConnectivity(std::ostream& file,
     }
     m->end(elements);
   }
-  file << "</DataArray>\n";
+  writeDataFooter(file);
 }
 
-static void writeOffsets(std::ostream& file,
+static void writeOffsets(VtuStream& file,
     Numbering* n,
     bool isWritingBinary,
     int cellDim)
 {
   file << "<DataArray type=\"Int32\" Name=\"offsets\"";
-  if (isWritingBinary)
-  {
-    file << " format=\"binary\"";
-  }
-  else
-  {
-    file << " format=\"ascii\"";
-  }
+  writeFormat(file, isWritingBinary);
   file << ">\n";
   Mesh* m = n->getMesh();
   MeshEntity* e;
@@ -520,8 +783,7 @@ static void writeOffsets(std::ostream& file,
       dataLen++;
     }
     m->end(elements);
-    unsigned int dataLenBytes = dataLen*sizeof(int);
-    int* dataToEncode = new int[dataLen]();
+    int* dataToEncode = file.allocate<int>(dataLen);
     elements = m->begin(cellDim);
     unsigned int dataIndex = 0;
     int offset = 0;
@@ -532,8 +794,7 @@ static void writeOffsets(std::ostream& file,
       dataIndex++;
     }
     m->end(elements);
-    writeEncodedArray(file, dataLenBytes, (char*)dataToEncode);
-    delete [] dataToEncode;
+    file.writeArray(dataToEncode, dataLen);
   }
   else
   {
@@ -546,23 +807,16 @@ static void writeOffsets(std::ostream& file,
     }
     m->end(elements);
   }
-  file << "</DataArray>\n";
+  writeDataFooter(file);
 }
 
-static void writeTypes(std::ostream& file,
+static void writeTypes(VtuStream& file,
     Mesh* m,
     bool isWritingBinary,
     int cellDim)
 {
   file << "<DataArray type=\"UInt8\" Name=\"types\"";
-  if (isWritingBinary)
-  {
-    file << " format=\"binary\"";
-  }
-  else
-  {
-    file << " format=\"ascii\"";
-  }
+  writeFormat(file, isWritingBinary);
   file << ">\n";
   MeshEntity* e;
   int order = m->getShape()->getOrder();
@@ -588,8 +842,7 @@ static void writeTypes(std::ostream& file,
       dataLen++;
     }
     m->end(elements);
-    unsigned int dataLenBytes = dataLen*sizeof(uint8_t);
-    uint8_t* dataToEncode = new uint8_t[dataLen]();
+    uint8_t* dataToEncode = file.allocate<uint8_t>(dataLen);
     elements = m->begin(cellDim);
     unsigned int dataIndex = 0;
     while ((e = m->iterate(elements)))
@@ -598,8 +851,7 @@ static void writeTypes(std::ostream& file,
       dataIndex++;
     }
     m->end(elements);
-    writeEncodedArray(file, dataLenBytes, (char*)dataToEncode);
-    delete [] dataToEncode;
+    file.writeArray(dataToEncode, dataLen);
   }
   else
   {
@@ -610,10 +862,10 @@ static void writeTypes(std::ostream& file,
     }
     m->end(elements);
   }
-  file << "</DataArray>\n";
+  writeDataFooter(file);
 }
 
-static void writeCells(std::ostream& file,
+static void writeCells(VtuStream& file,
     Numbering* n,
     bool isWritingBinary,
     int cellDim)
@@ -625,7 +877,7 @@ static void writeCells(std::ostream& file,
   file << "</Cells>\n";
 }
 
-static void writePointData(std::ostream& file,
+static void writePointData(VtuStream& file,
     Mesh* m,
     DynamicArray<Node>& nodes,
     std::vector<std::string> writeFields,
@@ -668,7 +920,7 @@ class WriteIPField : public FieldOp
     NewArray<T> ipData;
     FieldDataOf<T>* data;
     MeshEntity* entity;
-    std::ostream* fp;
+    VtuStream* fp;
     bool isWritingBinary;
     int cellDim;
 
@@ -722,24 +974,20 @@ class WriteIPField : public FieldOp
         Mesh* m = f->getMesh();
         int arraySize = m->count(cellDim)*components;
 
-        dataToEncode = new T[arraySize](); //allocate space for array
+        dataToEncode = fp->allocate<T>(arraySize); //allocate space for array
         apply(f); //populate array
 
-        //encode and write to file
-        int dataLenBytes = arraySize * sizeof(T);
-        writeEncodedArray( (*fp), dataLenBytes, (char*)dataToEncode);
-
-        //free array
-        delete [] dataToEncode;
+        //the stream encodes, writes and frees the array
+        fp->writeArray(dataToEncode, arraySize);
         dataIndex = 0;
       }
       else
       {
         apply(f); //same function call if writing ASCII
       }
-      (*fp) << "</DataArray>\n";
+      writeDataFooter(*fp);
     }
-    void run(std::ostream& file,
+    void run(VtuStream& file,
       FieldBase* f,
       bool isWritingBinaryArg,
       int cellDimArg)
@@ -756,7 +1004,7 @@ class WriteIPField : public FieldOp
     }
 };
 
-static void writeCellParts(std::ostream& file,
+static void writeCellParts(VtuStream& file,
     Mesh* m,
     bool isWritingBinary,
     int cellDim)
@@ -766,16 +1014,12 @@ static void writeCellParts(std::ostream& file,
   int id = m->getId();
   if (isWritingBinary)
   {
-    unsigned int dataLen = n;
-    unsigned int dataLenBytes = dataLen*sizeof(int);
-    int* dataToEncode = new int[dataLen]();
+    int* dataToEncode = file.allocate<int>(n);
     for (size_t i = 0; i < n; ++i )
     {
       dataToEncode[i] = id;
     }
-    writeEncodedArray(file, dataLenBytes, (char*)dataToEncode);
-    file << "</DataArray>\n";
-    delete [] dataToEncode;
+    file.writeArray(dataToEncode, n);
   }
   else
   {
@@ -783,11 +1027,11 @@ static void writeCellParts(std::ostream& file,
     {
       file << id << '\n';
     }
-    file << "</DataArray>\n";
   }
+  writeDataFooter(file);
 }
 
-static void writeCellData(std::ostream& file,
+static void writeCellData(VtuStream& file,
     Mesh* m,
     std::vector<std::string> writeFields,
     bool isWritingBinary,
@@ -845,68 +1089,94 @@ static std::string getFileNameAndPathVtu(const char* prefix,
   return ss.str();
 }
 
+/* the cores of a node are shared by the parts on it, so each
+   part writes with its share of them. This is collective. */
+static int getWriterThreads()
+{
+#ifdef _OPENMP
+  MPI_Comm node;
+  MPI_Comm_split_type(PCU_Get_Comm(), MPI_COMM_TYPE_SHARED, 0,
+      MPI_INFO_NULL, &node);
+  int partsOnNode;
+  MPI_Comm_size(node, &partsOnNode);
+  MPI_Comm_free(&node);
+  int threads = omp_get_num_procs() / partsOnNode;
+  return std::max(1, std::min(threads, omp_get_max_threads()));
+#else
+  return 1;
+#endif
+}
+
 static void writeVtuFile(const char* prefix,
     Numbering* n,
     std::vector<std::string> writeFields,
     bool isWritingBinary,
-    int cellDim)
+    int cellDim,
+    int threads,
+    bool isAppending = false)
 {
   double t0 = PCU_Time();
   std::string fileName = getPieceFileName(PCU_Comm_Self());
   std::string fileNameAndPath = getFileNameAndPathVtu(prefix, fileName, PCU_Comm_Self());
-  std::stringstream buf;
+  VtuStream file(fileNameAndPath.c_str(), isAppending);
   Mesh* m = n->getMesh();
+  double t1 = t0;
+  /* one thread gathers arrays while the rest of the team
+     encodes and writes the ones already gathered */
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#pragma omp single
+#else
+  (void)threads;
+#endif
+  {
   DynamicArray<Node> nodes;
   getNodes(n,nodes);
-  buf << "<VTKFile type=\"UnstructuredGrid\"";
+  file << "<VTKFile type=\"UnstructuredGrid\"";
   if (isWritingBinary)
   {
-    buf << " byte_order=";
+    file << " byte_order=";
     if (isBigEndian())
     {
-      buf << "\"BigEndian\"";
+      file << "\"BigEndian\"";
     }
     else
     {
-      buf << "\"LittleEndian\"";
+      file << "\"LittleEndian\"";
     }
     if (lion::can_compress )
     {
       //TODO determine what the header_type should be definitively
-      buf << " header_type=\"UInt64\"";
-      buf << " compressor=\"vtkZLibDataCompressor\"";
+      file << " header_type=\"UInt64\"";
+      file << " compressor=\"vtkZLibDataCompressor\"";
     }
     else
     {
-      buf << " header_type=\"UInt32\"";
+      file << " header_type=\"UInt32\"";
     }
   }
-  buf<< ">\n";
-  buf << "<UnstructuredGrid>\n";
-  buf << "<Piece NumberOfPoints=\"" << nodes.getSize();
-  buf << "\" NumberOfCells=\"" << m->count(cellDim);
-  buf << "\">\n";
-  writePoints(buf,m,nodes,isWritingBinary);
-  writeCells(buf, n, isWritingBinary, cellDim);
-  writePointData(buf,m,nodes,writeFields,isWritingBinary);
-  writeCellData(buf, m, writeFields, isWritingBinary, cellDim);
-  buf << "</Piece>\n";
-  buf << "</UnstructuredGrid>\n";
-  buf << "</VTKFile>\n";
-  double t1 = PCU_Time();
-  if (!PCU_Comm_Self())
-  {
-    printf("writeVtuFile into buffers: %f seconds\n", t1 - t0);
-  }
-  { //block forces std::ofstream destructor call
-    std::ofstream file(fileNameAndPath.c_str());
-    PCU_ALWAYS_ASSERT(file.is_open());
-    file << buf.rdbuf();
+  file<< ">\n";
+  file << "<UnstructuredGrid>\n";
+  file << "<Piece NumberOfPoints=\"" << nodes.getSize();
+  file << "\" NumberOfCells=\"" << m->count(cellDim);
+  file << "\">\n";
+  writePoints(file,m,nodes,isWritingBinary);
+  writeCells(file, n, isWritingBinary, cellDim);
+  writePointData(file,m,nodes,writeFields,isWritingBinary);
+  writeCellData(file, m, writeFields, isWritingBinary, cellDim);
+  file << "</Piece>\n";
+  file << "</UnstructuredGrid>\n";
+  t1 = PCU_Time();
+  if (isAppending)
+    file.writeAppendedData();
+  file << "</VTKFile>\n";
+  file.close();
   }
   double t2 = PCU_Time();
   if (!PCU_Comm_Self())
   {
-    printf("writeVtuFile buffers to disk: %f seconds\n", t2 - t1);
+    printf("writeVtuFile gathered arrays: %f seconds\n", t1 - t0);
+    printf("writeVtuFile written to disk: %f seconds\n", t2 - t0);
   }
 }
 
@@ -944,7 +1214,8 @@ void writeVtkFilesRunner(const char* prefix,
     Mesh* m,
     std::vector<std::string> writeFields,
     bool isWritingBinary,
-    int cellDim)
+    int cellDim,
+    bool isAppending = false)
 {
   if (cellDim == -1) cellDim = m->getDimension();
   double t0 = PCU_Time();
@@ -957,7 +1228,9 @@ void writeVtkFilesRunner(const char* prefix,
   PCU_Barrier();
   Numbering* n = numberOverlapNodes(m,"apf_vtk_number");
   m->removeNumbering(n);
-  writeVtuFile(prefix, n, writeFields, isWritingBinary, cellDim);
+  int threads = getWriterThreads();
+  writeVtuFile(prefix, n, writeFields, isWritingBinary, cellDim, threads,
+      isAppending);
   double t1 = PCU_Time();
   if (!PCU_Comm_Self())
   {
@@ -1000,7 +1273,10 @@ void writeOneVtkFile(const char* prefix, Mesh* m)
   Numbering* n = numberOverlapNodes(m,"apf_vtk_number");
   m->removeNumbering(n);
   std::vector<std::string> writeFields = populateWriteFields(m);
-  writeVtuFile(prefix, n, writeFields, false, m->getDimension());
+  /* this may not be called by all parts, so it uses
+     more than one thread only if there is one part */
+  int threads = PCU_Comm_Peers() == 1 ? getWriterThreads() : 1;
+  writeVtuFile(prefix, n, writeFields, false, m->getDimension(), threads);
   delete n;
 }
 
@@ -1019,6 +1295,21 @@ void writeVtkFiles(const char* prefix, Mesh* m, int cellDim)
   writeVtkFiles(prefix, m, writeFields, cellDim);
 }
 
+void writeAppendedVtkFiles(
+    const char* prefix,
+    Mesh* m,
+    std::vector<std::string> writeFields,
+    int cellDim)
+{
+  writeVtkFilesRunner(prefix, m, writeFields, true, cellDim, true);
+}
+
+void writeAppendedVtkFiles(const char* prefix, Mesh* m, int cellDim)
+{
+  std::vector<std::string> writeFields = populateWriteFields(m);
+  writeAppendedVtkFiles(prefix, m, writeFields, cellDim);
+}
+
 void writeASCIIVtkFiles(
     const char* prefix,
     Mesh* m,
@@ -107,7 +107,7 @@ class MeshSIM : public Mesh2
     void addMatch(MeshEntity*, int, MeshEntity* ) {}
     void clearMatches(MeshEntity*) {}
     void clear_() {}
-    void acceptChanges() {}
+    void acceptChanges() {changedGeometry();}
     void addGhost(MeshEntity*, int, MeshEntity*) {}
     void deleteGhost(MeshEntity*) {}
     pParMesh getMesh() { return mesh; }
@@ -67,6 +67,30 @@ static void alignEdgeWithTri(apf::Mesh* m, apf::MeshEntity* elem,
   return;
 }
 
+/* evaluates the unblended shapes of one type at several points,
+   sharing one scratch array between them */
+static void bezierAtPoints(int type, int nen, int n,
+    apf::Vector3 const* xi, double* values)
+{
+  apf::NewArray<double> v(nen);
+  for (int i = 0; i < n; ++i) {
+    bezier[type](P,xi[i],v);
+    for (int j = 0; j < nen; ++j)
+      values[i * nen + j] = v[j];
+  }
+}
+
+static void bezierGradsAtPoints(int type, int nen, int n,
+    apf::Vector3 const* xi, apf::Vector3* grads)
+{
+  apf::NewArray<apf::Vector3> g(nen);
+  for (int i = 0; i < n; ++i) {
+    bezierGrads[type](P,xi[i],g);
+    for (int j = 0; j < nen; ++j)
+      grads[i * nen + j] = g[j];
+  }
+}
+
 class Bezier : public apf::FieldShape
 {
 public:
@@ -90,6 +114,7 @@ public:
         apf::Vector3 const&, apf::NewArray<apf::Vector3>&) const
     {
     }
+    bool hasFixedValues() const {return true;}
     int countNodes() const {return 1;}
     void alignSharedNodes(apf::Mesh*,
         apf::MeshEntity*, apf::MeshEntity*, int order[])
@@ -112,6 +137,17 @@ public:
       grads.allocate(P+1);
       bezierGrads[apf::Mesh::EDGE](P,xi,grads);
     }
+    void getValuesAtPoints(apf::Mesh*, apf::MeshEntity*,
+        int n, apf::Vector3 const* xi, double* values) const
+    {
+      bezierAtPoints(apf::Mesh::EDGE, P+1, n, xi, values);
+    }
+    void getLocalGradientsAtPoints(apf::Mesh*, apf::MeshEntity*,
+        int n, apf::Vector3 const* xi, apf::Vector3* grads) const
+    {
+      bezierGradsAtPoints(apf::Mesh::EDGE, P+1, n, xi, grads);
+    }
+    bool hasFixedValues() const {return true;}
     int countNodes() const {return P+1;}
     void alignSharedNodes(apf::Mesh*,
         apf::MeshEntity*, apf::MeshEntity*, int order[])
@@ -146,6 +182,26 @@ public:
         BlendedTriangleGetLocalGradients(m,e,xi,grads);
 
     }
+    void getValuesAtPoints(apf::Mesh* m, apf::MeshEntity* e,
+        int n, apf::Vector3 const* xi, double* values) const
+    {
+      if(!useBlending(apf::Mesh::TRIANGLE)
+          || isBoundaryEntity(m,e))
+        bezierAtPoints(apf::Mesh::TRIANGLE, countNodes(), n, xi, values);
+      else
+        apf::EntityShape::getValuesAtPoints(m,e,n,xi,values);
+    }
+    void getLocalGradientsAtPoints(apf::Mesh* m, apf::MeshEntity* e,
+        int n, apf::Vector3 const* xi, apf::Vector3* grads) const
+    {
+      if(!useBlending(apf::Mesh::TRIANGLE)
+          || isBoundaryEntity(m,e))
+        bezierGradsAtPoints(apf::Mesh::TRIANGLE, countNodes(), n, xi, grads);
+      else
+        apf::EntityShape::getLocalGradientsAtPoints(m,e,n,xi,grads);
+    }
+    /* blended shapes depend on whether the entity is on the boundary */
+    bool hasFixedValues() const {return !useBlending(apf::Mesh::TRIANGLE);}
     int countNodes() const {return getNumControlPoints(apf::Mesh::TRIANGLE,P);}
     void alignSharedNodes(apf::Mesh* m,
         apf::MeshEntity* elem, apf::MeshEntity* shared, int order[])
@@ -179,6 +235,23 @@ public:
         BlendedTetGetLocalGradients(m,e,xi,grads);
       }
     }
+    void getValuesAtPoints(apf::Mesh* m, apf::MeshEntity* e,
+        int n, apf::Vector3 const* xi, double* values) const
+    {
+      if(!useBlending(apf::Mesh::TET))
+        bezierAtPoints(apf::Mesh::TET, countNodes(), n, xi, values);
+      else
+        apf::EntityShape::getValuesAtPoints(m,e,n,xi,values);
+    }
+    void getLocalGradientsAtPoints(apf::Mesh* m, apf::MeshEntity* e,
+        int n, apf::Vector3 const* xi, apf::Vector3* grads) const
+    {
+      if(!useBlending(apf::Mesh::TET))
+        bezierGradsAtPoints(apf::Mesh::TET, countNodes(), n, xi, grads);
+      else
+        apf::EntityShape::getLocalGradientsAtPoints(m,e,n,xi,grads);
+    }
+    bool hasFixedValues() const {return !useBlending(apf::Mesh::TET);}
     int countNodes() const {
       if(!useBlending(apf::Mesh::TET))
         return (P+1)*(P+2)*(P+3)/6;
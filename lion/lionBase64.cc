@@ -131,43 +131,62 @@ std::string base64Encode1Byte (char byte)
 
 std::string base64Encode (const char* input, const unsigned long len )
 {
-  std::string encoded;
-  char inputChars[3];
-  unsigned int index = 0;
+  std::string encoded(base64EncodedLength(len), '=');
+  if ( len )
+    base64Encode(input, len, &encoded[0]);
+  return encoded;
+}
+
+// ===========================================================================
+
+unsigned long base64EncodedLength (const unsigned long len)
+{
+  return ((len + 2) / 3) * 4;
+}
+
+// ===========================================================================
 
-  //encode all the string in 3 byte sections, this loop won't encode the last
-  // 1 or 2 bytes if the len is not divisible by 3
-  if ( len > 2 )
+unsigned long base64Encode (const char* input, const unsigned long len,
+    char* output)
+{
+  const unsigned char* in = (const unsigned char*)input;
+  char* out = output;
+  unsigned long index = 0;
+
+  //encode all the input in 3 byte sections with the same bit
+  // manipulation as base64Encode3Bytes, straight into the output
+  for ( ; index + 3 <= len; index += 3 )
   {
-    for ( ; index <= len - 3; index += 3 )
-    {
-      inputChars[0] = input[index];
-      inputChars[1] = input[index+1];
-      inputChars[2] = input[index+2];
-      encoded += base64Encode3Bytes(inputChars);
-   }
+    unsigned long group = (in[index] << 16) | (in[index+1] << 8) | in[index+2];
+    out[0] = base64EncodeTable[(group >> 18) & 0x3F];
+    out[1] = base64EncodeTable[(group >> 12) & 0x3F];
+    out[2] = base64EncodeTable[(group >> 6) & 0x3F];
+    out[3] = base64EncodeTable[group & 0x3F];
+    out += 4;
   }
 
-  //encode the last 2 bytes if there are 2 bytes left at the end of the string
-  // i.e. if (len % 3 == 2)
+  //the last 1 or 2 bytes are padded as in base64Encode2Bytes
+  // and base64Encode1Byte
   if ( len - index == 2 )
   {
-    inputChars[0] = input[index];
-    inputChars[1] = input[index+1];
-    encoded += base64Encode2Bytes(inputChars);
-    index += 2;
+    unsigned long group = (in[index] << 16) | (in[index+1] << 8);
+    out[0] = base64EncodeTable[(group >> 18) & 0x3F];
+    out[1] = base64EncodeTable[(group >> 12) & 0x3F];
+    out[2] = base64EncodeTable[(group >> 6) & 0x3F];
+    out[3] = '=';
+    out += 4;
   }
-
-  //encode the last 1 byte if there is one byte left at the end of the string
-  // i.e. if (len % 3 == 1)
-  if ( len - index == 1 )
+  else if ( len - index == 1 )
   {
-    char inputChar = input[index];
-    encoded += base64Encode1Byte(inputChar);
-    index++;
+    unsigned long group = in[index] << 16;
+    out[0] = base64EncodeTable[(group >> 18) & 0x3F];
+    out[1] = base64EncodeTable[(group >> 12) & 0x3F];
+    out[2] = '=';
+    out[3] = '=';
+    out += 4;
   }
 
-  return encoded;
+  return out - output;
 }
 
 // ===========================================================================
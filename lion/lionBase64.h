@@ -89,6 +89,40 @@ std::string base64Encode (const char* input, const unsigned long len );
 
 // ===========================================================================
 
+/*
+Function base64EncodedLength:
+  gets the number of Base64 chars that encode a number of bytes,
+  including padding
+
+Arguments:
+  long len - number of bytes to be encoded
+
+Returns:
+  long - 4 chars for every started group of 3 bytes
+*/
+unsigned long base64EncodedLength (const unsigned long len);
+
+// ===========================================================================
+
+/*
+Function base64Encode:
+  Encodes a series of bytes into a buffer of Base64 chars without
+  building any strings, for large arrays
+
+Arguments:
+  char* input - pointer to start of byte string to be encoded
+  long len - number of bytes to be encoded
+  char* output - buffer of at least base64EncodedLength(len) chars,
+                 which will not be null-terminated
+
+Returns:
+  long - number of chars written to output
+*/
+unsigned long base64Encode (const char* input, const unsigned long len,
+    char* output);
+
+// ===========================================================================
+
 /*
 Function base64Decode4Bytes:
   Decodes 4 bytes send to it from Base64 to plaintext,
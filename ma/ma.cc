@@ -17,6 +17,7 @@
 #include "maBalance.h"
 #include "maLayer.h"
 #include "maDBG.h"
+#include "maProfile.h"
 #include <pcu_util.h>
 
 namespace ma {
@@ -27,22 +28,43 @@ void adapt(Input* in)
   double t0 = PCU_Time();
   validateInput(in);
   Adapt* a = new Adapt(in);
+  startPhase(a, "preBalance");
   preBalance(a);
+  stopPhase(a);
   for (int i = 0; i < in->maximumIterations; ++i)
   {
     print("iteration %d",i);
+    setProfileIteration(a, i);
+    startPhase(a, "coarsen");
     coarsen(a);
+    stopPhase(a);
+    startPhase(a, "coarsenLayer");
     coarsenLayer(a);
+    stopPhase(a);
+    startPhase(a, "midBalance");
     midBalance(a);
+    stopPhase(a);
+    startPhase(a, "refine");
     refine(a);
+    stopPhase(a);
+    startPhase(a, "snap");
     snap(a);
+    stopPhase(a);
   }
+  setProfileIteration(a, -1);
   allowSplitCollapseOutsideLayer(a);
+  startPhase(a, "fixElementShapes");
   fixElementShapes(a);
+  stopPhase(a);
+  startPhase(a, "cleanupLayer");
   cleanupLayer(a);
   tetrahedronize(a);
+  stopPhase(a);
   printQuality(a);
+  startPhase(a, "postBalance");
   postBalance(a);
+  stopPhase(a);
+  writeProfile(a);
   Mesh* m = a->mesh;
   delete a;
   delete in;
@@ -57,34 +79,61 @@ void adaptVerbose(Input* in, bool verbose)
   double t0 = PCU_Time();
   validateInput(in);
   Adapt* a = new Adapt(in);
+  startPhase(a, "preBalance");
   preBalance(a);
+  stopPhase(a);
   for (int i = 0; i < in->maximumIterations; ++i)
   {
     print("iteration %d",i);
+    setProfileIteration(a, i);
+    startPhase(a, "coarsen");
     coarsen(a);
+    stopPhase(a);
     if (verbose) ma_dbg::dumpMeshWithQualities(a,i,"after_coarsen");
+    startPhase(a, "coarsenLayer");
     coarsenLayer(a);
+    stopPhase(a);
+    startPhase(a, "midBalance");
     midBalance(a);
+    stopPhase(a);
+    startPhase(a, "refine");
     refine(a);
+    stopPhase(a);
     if (verbose) ma_dbg::dumpMeshWithQualities(a,i,"after_refine");
+    startPhase(a, "snap");
     snap(a);
+    stopPhase(a);
     if (verbose) ma_dbg::dumpMeshWithQualities(a,i,"after_snap");
+    startPhase(a, "fixElementShapes");
     fixElementShapes(a);
+    stopPhase(a);
     if (verbose) ma_dbg::dumpMeshWithQualities(a,i,"after_fix");
   }
+  setProfileIteration(a, -1);
   allowSplitCollapseOutsideLayer(a);
+  startPhase(a, "fixElementShapes");
   fixElementShapes(a);
+  stopPhase(a);
   if (verbose) ma_dbg::dumpMeshWithQualities(a,999,"after_final_fix");
   // final refine to get rid of long edges created during shape fix
+  startPhase(a, "refine");
   refine(a);
+  stopPhase(a);
   if (verbose) ma_dbg::dumpMeshWithQualities(a,999,"after_final_refine");
   // final snap to make sure everything is on the boundary
+  startPhase(a, "snap");
   snap(a);
+  stopPhase(a);
   if (verbose) ma_dbg::dumpMeshWithQualities(a,999,"after_final_snap");
+  startPhase(a, "cleanupLayer");
   cleanupLayer(a);
   tetrahedronize(a);
+  stopPhase(a);
   printQuality(a);
+  startPhase(a, "postBalance");
   postBalance(a);
+  stopPhase(a);
+  writeProfile(a);
   Mesh* m = a->mesh;
   delete a;
   delete in;
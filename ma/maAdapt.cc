@@ -17,10 +17,13 @@
 #include "maShape.h"
 #include "maShapeHandler.h"
 #include "maLayer.h"
+#include "maProfile.h"
 #include <apf.h>
+#include <apfMDS.h>
 #include <cfloat>
 #include <pcu_util.h>
 #include <stdarg.h>
+#include <vector>
 
 namespace ma {
 
@@ -38,6 +41,9 @@ Adapt::Adapt(Input* in)
     shape = in->shapeHandler(this);
   } else
     shape = getShapeHandler(this);
+  profile = 0;
+  if (in->profileFile)
+    profile = new Profile();
   if (in->shouldCoarsen)
     coarsensLeft = in->maximumIterations;
   else
@@ -53,16 +59,25 @@ Adapt::~Adapt()
   clearFlags(this);
   delete refine;
   delete shape;
+  delete profile;
 }
 
+/* on MDS meshes the flags are read and written straight from
+   the tag arrays, which are indexed by entity and grow with the mesh */
 void setupFlags(Adapt* a)
 {
   a->flagsTag = a->mesh->createIntTag("ma_flags",1);
+  a->hasMdsFlags = apf::isMdsMesh(a->mesh);
 }
 
 void clearFlags(Adapt* a)
 {
   Mesh* m = a->mesh;
+  if (a->hasMdsFlags)
+  { //destroying the tag frees its arrays
+    m->destroyTag(a->flagsTag);
+    return;
+  }
   Entity* e;
   for (int d=0; d <= 3; ++d)
   {
@@ -78,6 +93,8 @@ void clearFlags(Adapt* a)
 int getFlags(Adapt* a, Entity* e)
 {
   Mesh* m = a->mesh;
+  if (a->hasMdsFlags)
+    return apf::getMdsIntTag(m,a->flagsTag,e,0);
   if ( ! m->hasTag(e,a->flagsTag))
     return 0; //we assume 0 is the default value for all flags
   int flags;
@@ -87,7 +104,10 @@ int getFlags(Adapt* a, Entity* e)
 
 void setFlags(Adapt* a, Entity* e, int flags)
 {
-  a->mesh->setIntTag(e,a->flagsTag,&flags);
+  if (a->hasMdsFlags)
+    apf::setMdsIntTag(a->mesh,a->flagsTag,e,flags);
+  else
+    a->mesh->setIntTag(e,a->flagsTag,&flags);
 }
 
 bool getFlag(Adapt* a, Entity* e, int flag)
@@ -138,6 +158,11 @@ void clearFlagMatched(Adapt* a, Entity* e, int flag)
 void clearFlagFromDimension(Adapt* a, int flag, int dimension)
 {
   Mesh* m = a->mesh;
+  if (a->hasMdsFlags)
+  {
+    apf::maskMdsIntTag(m,a->flagsTag,dimension,~flag);
+    return;
+  }
   Iterator* it = m->begin(dimension);
   Entity* e;
   while ((e = m->iterate(it)))
@@ -276,6 +301,67 @@ long markEntities(
   return PCU_Add_Long(count);
 }
 
+static long markBatch(
+    Adapt* a,
+    BatchPredicate& predicate,
+    std::vector<Entity*>& batch,
+    bool* result,
+    int trueFlag,
+    int falseFlag)
+{
+  long count = 0;
+  if (batch.empty())
+    return count;
+  Mesh* m = a->mesh;
+  predicate.evaluate(batch.size(), &batch[0], result);
+  for (size_t i = 0; i < batch.size(); ++i)
+  {
+    Entity* e = batch[i];
+    if (result[i])
+    {
+      setFlag(a,e,trueFlag);
+      if (m->isOwned(e))
+        ++count;
+    }
+    else
+      setFlag(a,e,falseFlag);
+  }
+  batch.clear();
+  return count;
+}
+
+/* marks the same entities as the markEntities above, but
+   gathers the ones to evaluate and hands them to the
+   predicate in batches */
+long markEntities(
+    Adapt* a,
+    int dimension,
+    BatchPredicate& predicate,
+    int trueFlag,
+    int falseFlag)
+{
+  const size_t batchSize = 4096;
+  bool result[batchSize];
+  std::vector<Entity*> batch;
+  batch.reserve(batchSize);
+  Entity* e;
+  long count = 0;
+  Mesh* m = a->mesh;
+  Iterator* it = m->begin(dimension);
+  while ((e = m->iterate(it)))
+  {
+    PCU_ALWAYS_ASSERT( ! getFlag(a,e,trueFlag));
+    if (getFlag(a,e,falseFlag))
+      continue;
+    batch.push_back(e);
+    if (batch.size() == batchSize)
+      count += markBatch(a, predicate, batch, result, trueFlag, falseFlag);
+  }
+  m->end(it);
+  count += markBatch(a, predicate, batch, result, trueFlag, falseFlag);
+  return PCU_Add_Long(count);
+}
+
 void NewEntities::reset()
 {
   entities.clear();
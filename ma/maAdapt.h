@@ -37,6 +37,7 @@ class DeleteCallback;
 class SolutionTransfer;
 class Refine;
 class ShapeHandler;
+class Profile;
 
 class Adapt
 {
@@ -46,12 +47,14 @@ class Adapt
     Input* input;
     Mesh* mesh;
     Tag* flagsTag;
+    bool hasMdsFlags;
     DeleteCallback* deleteCallback;
     apf::BuildCallback* buildCallback;
     SizeField* sizeField;
     SolutionTransfer* solutionTransfer;
     Refine* refine;
     ShapeHandler* shape;
+    Profile* profile;
     int coarsensLeft;
     int refinesLeft;
     bool hasLayer;
@@ -103,6 +106,19 @@ long markEntities(
     int trueFlag,
     int falseFlag);
 
+/* a predicate that can also be evaluated on many entities at once */
+struct BatchPredicate : public Predicate
+{
+  virtual void evaluate(size_t n, Entity* const* e, bool* result) = 0;
+};
+
+long markEntities(
+    Adapt* a,
+    int dimension,
+    BatchPredicate& predicate,
+    int trueFlag,
+    int falseFlag);
+
 class NewEntities : public apf::BuildCallback
 {
   public:
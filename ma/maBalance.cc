@@ -1,6 +1,8 @@
 #include <PCU.h>
 #include "maBalance.h"
 #include "maAdapt.h"
+#include "maRefine.h"
+#include "maTables.h"
 #include <parma.h>
 #include <apfZoltan.h>
 
@@ -90,22 +92,85 @@ Tag* getElementWeights(Adapt* a)
   return weights;
 }
 
-static void runBalancer(Adapt* a, apf::Balancer* b)
+/* the number of elements refinement will turn this one into,
+   given the marked edges. Simplices are counted from their
+   templates, other elements keep their size field estimate */
+static double getRefinedWeight(Adapt* a, Entity* e)
+{
+  int type = a->mesh->getType(e);
+  if (type == apf::Mesh::TRIANGLE || type == apf::Mesh::TET) {
+    int code = getEdgeSplitCode(a, e);
+    int index = code_match[type][code].code_index;
+    if (type == apf::Mesh::TRIANGLE)
+      return tri_split_counts[index];
+    return tet_split_counts[index];
+  }
+  return getElementWeight(a, e);
+}
+
+static Tag* getRefinedWeights(Adapt* a)
 {
   Mesh* m = a->mesh;
-  Input* in = a->input;
-  Tag* weights = getElementWeights(a);
-  b->balance(weights,in->maximumImbalance);
-  delete b;
+  Tag* weights = m->createDoubleTag("ma_weight",1);
+  Entity* e;
+  Iterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it)))
+  {
+    double weight = getRefinedWeight(a,e);
+    m->setDoubleTag(e,weights,&weight);
+  }
+  m->end(it);
+  return weights;
+}
+
+static void destroyWeights(Mesh* m, Tag* weights)
+{
   removeTagFromDimension(m,weights,m->getDimension());
   m->destroyTag(weights);
 }
 
-void runZoltan(Adapt* a, int method=apf::GRAPH)
+/* the heaviest part over the average part */
+static double getImbalance(Mesh* m, Tag* weights)
+{
+  double sum = 0;
+  Entity* e;
+  Iterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it)))
+  {
+    double weight;
+    m->getDoubleTag(e,weights,&weight);
+    sum += weight;
+  }
+  m->end(it);
+  double total = PCU_Add_Double(sum);
+  if (total == 0)
+    return 1;
+  return PCU_Max_Double(sum) / (total / PCU_Comm_Peers());
+}
+
+static void runBalancer(Adapt* a, apf::Balancer* b, Tag* weights)
+{
+  b->balance(weights,a->input->maximumImbalance);
+  delete b;
+}
+
+static apf::Balancer* makeZoltan(Adapt* a, int method=apf::GRAPH)
 {
-  runBalancer(a, apf::makeZoltanBalancer(
+  return apf::makeZoltanBalancer(
         a->mesh, method, apf::REPARTITION,
-        /* debug = */ false));
+        /* debug = */ false);
+}
+
+static void runBalancer(Adapt* a, apf::Balancer* b)
+{
+  Tag* weights = getElementWeights(a);
+  runBalancer(a, b, weights);
+  destroyWeights(a->mesh, weights);
+}
+
+void runZoltan(Adapt* a, int method=apf::GRAPH)
+{
+  runBalancer(a, makeZoltan(a, method));
 }
 
 void runParma(Adapt* a)
@@ -134,15 +199,52 @@ void preBalance(Adapt* a)
     runParma(a);
 }
 
+/* the balancers only run if the size field weights are out
+   of balance, and share one computation of those weights */
 void midBalance(Adapt* a)
 {
   if (PCU_Comm_Peers()==1)
     return;
   Input* in = a->input;
-  if (in->shouldRunMidZoltan)
-    runZoltan(a);
-  if (in->shouldRunMidParma)
-    runParma(a);
+  if (( ! in->shouldRunMidZoltan) && ( ! in->shouldRunMidParma))
+    return;
+  Mesh* m = a->mesh;
+  Tag* weights = getElementWeights(a);
+  double imbalance = getImbalance(m, weights);
+  if (imbalance > in->maximumImbalance) {
+    if (in->shouldRunMidZoltan)
+      runBalancer(a, makeZoltan(a), weights);
+    if (in->shouldRunMidParma)
+      runBalancer(a, Parma_MakeElmBalancer(m), weights);
+  } else
+    print("predicted imbalance %.0f%% of average, not balancing",
+        (imbalance-1)*100);
+  destroyWeights(m, weights);
+}
+
+/* called with the edges to split marked, this moves elements
+   so that the parts are balanced after the split templates run.
+   The SPLIT flags are tags, so they move with the edges. */
+void refineBalance(Adapt* a)
+{
+  if (PCU_Comm_Peers()==1)
+    return;
+  Input* in = a->input;
+  if ( ! in->shouldRunRefineParma)
+    return;
+  double t0 = PCU_Time();
+  Mesh* m = a->mesh;
+  Tag* weights = getRefinedWeights(a);
+  double imbalance = getImbalance(m, weights);
+  if (imbalance > in->maximumImbalance) {
+    runBalancer(a, Parma_MakeElmBalancer(m), weights);
+    double after = getImbalance(m, weights);
+    double t1 = PCU_Time();
+    print("balanced for refinement from %.0f%% to %.0f%% "
+        "of average in %f seconds",
+        (imbalance-1)*100, (after-1)*100, t1-t0);
+  }
+  destroyWeights(m, weights);
 }
 
 void postBalance(Adapt* a)
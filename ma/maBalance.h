@@ -7,6 +7,7 @@ class Adapt;
 
 void preBalance(Adapt* a);
 void midBalance(Adapt* a);
+void refineBalance(Adapt* a);
 void postBalance(Adapt* a);
 
 }
@@ -13,6 +13,7 @@
 #include "maCollapse.h"
 #include "maMatchedCollapse.h"
 #include "maOperator.h"
+#include "maProfile.h"
 #include <pcu_util.h>
 
 namespace ma {
@@ -58,7 +59,8 @@ class CollapseChecker : public apf::CavityOp
 void checkAllEdgeCollapses(Adapt* a, int modelDimension)
 {
   CollapseChecker checker(a,modelDimension);
-  checker.applyToDimension(1);
+  int passes = checker.applyToDimension(1);
+  addTotalToProfile(a, PROFILE_CAVITY_PASSES, passes);
   clearFlagFromDimension(a,CHECKED,1);
   PCU_ALWAYS_ASSERT(checkFlagConsistency(a,1,COLLAPSE));
   PCU_ALWAYS_ASSERT(checkFlagConsistency(a,0,COLLAPSE));
@@ -98,7 +100,8 @@ class IndependentSetFinder : public apf::CavityOp
 void findIndependentSet(Adapt* a)
 {
   IndependentSetFinder finder(a);
-  finder.applyToDimension(0);
+  int passes = finder.applyToDimension(0);
+  addTotalToProfile(a, PROFILE_CAVITY_PASSES, passes);
   clearFlagFromDimension(a,CHECKED,0);
   PCU_ALWAYS_ASSERT(checkFlagConsistency(a, 0, COLLAPSE));
 }
@@ -209,13 +212,17 @@ static int collapseMatchedEdges(Adapt* a, int modelDimension)
   return collapser.successCount;
 }
 
-struct ShouldCollapse : public Predicate
+struct ShouldCollapse : public BatchPredicate
 {
   ShouldCollapse(Adapt* a_):a(a_) {}
   bool operator()(Entity* e)
   {
     return a->sizeField->shouldCollapse(e);
   }
+  void evaluate(size_t n, Entity* const* e, bool* result)
+  {
+    a->sizeField->shouldCollapseEdges(n, e, result);
+  }
   Adapt* a;
 };
 
@@ -234,6 +241,7 @@ bool coarsen(Adapt* a)
   long count = markEdgesToCollapse(a);
   if ( ! count)
     return false;
+  addTotalToProfile(a, PROFILE_COLLAPSE_TRIES, count);
   Mesh* m = a->mesh;
   int maxDimension = m->getDimension();
   PCU_ALWAYS_ASSERT(checkFlagConsistency(a,1,COLLAPSE));
@@ -248,6 +256,7 @@ bool coarsen(Adapt* a)
       successCount += collapseAllEdges(a, modelDimension);
   }
   successCount = PCU_Add_Long(successCount);
+  addTotalToProfile(a, PROFILE_COLLAPSES, successCount);
   double t1 = PCU_Time();
   print("coarsened %li edges in %f seconds",successCount,t1-t0);
   return true;
@@ -11,6 +11,7 @@
 #include "maAdapt.h"
 #include "maShape.h"
 #include "maShapeHandler.h"
+#include "maProfile.h"
 #include <cstdio>
 #include <pcu_util.h>
 
@@ -268,6 +269,14 @@ static void getTriangulation(int loopSize, int i, apf::DynamicArray<int>& t)
   table[loopSize](i,t);
 }
 
+static bool countSwap(Adapt* a, bool swapped)
+{
+  addToProfile(a, PROFILE_SWAP_TRIES, 1);
+  if (swapped)
+    addToProfile(a, PROFILE_SWAPS, 1);
+  return swapped;
+}
+
 class EdgeSwap2D : public EdgeSwap
 {
   public:
@@ -387,6 +396,10 @@ class EdgeSwap2D : public EdgeSwap
     /* this function is only called when swapping
        edges on a surface triangle mesh */
     virtual bool run(Entity* e)
+    {
+      return countSwap(adapter, trySwap(e));
+    }
+    bool trySwap(Entity* e)
     {
       if (getFlag(adapter,e,DONT_SWAP))
         return false;
@@ -705,6 +718,10 @@ class EdgeSwap3D : public EdgeSwap
         destroyElement(adapter,oldTets[i]);
     }
     virtual bool run(Entity* e)
+    {
+      return countSwap(adapter, trySwap(e));
+    }
+    bool trySwap(Entity* e)
     {
       if (getFlag(adapter,e,DONT_SWAP))
         return false;
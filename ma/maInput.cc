@@ -34,6 +34,7 @@ void setDefaultValues(Input* in)
   in->shouldFixShape = true;
   in->shouldForceAdaptation = false;
   in->shouldPrintQuality = true;
+  in->profileFile = 0;
   if (in->mesh->getDimension()==3)
   {
     in->goodQuality = 0.027;
@@ -54,6 +55,7 @@ void setDefaultValues(Input* in)
   in->shouldRunPreParma = false;
   in->shouldRunMidZoltan = false;
   in->shouldRunMidParma = false;
+  in->shouldRunRefineParma = false;
   in->shouldRunPostZoltan = false;
   in->shouldRunPostZoltanRib = false;
   in->shouldRunPostParma = false;
@@ -78,6 +78,15 @@ class Input
     bool shouldRunMidZoltan;
 /** \brief whether to run parma during adaptation (default false)*/
     bool shouldRunMidParma;
+/** \brief whether to balance before each refinement (default false)
+   \details once the edges to split are marked, the number of elements
+   each one will be split into is known from the refinement templates,
+   and if that would leave the parts out of balance, parma moves
+   elements across part boundaries until it would not.
+   Only elements near the boundaries of heavy parts move, and
+   since the mid-adaptation balancers run only when the size field
+   predicts an imbalance, those are then rarely needed. */
+    bool shouldRunRefineParma;
 /** \brief whether to run zoltan after adapting (default false) */
     bool shouldRunPostZoltan;
 /** \brief whether to run zoltan RIB after adapting (default false) */
@@ -99,6 +108,9 @@ class Input
     bool splitAllLayerEdges;
 /** \brief this a folder that debugging meshes will be written to, if provided! */
     const char* debugFolder;
+/** \brief file to write the time and operation counts of each adapt phase to,
+   as JSON if it ends in ".json" and as CSV otherwise (default none) */
+    const char* profileFile;
 };
 
 /** \brief generate a configuration based on an anisotropic function.
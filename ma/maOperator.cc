@@ -9,6 +9,7 @@
 *******************************************************************************/
 #include "maOperator.h"
 #include "maAdapt.h"
+#include "maProfile.h"
 
 namespace ma {
 
@@ -46,7 +47,8 @@ Operator::~Operator() {}
 void applyOperator(Adapt* a, Operator* o)
 {
   CollectiveOperation op(a,o);
-  op.applyToDimension(o->getTargetDimension());
+  int passes = op.applyToDimension(o->getTargetDimension());
+  addTotalToProfile(a, PROFILE_CAVITY_PASSES, passes);
 }
 
 }
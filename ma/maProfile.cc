@@ -0,0 +1,163 @@
+/******************************************************************************
+
+  Copyright 2013 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  The LICENSE file included with this distribution describes the terms
+  of the SCOREC Non-Commercial License this program is distributed under.
+
+*******************************************************************************/
+#include "maProfile.h"
+#include "maAdapt.h"
+#include <apfMesh2.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <fstream>
+#include <cstring>
+
+namespace ma {
+
+static const char* const counterNames[PROFILE_COUNTERS] = {
+  "splits",
+  "collapse_tries",
+  "collapses",
+  "swap_tries",
+  "swaps",
+  "snap_tries",
+  "snaps",
+  "migrated_elements",
+  "cavity_passes"
+};
+
+Profile::Profile()
+{
+  iteration = -1;
+  startTime = 0;
+  startMigrated = 0;
+  inPhase = false;
+  for (int i = 0; i < PROFILE_COUNTERS; ++i)
+    counts[i] = 0;
+}
+
+void setProfileIteration(Adapt* a, int iteration)
+{
+  if (a->profile)
+    a->profile->iteration = iteration;
+}
+
+void startPhase(Adapt* a, const char* name)
+{
+  Profile* p = a->profile;
+  if (!p)
+    return;
+  PCU_ALWAYS_ASSERT(!p->inPhase);
+  p->inPhase = true;
+  ProfilePhase phase;
+  phase.iteration = p->iteration;
+  phase.name = name;
+  p->phases.push_back(phase);
+  for (int i = 0; i < PROFILE_COUNTERS; ++i)
+    p->counts[i] = 0;
+  p->startMigrated = apf::countMigratedElements();
+  p->startTime = PCU_Time();
+}
+
+void stopPhase(Adapt* a)
+{
+  Profile* p = a->profile;
+  if (!p)
+    return;
+  PCU_ALWAYS_ASSERT(p->inPhase);
+  p->inPhase = false;
+  double t = PCU_Time() - p->startTime;
+  ProfilePhase& phase = p->phases.back();
+  phase.minTime = PCU_Min_Double(t);
+  phase.maxTime = PCU_Max_Double(t);
+  phase.averageTime = PCU_Add_Double(t) / PCU_Comm_Peers();
+  p->counts[PROFILE_MIGRATED] +=
+    apf::countMigratedElements() - p->startMigrated;
+  PCU_Add_Longs(p->counts, PROFILE_COUNTERS);
+  memcpy(phase.counts, p->counts, sizeof(phase.counts));
+}
+
+void addToProfile(Adapt* a, int counter, long n)
+{
+  Profile* p = a->profile;
+  if (p && p->inPhase)
+    p->counts[counter] += n;
+}
+
+void addTotalToProfile(Adapt* a, int counter, long n)
+{
+  /* counted on part 0 alone, so the sum is right */
+  if (!PCU_Comm_Self())
+    addToProfile(a, counter, n);
+}
+
+static void writeJSON(std::ostream& file, Profile* p)
+{
+  file << "{\n  \"parts\": " << PCU_Comm_Peers() << ",\n";
+  file << "  \"phases\": [\n";
+  for (size_t i = 0; i < p->phases.size(); ++i)
+  {
+    ProfilePhase& phase = p->phases[i];
+    file << "    {\"iteration\": " << phase.iteration;
+    file << ", \"phase\": \"" << phase.name << "\"";
+    file << ", \"time\": {\"min\": " << phase.minTime;
+    file << ", \"max\": " << phase.maxTime;
+    file << ", \"avg\": " << phase.averageTime << "}";
+    for (int j = 0; j < PROFILE_COUNTERS; ++j)
+      file << ", \"" << counterNames[j] << "\": " << phase.counts[j];
+    file << "}";
+    if (i + 1 < p->phases.size())
+      file << ',';
+    file << '\n';
+  }
+  file << "  ]\n}\n";
+}
+
+static void writeCSV(std::ostream& file, Profile* p)
+{
+  file << "iteration,phase,time_min,time_max,time_avg";
+  for (int j = 0; j < PROFILE_COUNTERS; ++j)
+    file << ',' << counterNames[j];
+  file << '\n';
+  for (size_t i = 0; i < p->phases.size(); ++i)
+  {
+    ProfilePhase& phase = p->phases[i];
+    file << phase.iteration << ',' << phase.name;
+    file << ',' << phase.minTime;
+    file << ',' << phase.maxTime;
+    file << ',' << phase.averageTime;
+    for (int j = 0; j < PROFILE_COUNTERS; ++j)
+      file << ',' << phase.counts[j];
+    file << '\n';
+  }
+}
+
+static bool endsWith(std::string const& s, const char* suffix)
+{
+  size_t n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+void writeProfile(Adapt* a)
+{
+  Profile* p = a->profile;
+  if (!p || PCU_Comm_Self())
+    return;
+  std::string name(a->input->profileFile);
+  std::ofstream file(name.c_str());
+  if (!file.is_open())
+  {
+    print("could not open profile file \"%s\"", name.c_str());
+    return;
+  }
+  if (endsWith(name, ".json"))
+    writeJSON(file, p);
+  else
+    writeCSV(file, p);
+  print("profile written to %s", name.c_str());
+}
+
+}
@@ -0,0 +1,75 @@
+/******************************************************************************
+
+  Copyright 2013 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  The LICENSE file included with this distribution describes the terms
+  of the SCOREC Non-Commercial License this program is distributed under.
+
+*******************************************************************************/
+#ifndef MA_PROFILE_H
+#define MA_PROFILE_H
+
+#include <string>
+#include <vector>
+
+namespace ma {
+
+class Adapt;
+
+/* the operation counters kept for each phase */
+enum {
+  PROFILE_SPLITS,
+  PROFILE_COLLAPSE_TRIES,
+  PROFILE_COLLAPSES,
+  PROFILE_SWAP_TRIES,
+  PROFILE_SWAPS,
+  PROFILE_SNAP_TRIES,
+  PROFILE_SNAPS,
+  PROFILE_MIGRATED,
+  PROFILE_CAVITY_PASSES,
+  PROFILE_COUNTERS
+};
+
+struct ProfilePhase
+{
+  int iteration;
+  std::string name;
+  double minTime;
+  double maxTime;
+  double averageTime;
+  long counts[PROFILE_COUNTERS];
+};
+
+/* wall times and operation counts of the phases
+   of one adapt run, see Input::profileFile */
+class Profile
+{
+  public:
+    Profile();
+    int iteration;
+    std::vector<ProfilePhase> phases;
+    /* local counts of the current phase */
+    long counts[PROFILE_COUNTERS];
+    double startTime;
+    size_t startMigrated;
+    bool inPhase;
+};
+
+/* these do nothing unless the adapt run is being profiled.
+   phases do not nest, and starting and stopping one is collective. */
+void setProfileIteration(Adapt* a, int iteration);
+void startPhase(Adapt* a, const char* name);
+void stopPhase(Adapt* a);
+/* adds to a counter of the current phase on this part,
+   the counts of all parts are summed when the phase stops */
+void addToProfile(Adapt* a, int counter, long n);
+/* adds a count that is already the same on all parts */
+void addTotalToProfile(Adapt* a, int counter, long n);
+/* writes the profile to Input::profileFile on part 0,
+   as JSON if the name ends in ".json" and as CSV otherwise */
+void writeProfile(Adapt* a);
+
+}
+
+#endif
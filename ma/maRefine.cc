@@ -16,8 +16,10 @@
 #include "maMatch.h"
 #include "maSolutionTransfer.h"
 #include "maShapeHandler.h"
+#include "maBalance.h"
 #include "maSnap.h"
 #include "maLayer.h"
+#include "maProfile.h"
 #include <apf.h>
 #include <pcu_util.h>
 
@@ -186,7 +188,7 @@ Entity* findSplitVert(Refine* r, Entity* v0, Entity* v1)
   return findSplitVert(r,edge);
 }
 
-static int getEdgeSplitCode(Adapt* a, Entity* e)
+int getEdgeSplitCode(Adapt* a, Entity* e)
 {
   Downward edges;
   int ne = a->mesh->getDownward(e,1,edges);
@@ -369,13 +371,17 @@ void destroySplitElements(Refine* r)
     r->toSplit[d].setSize(0);
 }
 
-struct ShouldSplit : public Predicate
+struct ShouldSplit : public BatchPredicate
 {
   ShouldSplit(Adapt* a_):a(a_) {}
   bool operator()(Entity* e)
   {
     return a->sizeField->shouldSplit(e);
   }
+  void evaluate(size_t n, Entity* const* e, bool* result)
+  {
+    a->sizeField->shouldSplitEdges(n, e, result);
+  }
   Adapt* a;
 };
 
@@ -412,6 +418,7 @@ bool refine(Adapt* a)
     freezeLayer(a);
     return false;
   }
+  refineBalance(a);
   PCU_ALWAYS_ASSERT(checkFlagConsistency(a,1,SPLIT));
   Refine* r = a->refine;
   resetCollection(r);
@@ -423,6 +430,7 @@ bool refine(Adapt* a)
   processNewElements(r);
   destroySplitElements(r);
   forgetNewEntities(r);
+  addTotalToProfile(a, PROFILE_SPLITS, count);
   double t1 = PCU_Time();
   print("refined %li edges in %f seconds",count,t1-t0);
   resetLayer(a);
@@ -63,6 +63,7 @@ Entity* findPlacedSplitVert(Refine* r, Entity* v0, Entity* v1, double& place);
 
 typedef void (*SplitFunction)(Refine* r, Entity* p, Entity** v);
 
+int getEdgeSplitCode(Adapt* a, Entity* e);
 int matchEntityToTemplate(Adapt* a, Entity* e, Entity** vo);
 int matchToTemplate(int type, Entity** vi, int code, Entity** vo);
 
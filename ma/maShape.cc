@@ -19,6 +19,9 @@
 #include "maShapeHandler.h"
 #include "maDBG.h"
 #include <pcu_util.h>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
 
 namespace ma {
 
@@ -634,12 +637,46 @@ void alignElements(Adapt* a)
         originalCount,count,t1-t0);
 }
 
+/* measures all the owned edges in one batch */
+static void printEdgeLengths(Adapt* a)
+{
+  Mesh* m = a->mesh;
+  std::vector<Entity*> edges;
+  Iterator* it = m->begin(1);
+  Entity* e;
+  while ((e = m->iterate(it)))
+    if (m->isOwned(e))
+      edges.push_back(e);
+  m->end(it);
+  std::vector<double> lengths(edges.size());
+  if (!edges.empty())
+    a->sizeField->measureEdges(edges.size(), &edges[0], &lengths[0]);
+  double minLength = DBL_MAX;
+  double maxLength = 0;
+  double sum = 0;
+  for (size_t i = 0; i < lengths.size(); ++i)
+  {
+    minLength = std::min(minLength, lengths[i]);
+    maxLength = std::max(maxLength, lengths[i]);
+    sum += lengths[i];
+  }
+  minLength = PCU_Min_Double(minLength);
+  maxLength = PCU_Max_Double(maxLength);
+  sum = PCU_Add_Double(sum);
+  long count = PCU_Add_Long(edges.size());
+  if (!count)
+    return;
+  print("edge lengths in the metric: min %f avg %f max %f",
+        minLength, sum / count, maxLength);
+}
+
 void printQuality(Adapt* a)
 {
   if ( ! a->input->shouldPrintQuality)
     return;
   double minqual = getMinQuality(a);
   print("worst element quality is %e", minqual);
+  printEdgeLengths(a);
 }
 
 }
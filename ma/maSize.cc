@@ -12,6 +12,7 @@
 #include "apfMatrix.h"
 #include <apfShape.h>
 #include <cstdlib>
+#include <vector>
 #include <pcu_util.h>
 
 namespace ma {
@@ -20,6 +21,27 @@ SizeField::~SizeField()
 {
 }
 
+void SizeField::measureEdges(size_t n, Entity* const* edges,
+    double* lengths)
+{
+  for (size_t i = 0; i < n; ++i)
+    lengths[i] = this->measure(edges[i]);
+}
+
+void SizeField::shouldSplitEdges(size_t n, Entity* const* edges,
+    bool* result)
+{
+  for (size_t i = 0; i < n; ++i)
+    result[i] = this->shouldSplit(edges[i]);
+}
+
+void SizeField::shouldCollapseEdges(size_t n, Entity* const* edges,
+    bool* result)
+{
+  for (size_t i = 0; i < n; ++i)
+    result[i] = this->shouldCollapse(edges[i]);
+}
+
 IdentitySizeField::IdentitySizeField(Mesh* m):
   mesh(m)
 {
@@ -115,6 +137,44 @@ static void orthogonalEigenDecompForSymmetricMatrix(Matrix const& A, Vector& v,
   R = transpose(RT);
 }
 
+/* the transform of AnisoSizeField from interpolated sizes and frame */
+static void getAnisoTransform(Vector const& h, Matrix R, Matrix& Q)
+{
+  orthogonalizeR(R);
+  Matrix S(1/h[0],0,0,
+           0,1/h[1],0,
+           0,0,1/h[2]);
+  Q = R*S;
+}
+
+/* the transform of LogAnisoSizeField from an interpolated log metric */
+static void getLogTransform(Matrix const& logM, Matrix& Q)
+{
+  Vector v;
+  Matrix R;
+  orthogonalEigenDecompForSymmetricMatrix(logM, v, R);
+  Matrix S( sqrt(exp(v[0])), 0, 0,
+            0, sqrt(exp(v[1])), 0,
+            0, 0, sqrt(exp(v[2])));
+  Q = R*S;
+}
+
+/* on a straight edge the single point rule of SizeFieldIntegrator
+   sits at the midpoint, the Jacobian is half the edge vector (t)
+   and the weight is 2 */
+static double measureStraightEdge(Vector const& t, Matrix const& Q)
+{
+  return 2 * (transpose(Q) * t).getLength();
+}
+
+/* whether measureStraightEdge gives the metric length of edges,
+   which needs straight edges and a metric interpolated linearly */
+static bool hasStraightEdges(Mesh* m, apf::Field* metric)
+{
+  return apf::getShape(m->getCoordinateField())->getOrder() == 1 &&
+         apf::getShape(metric) == apf::getLagrange(1);
+}
+
 /* the length, area, or volume of
    the parent element for this
    entity type */
@@ -195,6 +255,24 @@ struct MetricSizeField : public SizeField
   {
     return this->measure(edge) < 0.5;
   }
+  void shouldSplitEdges(size_t n, Entity* const* edges, bool* result)
+  {
+    if (!n)
+      return;
+    std::vector<double> lengths(n);
+    this->measureEdges(n, edges, &lengths[0]);
+    for (size_t i = 0; i < n; ++i)
+      result[i] = lengths[i] > 1.5;
+  }
+  void shouldCollapseEdges(size_t n, Entity* const* edges, bool* result)
+  {
+    if (!n)
+      return;
+    std::vector<double> lengths(n);
+    this->measureEdges(n, edges, &lengths[0]);
+    for (size_t i = 0; i < n; ++i)
+      result[i] = lengths[i] < 0.5;
+  }
   double getWeight(Entity* e)
   {
     /* parentMeasure is used to normalize */
@@ -373,11 +451,47 @@ struct AnisoSizeField : public MetricSizeField
     apf::getMatrix(rElement,xi,R);
     apf::destroyElement(hElement);
     apf::destroyElement(rElement);
-    orthogonalizeR(R);
-    Matrix S(1/h[0],0,0,
-             0,1/h[1],0,
-             0,0,1/h[2]);
-    Q = R*S;
+    getAnisoTransform(h, R, Q);
+  }
+  void measureEdges(size_t n, Entity* const* edges, double* lengths)
+  {
+    if (!n)
+      return;
+    if (!hasStraightEdges(mesh, hField) ||
+        apf::getShape(rField) != apf::getLagrange(1))
+    {
+      SizeField::measureEdges(n, edges, lengths);
+      return;
+    }
+    /* gather the edge vectors and the midpoint metric into
+       arrays, then sweep them. the sizes and frame of a vertex
+       are read together so the one-vertex cache of BothEval hits */
+    std::vector<Vector> t(n);
+    std::vector<Vector> h(n);
+    std::vector<Matrix> R(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      Entity* v[2];
+      mesh->getDownward(edges[i], 0, v);
+      Vector x[2];
+      Vector hv[2];
+      Matrix Rv[2];
+      for (int j = 0; j < 2; ++j)
+      {
+        mesh->getPoint(v[j], 0, x[j]);
+        apf::getVector(hField, v[j], 0, hv[j]);
+        apf::getMatrix(rField, v[j], 0, Rv[j]);
+      }
+      t[i] = (x[1] - x[0]) * 0.5;
+      h[i] = hv[0] * 0.5 + hv[1] * 0.5;
+      R[i] = Rv[0] * 0.5 + Rv[1] * 0.5;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      Matrix Q;
+      getAnisoTransform(h[i], R[i], Q);
+      lengths[i] = measureStraightEdge(t[i], Q);
+    }
   }
   void interpolate(
       apf::MeshElement* parent,
@@ -447,13 +561,39 @@ struct LogAnisoSizeField : public MetricSizeField
     Matrix logM;
     apf::getMatrix(logMElement,xi,logM);
     apf::destroyElement(logMElement);
-    Vector v;
-    Matrix R;
-    orthogonalEigenDecompForSymmetricMatrix(logM, v, R);
-    Matrix S( sqrt(exp(v[0])), 0, 0,
-              0, sqrt(exp(v[1])), 0,
-              0, 0, sqrt(exp(v[2])));
-    Q = R*S;
+    getLogTransform(logM, Q);
+  }
+  void measureEdges(size_t n, Entity* const* edges, double* lengths)
+  {
+    if (!n)
+      return;
+    if (!hasStraightEdges(mesh, logMField))
+    {
+      SizeField::measureEdges(n, edges, lengths);
+      return;
+    }
+    std::vector<Vector> t(n);
+    std::vector<Matrix> logM(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      Entity* v[2];
+      mesh->getDownward(edges[i], 0, v);
+      Vector x[2];
+      Matrix logMv[2];
+      for (int j = 0; j < 2; ++j)
+      {
+        mesh->getPoint(v[j], 0, x[j]);
+        apf::getMatrix(logMField, v[j], 0, logMv[j]);
+      }
+      t[i] = (x[1] - x[0]) * 0.5;
+      logM[i] = logMv[0] * 0.5 + logMv[1] * 0.5;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      Matrix Q;
+      getLogTransform(logM[i], Q);
+      lengths[i] = measureStraightEdge(t[i], Q);
+    }
   }
   void interpolate(
       apf::MeshElement* parent,
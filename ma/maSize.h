@@ -36,6 +36,15 @@ class SizeField
         Vector const& xi,
         Matrix& t) = 0;
     virtual double getWeight(Entity* e) = 0;
+    /* the lengths of (n) edges, by default measured one by one */
+    virtual void measureEdges(size_t n, Entity* const* edges,
+        double* lengths);
+    /* shouldSplit and shouldCollapse for (n) edges at once,
+       by default asked one edge at a time */
+    virtual void shouldSplitEdges(size_t n, Entity* const* edges,
+        bool* result);
+    virtual void shouldCollapseEdges(size_t n, Entity* const* edges,
+        bool* result);
 };
 
 struct IdentitySizeField : public SizeField
@@ -14,6 +14,7 @@
 #include "maSnapper.h"
 #include "maLayer.h"
 #include "maMatch.h"
+#include "maProfile.h"
 #include <apfGeometry.h>
 #include <pcu_util.h>
 #include <iostream>
@@ -693,6 +694,8 @@ void snap(Adapt* a)
   preventMatchedCavityMods(a);
   long targets = tagVertsToSnap(a, tag);
   long success = snapTaggedVerts(a, tag);
+  addTotalToProfile(a, PROFILE_SNAP_TRIES, targets);
+  addTotalToProfile(a, PROFILE_SNAPS, success);
   snapLayer(a, tag);
   apf::removeTagFromDimension(a->mesh, tag, 0);
   a->mesh->destroyTag(tag);
@@ -94,6 +94,24 @@ int const tet_edge_codes[tet_edge_code_count] =
    but it can be seen that it requires more than just
    rotation to go from one to the other */
 
+int const tri_split_counts[tri_edge_code_count] =
+{1,2,3,4};
+
+int const tet_split_counts[tet_edge_code_count] =
+{1//no split
+,2//one edge
+,3//tet and pyramid
+,4//two recursive edge splits
+,4//tet and a pyramid with one split
+,5//two pyramids and a tet
+,5//two pyramids and a tet, variant 2
+,4//tet and prism
+,6//two tets and two pyramids
+,6//two prisms
+,7//prism, pyramid and two tets
+,8//six splits
+};
+
 /* the following table was automatically generated !
    dont touch it ! just use the tetCodeMatch.cc program */
 CodeMatch const tet_code_match[(1<<6)] =
@@ -50,6 +50,11 @@ extern int const tet_edge_codes[tet_edge_code_count];
 extern int const prism_edge_codes[prism_edge_code_count];
 extern int const pyramid_edge_codes[pyramid_edge_code_count];
 
+/* the number of elements the template of each code above
+   splits a simplex into, when it adds no vertex inside it */
+extern int const tri_split_counts[tri_edge_code_count];
+extern int const tet_split_counts[tet_edge_code_count];
+
 extern int const prism_diag_match[(1<<3)];
 extern int const prism_diag_choices[4];
 
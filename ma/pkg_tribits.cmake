@@ -41,6 +41,7 @@ set(SOURCES
   maExtrude.cc
   maDBG.cc
   maStats.cc
+  maProfile.cc
 )
 
 set(HEADERS
@@ -19,9 +19,13 @@
 #include <apfPartition.h>
 #include <apfFile.h>
 #include <cstring>
+#include <algorithm>
 #include <pcu_util.h>
 #include <cstdlib>
 #include<stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 extern "C" {
 
@@ -44,26 +48,36 @@ static mds_id fromEnt(MeshEntity* e)
   return (reinterpret_cast<char*>(e) - ((char*)1));
 }
 
-static MeshIterator* makeIter()
+/* an iterator stops when it reaches the (stop) entity,
+   which is MDS_NONE unless it only covers a range of slots */
+struct MdsIterator
 {
-  mds_id* p = new mds_id;
+  mds_id id;
+  mds_id stop;
+};
+
+static MeshIterator* makeIter(mds_id stop = MDS_NONE)
+{
+  MdsIterator* p = new MdsIterator;
+  p->stop = stop;
   return reinterpret_cast<MeshIterator*>(p);
 }
 
 static void freeIter(MeshIterator* it)
 {
-  mds_id* p = reinterpret_cast<mds_id*>(it);
+  MdsIterator* p = reinterpret_cast<MdsIterator*>(it);
   delete p;
 }
 
 static void toIter(mds_id id, MeshIterator* it)
 {
-  *(reinterpret_cast<mds_id*>(it)) = id;
+  MdsIterator* p = reinterpret_cast<MdsIterator*>(it);
+  p->id = (id == p->stop) ? MDS_NONE : id;
 }
 
 static mds_id fromIter(MeshIterator* it)
 {
-  return *(reinterpret_cast<mds_id*>(it));
+  return reinterpret_cast<MdsIterator*>(it)->id;
 }
 
 static Mesh::Type mds2apf(int t_mds)
@@ -96,6 +110,46 @@ static int apf2mds(int t_apf)
   return table[t_apf];
 }
 
+#ifdef _OPENMP
+struct NestLock
+{
+  NestLock() {omp_init_nest_lock(&lock);}
+  ~NestLock() {omp_destroy_nest_lock(&lock);}
+  omp_nest_lock_t lock;
+};
+static NestLock modifyLock;
+#endif
+
+/* threads may create and destroy entities at the same time as long
+   as each one stays in its own cavity, but the free lists, the tag
+   arrays and the partition model are shared by all entities,
+   so changes to those are made by one thread at a time.
+   Outside a parallel region there is only one thread,
+   and no lock is taken. */
+class ModifyGuard
+{
+  public:
+    ModifyGuard():
+      locked(false)
+    {
+#ifdef _OPENMP
+      if (omp_in_parallel()) {
+        omp_set_nest_lock(&modifyLock.lock);
+        locked = true;
+      }
+#endif
+    }
+    ~ModifyGuard()
+    {
+#ifdef _OPENMP
+      if (locked)
+        omp_unset_nest_lock(&modifyLock.lock);
+#endif
+    }
+  private:
+    bool locked;
+};
+
 class MeshMDS : public Mesh2
 {
   public:
@@ -333,6 +387,42 @@ class MeshMDS : public Mesh2
       for (size_t i = 0; i < p->ids.size(); ++i)
         residence.insert(p->ids[i]);
     }
+    void getNeighbors(int dimension, std::vector<int>& parts,
+        std::vector<std::size_t>& counts)
+    {
+      parts.clear();
+      counts.clear();
+      for (int t = 0; t < MDS_TYPES; ++t) {
+        if (mds_dim[t] != dimension)
+          continue;
+        mds_peers* ps = mds_get_peers(&mesh->remotes, &mesh->mds, t);
+        for (int i = 0; i < ps->np; ++i) {
+          std::size_t n = ps->offset[i + 1] - ps->offset[i];
+          std::vector<int>::iterator at =
+            std::lower_bound(parts.begin(), parts.end(), ps->p[i]);
+          if (at != parts.end() && *at == ps->p[i]) {
+            counts[at - parts.begin()] += n;
+          } else {
+            counts.insert(counts.begin() + (at - parts.begin()), n);
+            parts.insert(at, ps->p[i]);
+          }
+        }
+      }
+    }
+    void getSharedWith(int dimension, int part,
+        std::vector<MeshEntity*>& entities)
+    {
+      entities.clear();
+      for (int t = 0; t < MDS_TYPES; ++t) {
+        if (mds_dim[t] != dimension)
+          continue;
+        mds_id* e;
+        mds_id n = mds_get_shared_with(&mesh->remotes, &mesh->mds, t,
+            part, &e);
+        for (mds_id i = 0; i < n; ++i)
+          entities.push_back(toEnt(mds_identify(t, e[i])));
+      }
+    }
     MeshTag* createDoubleTag(const char* name, int size)
     {
       mds_tag* tag;
@@ -396,8 +486,10 @@ class MeshMDS : public Mesh2
       mds_tag* tag;
       tag = reinterpret_cast<mds_tag*>(t);
       mds_id id = fromEnt(e);
-      if ( ! mds_has_tag(tag,id))
+      if ( ! mds_has_tag(tag,id)) {
+        ModifyGuard guard;
         mds_give_tag(tag,&(mesh->mds),id);
+      }
       memcpy(mds_get_tag(tag,id),data,tag->bytes);
     }
     void getDoubleTag(MeshEntity* e, MeshTag* tag, double* data)
@@ -438,6 +530,17 @@ class MeshMDS : public Mesh2
       mds_id id = fromEnt(e);
       return mds_has_tag(tag,id);
     }
+    void* getTagArray(MeshTag* t, int type, std::size_t begin,
+        std::size_t end, bool give, std::size_t& count)
+    {
+      mds_tag* tag;
+      tag = reinterpret_cast<mds_tag*>(t);
+      int mt = apf2mds(type);
+      count = mesh->mds.n[mt];
+      if (end > count)
+        return 0;
+      return mds_get_tag_array(tag, &(mesh->mds), mt, begin, end, give);
+    }
     int getTagType(MeshTag* t)
     {
       mds_tag* tag;
@@ -462,7 +565,7 @@ class MeshMDS : public Mesh2
     {
       mds_tag* tag;
       tag = reinterpret_cast<mds_tag*>(t);
-      mds_rename_tag(tag,newName);
+      mds_rename_tag(&(mesh->tags),tag,newName);
     }
     /* \brief 16 bit additive checksum of a tag
      * \remark the code is from
@@ -500,6 +603,8 @@ class MeshMDS : public Mesh2
     void acceptChanges()
     {
       updateOwners(this, parts);
+      mds_pack_net(&mesh->remotes, &mesh->mds);
+      changedGeometry();
     }
     void migrate(Migration* plan)
     {
@@ -568,6 +673,7 @@ class MeshMDS : public Mesh2
 
     void setResidence(MeshEntity* e, Parts& residence)
     {
+      ModifyGuard guard;
       mds_id id = fromEnt(e);
       PME* p = getPME(parts, residence);
       void* vp = static_cast<void*>(p);
@@ -607,6 +713,7 @@ class MeshMDS : public Mesh2
         fprintf(stderr,"please use apf::changeMdsDimension\n");
         abort();
       }
+      ModifyGuard guard;
       mds_set s;
       if (type != VERTEX) {
         s.n = mds_degree[t][mds_dim[t]-1];
@@ -623,6 +730,7 @@ class MeshMDS : public Mesh2
     }
     void destroy_(MeshEntity* e)
     {
+      ModifyGuard guard;
       mds_id id = fromEnt(e);
       void* ovp = mds_get_part(mesh, id);
       PME* op = static_cast<PME*>(ovp);
@@ -661,6 +769,7 @@ class MeshMDS : public Mesh2
     void addMatch(MeshEntity* e, int peer, MeshEntity* match)
     {
       PCU_ALWAYS_ASSERT(isMatched);
+      ModifyGuard guard;
       mds_copy c;
       c.e = fromEnt(match);
       c.p = peer;
@@ -668,8 +777,17 @@ class MeshMDS : public Mesh2
     }
     void clearMatches(MeshEntity* e)
     {
+      ModifyGuard guard;
       mds_set_copies(&mesh->matches, &mesh->mds, fromEnt(e), 0);
     }
+    bool canModifyOnThreads()
+    {
+      return true;
+    }
+    void reserve(int type, std::size_t count)
+    {
+      mds_apf_reserve(mesh, apf2mds(type), count);
+    }
     void clear_()
     {
       mesh = mds_apf_create(mesh->user_model, mesh->mds.d, mesh->mds.n);
@@ -748,6 +866,18 @@ void reorderMdsMesh(Mesh2* mesh, MeshTag* t)
     printf("mesh reordered in %f seconds\n", PCU_Time()-t0);
 }
 
+void reorderMdsMeshSFC(Mesh2* mesh, int curve)
+{
+  double t0 = PCU_Time();
+  MeshMDS* m = static_cast<MeshMDS*>(mesh);
+  PCU_ALWAYS_ASSERT(curve == HILBERT || curve == MORTON);
+  int mds_curve = curve == HILBERT ? MDS_HILBERT : MDS_MORTON;
+  mds_tag* nums = mds_number_sfc(m->mesh, mds_curve);
+  m->mesh = mds_reorder(m->mesh, 0, nums);
+  if (!PCU_Comm_Self())
+    printf("mesh reordered along a curve in %f seconds\n", PCU_Time()-t0);
+}
+
 Mesh2* expandMdsMesh(Mesh2* m, gmi_model* g, int inputPartCount)
 {
   double t0 = PCU_Time();
@@ -842,6 +972,68 @@ int getMdsIndex(Mesh2* in, MeshEntity* e)
   return i;
 }
 
+MeshIterator* beginMdsRange(Mesh2* in, int dimension, int i, int n)
+{
+  PCU_ALWAYS_ASSERT(0 <= i && i < n);
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds* mds = &(m->mesh->mds);
+  long slots = mds_count_slots(mds, dimension);
+  mds_id first = mds_begin_slot(mds, dimension, (slots * i) / n);
+  mds_id stop = mds_begin_slot(mds, dimension, (slots * (i + 1)) / n);
+  MeshIterator* it = makeIter(stop);
+  toIter(first, it);
+  return it;
+}
+
+void freezeMdsAdjacency(Mesh2* in)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds_freeze(&(m->mesh->mds));
+}
+
+void freezeMdsBridges(Mesh2* in, int bridgeDimension)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds_freeze_bridges(&(m->mesh->mds), bridgeDimension);
+}
+
+void thawMdsAdjacency(Mesh2* in)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds_thaw(&(m->mesh->mds));
+}
+
+bool isMdsAdjacencyFrozen(Mesh2* in)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  return m->mesh->mds.frozen;
+}
+
+void setMdsArena(bool on, int growth)
+{
+  mds_set_arena(on, growth);
+}
+
+bool isMdsArena()
+{
+  return mds_get_arena();
+}
+
+void getMdsBridgeAdjacent(Mesh2* in, MeshEntity* e, int bridgeDimension,
+    Adjacent& result)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  int n;
+  mds_id const* ids = mds_get_bridges(&(m->mesh->mds), fromEnt(e),
+      bridgeDimension, &n);
+  if (!ids)
+    return getBridgeAdjacent(in, e, bridgeDimension, in->getDimension(),
+        result);
+  result.setSize(n);
+  for (int i = 0; i < n; ++i)
+    result[i] = toEnt(ids[i]);
+}
+
 MeshEntity* getMdsEntity(Mesh2* in, int dimension, int index)
 {
   MeshMDS* m = static_cast<MeshMDS*>(in);
@@ -856,6 +1048,61 @@ MeshEntity* getMdsEntity(Mesh2* in, int dimension, int index)
   return 0;
 }
 
+int getMdsTagId(Mesh2*, MeshTag* t)
+{
+  return reinterpret_cast<mds_tag*>(t)->id;
+}
+
+MeshTag* getMdsTag(Mesh2* in, int id)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds_tag* tag = mds_get_tag_by_id(&(m->mesh->tags), id);
+  return reinterpret_cast<MeshTag*>(tag);
+}
+
+bool isMdsMesh(Mesh* in)
+{
+  return dynamic_cast<MeshMDS*>(in) != 0;
+}
+
+int getMdsIntTag(Mesh2*, MeshTag* t, MeshEntity* e, int missing)
+{
+  mds_tag* tag = reinterpret_cast<mds_tag*>(t);
+  mds_id id = fromEnt(e);
+  if (!mds_has_tag(tag, id))
+    return missing;
+  return *static_cast<int*>(mds_get_tag(tag, id));
+}
+
+void setMdsIntTag(Mesh2* in, MeshTag* t, MeshEntity* e, int value)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds_tag* tag = reinterpret_cast<mds_tag*>(t);
+  mds_id id = fromEnt(e);
+  if (!mds_has_tag(tag, id)) {
+    ModifyGuard guard;
+    mds_give_tag(tag, &(m->mesh->mds), id);
+  }
+  *static_cast<int*>(mds_get_tag(tag, id)) = value;
+}
+
+void maskMdsIntTag(Mesh2* in, MeshTag* t, int dimension, int mask)
+{
+  MeshMDS* m = static_cast<MeshMDS*>(in);
+  mds* mds = &(m->mesh->mds);
+  mds_tag* tag = reinterpret_cast<mds_tag*>(t);
+  PCU_ALWAYS_ASSERT(tag->bytes == sizeof(int));
+  for (int type = 0; type < MDS_TYPES; ++type) {
+    if (mds_dim[type] != dimension || !tag->has[type])
+      continue;
+    /* slots without the tag hold values no one reads,
+       so the whole array is masked without checking */
+    int* values = reinterpret_cast<int*>(tag->data[type]);
+    for (mds_id i = 0; i < mds->end[type]; ++i)
+      values[i] &= mask;
+  }
+}
+
 void disownMdsModel(Mesh2* in)
 {
   MeshMDS* m = static_cast<MeshMDS*>(in);
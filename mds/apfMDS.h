@@ -30,6 +30,8 @@
 /** \file apfMDS.h
   \brief Interface to the compact Mesh Data Structure */
 
+#include <apfMesh.h>
+
 struct gmi_model;
 
 namespace apf {
@@ -38,6 +40,7 @@ class Mesh;
 class Mesh2;
 class MeshTag;
 class MeshEntity;
+class MeshIterator;
 class Migration;
 
 /** \brief create an empty MDS part
@@ -59,6 +62,17 @@ Mesh2* makeEmptyMdsMesh(gmi_model* model, int dim, bool isMatched);
                   For both of these cases, if the path is
                   prepended with "bz2:", then it will be uncompressed
                   using PCU file IO functions.
+                  A path "something"".smb.zst" (or ".lz4", ".bz2")
+                  loads the files "somethingN.smb.zst" with
+                  the codec named by the extension.
+                  If the path is "something"".smbm", then
+                  "somethingN.smbm" is mapped into memory
+                  copy-on-write rather than read, which makes
+                  loading cost page faults instead of parsing.
+                  These files are native-endian.
+                  If the path is "something"".smbc", then
+                  part N is read from the single container
+                  file "something.smbc" with collective MPI-IO.
                   Calling apf::Mesh::writeNative on the
                   resulting object will do the same in reverse. */
 Mesh2* loadMdsMesh(gmi_model* model, const char* meshfile);
@@ -87,6 +101,27 @@ Mesh2* createMdsMesh(gmi_model* model, Mesh* from);
            there are no gaps in the MDS arrays after this */
 void reorderMdsMesh(Mesh2* mesh, MeshTag* t = 0);
 
+/** \brief space-filling curves for apf::reorderMdsMeshSFC */
+enum SpaceFillingCurve {
+  /** \brief the three-dimensional Hilbert curve */
+  HILBERT,
+  /** \brief the Z-order curve, which interleaves coordinate bits */
+  MORTON
+};
+
+/** \brief reorder along a space-filling curve
+  \param curve a value from apf::SpaceFillingCurve
+  \details vertices are ordered along the curve through their
+           coordinates and elements along the curve through their
+           vertex centroids, scaled to the bounding box of this part.
+           Edges and faces follow the vertices as in apf::reorderMdsMesh,
+           which this shares all other properties with.
+           This costs one sort per type, much less than
+           Parma_BfsReorder, and since that function breaks ties
+           in iteration order this also serves as a cheap first pass
+           before it. */
+void reorderMdsMeshSFC(Mesh2* mesh, int curve = HILBERT);
+
 Mesh2* repeatMdsMesh(Mesh2* m, gmi_model* g, Migration* plan, int factor);
 Mesh2* expandMdsMesh(Mesh2* m, gmi_model* g, int inputPartCount);
 
@@ -123,6 +158,103 @@ int getMdsIndex(Mesh2* in, MeshEntity* e);
   so call apf::reorderMdsMesh after any mesh modification. */
 MeshEntity* getMdsEntity(Mesh2* in, int dimension, int index);
 
+/** \brief returns a small non-negative integer identifying this tag
+  \details the id stays the same for the lifetime of the tag,
+  except that apf::reorderMdsMesh assigns new ids, and ids
+  of destroyed tags are given to tags created later. */
+int getMdsTagId(Mesh2* in, MeshTag* t);
+
+/** \brief retrieve a tag by its id, or zero if no tag has it */
+MeshTag* getMdsTag(Mesh2* in, int id);
+
+/** \brief whether this mesh is an MDS mesh */
+bool isMdsMesh(Mesh* in);
+
+/** \brief read a one-integer tag straight from the MDS arrays
+  \details returns (missing) if the entity does not have the tag.
+  This and apf::setMdsIntTag skip the virtual tag interface,
+  for flags that are checked very often. The values are the
+  same ones apf::Mesh::getIntTag sees, so they still migrate. */
+int getMdsIntTag(Mesh2* in, MeshTag* t, MeshEntity* e, int missing);
+
+/** \brief write a one-integer tag straight into the MDS arrays */
+void setMdsIntTag(Mesh2* in, MeshTag* t, MeshEntity* e, int value);
+
+/** \brief bitwise-and a one-integer tag with (mask) on all entities
+  of one dimension, walking the tag arrays rather than the mesh */
+void maskMdsIntTag(Mesh2* in, MeshTag* t, int dimension, int mask);
+
+/** \brief begin iterating over one of several ranges of entities
+  \param dimension the dimension of the entities to iterate over
+  \param i the index of the range to iterate over, in [0, n)
+  \param n the number of ranges
+  \details the MDS arrays of one dimension are cut into n contiguous
+  ranges of nearly equal size, the returned iterator only visits the
+  entities in range i. It is used and freed with apf::Mesh::iterate and
+  apf::Mesh::end like the iterator from apf::Mesh::begin.
+
+  Iterating and the read-only queries such as apf::Mesh::getDownward,
+  apf::Mesh::getAdjacent and apf::Mesh::getPoint do not change the mesh,
+  so several threads may each walk their own range at the same time,
+  as long as no thread modifies the mesh while they do.
+  Ranges are sized by array slots, so the holes left by destroyed
+  entities may unbalance them until apf::reorderMdsMesh is called. */
+MeshIterator* beginMdsRange(Mesh2* in, int dimension, int i, int n);
+
+/** \brief store upward adjacencies in contiguous arrays
+  \details MDS keeps upward adjacencies as linked lists, which
+  queries such as apf::Mesh::getUp have to walk entry by entry.
+  After this call they are answered from compressed-row arrays
+  built in one pass, with the same results in the same order.
+  Any modification of the mesh (creating or destroying entities,
+  changing stored adjacencies or the dimension) drops the arrays,
+  so freeze again once the mesh is static. */
+void freezeMdsAdjacency(Mesh2* in);
+
+/** \brief also store element-to-element adjacency through bridges
+  \details this freezes the mesh as apf::freezeMdsAdjacency does and
+  then stores the elements adjacent to each element through
+  entities of dimension bridgeDimension, which are then given
+  by apf::getMdsBridgeAdjacent. */
+void freezeMdsBridges(Mesh2* in, int bridgeDimension);
+
+/** \brief drop the arrays built by apf::freezeMdsAdjacency
+  \details this happens automatically when the mesh is modified */
+void thawMdsAdjacency(Mesh2* in);
+
+/** \brief whether the adjacencies are currently frozen */
+bool isMdsAdjacencyFrozen(Mesh2* in);
+
+/** \brief choose how MDS stores the arrays of meshes created from now on
+  \details by default MDS arrays are allocated by the C library and
+  growing one reallocates it, so while a mesh is being refined the
+  old and new copies of its largest arrays briefly coexist.
+  With the arena on, each array is given its own range of
+  reserved address space, (growth) times its size when the range
+  is made. Within that range the array grows in place, copying
+  nothing and keeping pointers into it valid. An array that
+  outgrows its range is copied to a new range (growth) times its
+  new size, so it moves like a reallocated array and pointers
+  into it must be fetched again; with growth g this happens about
+  once every g-fold increase in size.
+  Memory is only committed as arrays grow into their ranges.
+  This relies on mmap and is a process-wide setting.
+  \param growth the size of each range as a multiple of the
+  array. Address space is reserved but not committed, so keep
+  this low where it is limited, as with ulimit -v or strict
+  overcommit. */
+void setMdsArena(bool on, int growth = 8);
+
+/** \brief whether apf::setMdsArena is on */
+bool isMdsArena();
+
+/** \brief get the elements adjacent to an element through bridges
+  \details gives the same result as apf::getBridgeAdjacent with the mesh
+  dimension as the target, but from the arrays of apf::freezeMdsBridges
+  if they have been built for this bridge dimension. */
+void getMdsBridgeAdjacent(Mesh2* in, MeshEntity* e, int bridgeDimension,
+    Adjacent& result);
+
 Mesh2* loadMdsFromGmsh(gmi_model* g, const char* filename);
 
 Mesh2* loadMdsFromUgrid(gmi_model* g, const char* filename);
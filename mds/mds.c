@@ -21,9 +21,9 @@ static void* mds_realloc(void* p, size_t n)
   if ((!p)&&(!n))
     return NULL;
   if (n)
-    p = realloc(p,n);
+    p = mds_map_realloc(p,n);
   else {
-    free(p);
+    mds_map_free(p);
     p = NULL;
   }
   if ((!p) && (n))
@@ -233,6 +233,7 @@ static void alloc_adjacency(struct mds* m, int from_dim, int to_dim)
 void mds_remove_adjacency(struct mds* m, int from_dim, int to_dim)
 {
   mds_id zero_cap[MDS_TYPES] = {0};
+  mds_thaw(m);
   resize_adjacency(m,from_dim,to_dim,m->cap,zero_cap);
   m->mrm[from_dim][to_dim] = 0;
 }
@@ -280,6 +281,7 @@ void mds_destroy(struct mds* m)
 {
   int i;
   mds_id old_cap[MDS_TYPES];
+  mds_thaw(m);
   for (i = 0; i < MDS_TYPES; ++i)
     old_cap[i] = m->cap[i];
   ZERO(m->cap);
@@ -403,8 +405,15 @@ static void look_up(struct mds* m, mds_id const e, int d, struct mds_set* s)
   int deg;
   mds_id* es = s->e;
   mds_id** p;
+  mds_id* o;
   t = TYPE(e);
   i = INDEX(e);
+  if (m->frozen && d == mds_dim[t] + 1) {
+    o = m->frozen_up[d - 1].offset[t] + i;
+    s->n = o[1] - o[0];
+    memcpy(s->e, m->frozen_up[d - 1].e + o[0], s->n * sizeof(mds_id));
+    return;
+  }
   p = m->first_up[d];
   n = p[t] + i;
   nv = *n;
@@ -602,6 +611,7 @@ static void unrelate_ent(struct mds* m, mds_id e)
 
 void mds_destroy_entity(struct mds* m, mds_id e)
 {
+  mds_thaw(m);
   check_ent(m,e);
   if (TYPE(e) != MDS_VERTEX)
     unrelate_ent(m,e);
@@ -616,6 +626,7 @@ void mds_hack_adjacent(struct mds* m, mds_id up, int i, mds_id down)
   int deg;
   mds_id x;
   mds_id od;
+  mds_thaw(m);
   check_ent(m, up);
   check_ent(m, down);
   ut = TYPE(up);
@@ -667,10 +678,28 @@ static void convert_down(struct mds* m,
   copy_set(to_s,s[0]);
 }
 
+/* makes room for (count) more entities of type (t),
+   so that creating them does not resize any array */
+void mds_reserve(struct mds* m, int t, mds_id count)
+{
+  int i;
+  mds_id old_cap[MDS_TYPES];
+  mds_thaw(m);
+  if (m->cap[t] - m->n[t] >= count)
+    return;
+  for (i = 0; i < MDS_TYPES; ++i)
+    old_cap[i] = m->cap[i];
+  m->cap[t] = ((old_cap[t] + 2) * 3) / 2;
+  if (m->cap[t] - m->n[t] < count)
+    m->cap[t] = m->n[t] + count;
+  resize(m,old_cap);
+}
+
 mds_id mds_create_entity(struct mds* m, int t, mds_id* from)
 {
   PCU_ALWAYS_ASSERT(0 <= t);
   PCU_ALWAYS_ASSERT(t < MDS_TYPES);
+  mds_thaw(m);
   if (t == MDS_VERTEX)
     return alloc_ent(m, t);
   return add_ent(m, t, from);
@@ -774,10 +803,36 @@ mds_id mds_next(struct mds* m, mds_id e)
   return skip(m,ID(TYPE(e),INDEX(e) + 1));
 }
 
+/* slots are the array positions of all the types of one dimension,
+   laid end to end in iteration order, including free ones */
+mds_id mds_count_slots(struct mds* m, int dim)
+{
+  int t;
+  mds_id n = 0;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == dim)
+      n += m->end[t];
+  return n;
+}
+
+/* the first live entity at or after a slot, MDS_NONE if there is none */
+mds_id mds_begin_slot(struct mds* m, int dim, mds_id slot)
+{
+  int t;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == dim) {
+      if (slot < m->end[t])
+        return skip(m,ID(t,slot));
+      slot -= m->end[t];
+    }
+  return MDS_NONE;
+}
+
 void mds_add_adjacency(struct mds* m, int from_dim, int to_dim)
 {
   mds_id e;
   struct mds_set adj;
+  mds_thaw(m);
   alloc_adjacency(m,from_dim,to_dim);
   if (from_dim < to_dim)
     for (e = mds_begin(m,to_dim);
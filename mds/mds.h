@@ -12,6 +12,7 @@
 #define MDS_H
 
 #include "mds_config.h"
+#include <stddef.h>
 
 enum {
   MDS_VERTEX,
@@ -30,6 +31,12 @@ typedef MDS_ID_TYPE mds_id;
 #define MDS_NONE -1
 #define MDS_LIVE -2
 
+/* compressed rows of entity lists, indexed by type and index */
+struct mds_csr {
+  mds_id* offset[MDS_TYPES];
+  mds_id* e;
+};
+
 struct mds {
   int d;
   mds_id n[MDS_TYPES];
@@ -41,6 +48,10 @@ struct mds {
   mds_id* first_up[4][MDS_TYPES];
   mds_id* free[MDS_TYPES];
   mds_id first_free[MDS_TYPES];
+  int frozen;
+  int frozen_bridges;
+  struct mds_csr frozen_up[4];
+  struct mds_csr frozen_bridge[4];
 };
 
 struct mds_set {
@@ -54,6 +65,7 @@ extern int const* mds_types[MDS_TYPES][4];
 
 void mds_create(struct mds* m, int d, mds_id cap[MDS_TYPES]);
 void mds_destroy(struct mds* m);
+void mds_reserve(struct mds* m, int type, mds_id count);
 mds_id mds_create_entity(struct mds* m, int type, mds_id *from);
 void mds_destroy_entity(struct mds* m, mds_id e);
 int mds_type(mds_id e);
@@ -63,6 +75,9 @@ void mds_get_adjacent(struct mds* m, mds_id e, int dim, struct mds_set* s);
 mds_id mds_begin(struct mds* m, int dim);
 mds_id mds_next(struct mds* m, mds_id);
 
+mds_id mds_count_slots(struct mds* m, int dim);
+mds_id mds_begin_slot(struct mds* m, int dim, mds_id slot);
+
 void mds_add_adjacency(struct mds* m, int from_dim, int to_dim);
 void mds_remove_adjacency(struct mds* m, int from_dim, int to_dim);
 
@@ -72,4 +87,17 @@ void mds_change_dimension(struct mds* m, int d);
 
 void mds_hack_adjacent(struct mds* m, mds_id up, int i, mds_id down);
 
+void mds_freeze(struct mds* m);
+void mds_freeze_bridges(struct mds* m, int bridge_dim);
+void mds_thaw(struct mds* m);
+mds_id const* mds_get_bridges(struct mds* m, mds_id e, int bridge_dim,
+    int* n);
+
+void* mds_map_file(const char* path, size_t* bytes);
+void mds_unmap_file(void* start);
+void* mds_map_realloc(void* p, size_t n);
+void mds_map_free(void* p);
+void mds_set_arena(int on, int growth);
+int mds_get_arena(void);
+
 #endif
@@ -10,6 +10,7 @@
 
 #include "mds_apf.h"
 #include <stdlib.h>
+#include <string.h>
 #include <pcu_util.h>
 #include <PCU.h>
 
@@ -23,17 +24,21 @@ struct mds_apf* mds_apf_create(struct gmi_model* model, int d,
   m = malloc(sizeof(*m));
   mds_create(&(m->mds),d,cap);
   mds_create_tags(&(m->tags));
-  m->point = malloc(cap[MDS_VERTEX] * sizeof(*(m->point)));
-  m->param = malloc(cap[MDS_VERTEX] * sizeof(*(m->param)));
+  m->point = mds_map_realloc(NULL, cap[MDS_VERTEX] * sizeof(*(m->point)));
+  m->param = mds_map_realloc(NULL, cap[MDS_VERTEX] * sizeof(*(m->param)));
   for (t = 0; t < MDS_TYPES; ++t)
-    m->model[t] = malloc(cap[t] * sizeof(*(m->model[t])));
+    m->model[t] = mds_map_realloc(NULL, cap[t] * sizeof(*(m->model[t])));
   m->user_model = model;
-  for (t = 0; t < MDS_TYPES; ++t)
-    m->parts[t] = calloc(cap[t], sizeof(*(m->parts[t])));
+  for (t = 0; t < MDS_TYPES; ++t) {
+    m->parts[t] = mds_map_realloc(NULL, cap[t] * sizeof(*(m->parts[t])));
+    if (cap[t])
+      memset(m->parts[t], 0, cap[t] * sizeof(*(m->parts[t])));
+  }
   mds_create_net(&m->remotes);
 //seol
   mds_create_net(&m->ghosts);
   mds_create_net(&m->matches);
+  m->map = NULL;
   return m;
 }
 
@@ -45,13 +50,15 @@ void mds_apf_destroy(struct mds_apf* m)
   mds_destroy_net(&m->ghosts, &m->mds);
   mds_destroy_net(&m->remotes, &m->mds);
   for (t = 0; t < MDS_TYPES; ++t)
-    free(m->model[t]);
+    mds_map_free(m->model[t]);
   for (t = 0; t < MDS_TYPES; ++t)
-    free(m->parts[t]);
-  free(m->point);
-  free(m->param);
+    mds_map_free(m->parts[t]);
+  mds_map_free(m->point);
+  mds_map_free(m->param);
   mds_destroy_tags(&(m->tags));
   mds_destroy(&(m->mds));
+  if (m->map)
+    mds_unmap_file(m->map);
   free(m);
 }
 
@@ -75,33 +82,51 @@ void mds_apf_set_model(struct mds_apf* m, mds_id e, struct gmi_ent* model)
   m->model[mds_type(e)][mds_index(e)] = model;
 }
 
-mds_id mds_apf_create_entity(
-    struct mds_apf* m, int type, struct gmi_ent* model, mds_id* from)
+/* resizes the arrays kept beside the mds structure
+   after the capacity of (type) changed from (cap) */
+static void grow_apf(struct mds_apf* m, int type, mds_id cap)
 {
   int t;
   mds_id old_cap[MDS_TYPES];
+  if (m->mds.cap[type] == cap)
+    return;
+  for (t = 0; t < MDS_TYPES; ++t)
+    old_cap[t] = m->mds.cap[t];
+  old_cap[type] = cap;
+  mds_grow_tags(&(m->tags),&(m->mds),old_cap);
+  if (type == MDS_VERTEX) {
+    m->point = mds_map_realloc(m->point,
+        m->mds.cap[type] * sizeof(*(m->point)));
+    m->param = mds_map_realloc(m->param,
+        m->mds.cap[type] * sizeof(*(m->param)));
+  }
+  m->model[type] = mds_map_realloc(m->model[type],
+      m->mds.cap[type] * sizeof(*(m->model[type])));
+  m->parts[type] = mds_map_realloc(m->parts[type],
+      m->mds.cap[type] * sizeof(*(m->parts[type])));
+  mds_grow_net(&m->remotes, &m->mds, old_cap); 
+  mds_grow_net(&m->ghosts, &m->mds, old_cap); //seol
+  mds_grow_net(&m->matches, &m->mds, old_cap);
+}
+
+void mds_apf_reserve(struct mds_apf* m, int type, mds_id count)
+{
+  mds_id cap;
+  cap = m->mds.cap[type];
+  mds_reserve(&(m->mds),type,count);
+  grow_apf(m,type,cap);
+}
+
+mds_id mds_apf_create_entity(
+    struct mds_apf* m, int type, struct gmi_ent* model, mds_id* from)
+{
+  mds_id cap;
   mds_id e;
   mds_id i;
-  old_cap[type] = m->mds.cap[type];
+  cap = m->mds.cap[type];
   e = mds_create_entity(&(m->mds),type,from);
   i = mds_index(e);
-  if (m->mds.cap[type] != old_cap[type]) {
-    for (t = 0; t < MDS_TYPES; ++t)
-      if (t != type)
-        old_cap[t] = m->mds.cap[t];
-    mds_grow_tags(&(m->tags),&(m->mds),old_cap);
-    if (type == MDS_VERTEX) {
-      m->point = realloc(m->point,m->mds.cap[type] * sizeof(*(m->point)));
-      m->param = realloc(m->param,m->mds.cap[type] * sizeof(*(m->param)));
-    }
-    m->model[type] = realloc(m->model[type],
-        m->mds.cap[type] * sizeof(*(m->model[type])));
-    m->parts[type] = realloc(m->parts[type],
-        m->mds.cap[type] * sizeof(*(m->parts[type])));
-    mds_grow_net(&m->remotes, &m->mds, old_cap); 
-    mds_grow_net(&m->ghosts, &m->mds, old_cap); //seol
-    mds_grow_net(&m->matches, &m->mds, old_cap);
-  }
+  grow_apf(m,type,cap);
   m->model[type][i] = model;
   m->parts[type][i] = NULL;
   if (type == MDS_VERTEX) {
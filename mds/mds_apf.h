@@ -38,6 +38,7 @@ struct mds_apf {
 //seol
   struct mds_net ghosts;
   struct mds_net matches;
+  void* map;
 };
 
 struct mds_apf* mds_apf_create(struct gmi_model* model, int d,
@@ -47,6 +48,7 @@ double* mds_apf_point(struct mds_apf* m, mds_id e);
 double* mds_apf_param(struct mds_apf* m, mds_id e);
 struct gmi_ent* mds_apf_model(struct mds_apf* m, mds_id e);
 void mds_apf_set_model(struct mds_apf* m, mds_id e, struct gmi_ent* model);
+void mds_apf_reserve(struct mds_apf* m, int type, mds_id count);
 mds_id mds_apf_create_entity(
     struct mds_apf* m, int type, struct gmi_ent* model, mds_id* from);
 void mds_apf_destroy_entity(struct mds_apf* m, mds_id e);
@@ -55,6 +57,8 @@ void* mds_get_part(struct mds_apf* m, mds_id e);
 void mds_set_part(struct mds_apf* m, mds_id e, void* p);
 
 struct mds_tag* mds_number_verts_bfs(struct mds_apf* m);
+enum { MDS_HILBERT, MDS_MORTON };
+struct mds_tag* mds_number_sfc(struct mds_apf* m, int curve);
 struct mds_apf* mds_reorder(struct mds_apf* m, int ignore_peers,
     struct mds_tag* vert_numbers);
 
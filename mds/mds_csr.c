@@ -0,0 +1,195 @@
+/******************************************************************************
+
+  Copyright 2014 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+
+#include "mds.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pcu_util.h>
+#include <reel.h>
+
+/* While a mesh is frozen, upward adjacencies are served from
+   compressed rows instead of the linked lists threaded through
+   mds.up and mds.first_up, and element-to-element adjacencies
+   through a bridge dimension can be served the same way.
+   Any modification of the mesh thaws it. */
+
+static void* csr_alloc(size_t n)
+{
+  void* p;
+  if (!n)
+    return NULL;
+  p = malloc(n);
+  if (!p)
+    reel_fail("MDS ran out of memory!\n");
+  return p;
+}
+
+static void free_csr(struct mds_csr* c)
+{
+  int t;
+  for (t = 0; t < MDS_TYPES; ++t)
+    free(c->offset[t]);
+  free(c->e);
+  memset(c, 0, sizeof(*c));
+}
+
+static int is_live(struct mds* m, int t, mds_id i)
+{
+  return m->free[t][i] == MDS_LIVE;
+}
+
+static void alloc_offsets(struct mds* m, int dim, struct mds_csr* c)
+{
+  int t;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == dim)
+      c->offset[t] = csr_alloc((m->end[t] + 1) * sizeof(mds_id));
+}
+
+static void freeze_up(struct mds* m, int dim, struct mds_csr* c)
+{
+  int t;
+  mds_id i;
+  mds_id n = 0;
+  struct mds_set s;
+  alloc_offsets(m, dim, c);
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == dim) {
+      for (i = 0; i < m->end[t]; ++i) {
+        c->offset[t][i] = n;
+        if (is_live(m, t, i)) {
+          mds_get_adjacent(m, mds_identify(t, i), dim + 1, &s);
+          n += s.n;
+        }
+      }
+      c->offset[t][m->end[t]] = n;
+    }
+  c->e = csr_alloc(n * sizeof(mds_id));
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == dim)
+      for (i = 0; i < m->end[t]; ++i)
+        if (is_live(m, t, i)) {
+          mds_get_adjacent(m, mds_identify(t, i), dim + 1, &s);
+          memcpy(c->e + c->offset[t][i], s.e, s.n * sizeof(mds_id));
+        }
+}
+
+void mds_freeze(struct mds* m)
+{
+  int d;
+  if (m->frozen)
+    return;
+  for (d = 0; d < m->d; ++d)
+    freeze_up(m, d, m->frozen_up + d);
+  m->frozen = 1;
+}
+
+struct row {
+  mds_id n;
+  mds_id cap;
+  mds_id* e;
+};
+
+static void push(struct row* r, mds_id e)
+{
+  if (r->n == r->cap) {
+    r->cap = (r->cap + 8) * 2;
+    r->e = realloc(r->e, r->cap * sizeof(mds_id));
+    if (!r->e)
+      reel_fail("MDS ran out of memory!\n");
+  }
+  r->e[r->n++] = e;
+}
+
+static int compare_ids(const void* a, const void* b)
+{
+  mds_id x = *((mds_id const*)a);
+  mds_id y = *((mds_id const*)b);
+  return (x > y) - (x < y);
+}
+
+/* appends the neighbors of element e through its bridges to all,
+   sorted and without repetition, which is the order that
+   apf::getBridgeAdjacent gives since MDS entity pointers
+   increase with the identifier */
+static void add_bridged(struct mds* m, mds_id e, int bridge_dim,
+    struct row* all)
+{
+  struct mds_set bridges;
+  struct mds_set s;
+  mds_id first = all->n;
+  mds_id i;
+  mds_id j;
+  int k;
+  mds_get_adjacent(m, e, bridge_dim, &bridges);
+  for (k = 0; k < bridges.n; ++k) {
+    mds_get_adjacent(m, bridges.e[k], m->d, &s);
+    for (i = 0; i < s.n; ++i)
+      if (s.e[i] != e)
+        push(all, s.e[i]);
+  }
+  qsort(all->e + first, all->n - first, sizeof(mds_id), compare_ids);
+  j = first;
+  for (i = first; i < all->n; ++i)
+    if (j == first || all->e[j - 1] != all->e[i])
+      all->e[j++] = all->e[i];
+  all->n = j;
+}
+
+void mds_freeze_bridges(struct mds* m, int bridge_dim)
+{
+  int t;
+  mds_id i;
+  struct row all = {0, 0, NULL};
+  struct mds_csr* c;
+  PCU_ALWAYS_ASSERT(0 <= bridge_dim && bridge_dim < m->d);
+  if (m->frozen_bridges & (1 << bridge_dim))
+    return;
+  mds_freeze(m);
+  c = m->frozen_bridge + bridge_dim;
+  alloc_offsets(m, m->d, c);
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (mds_dim[t] == m->d) {
+      for (i = 0; i < m->end[t]; ++i) {
+        c->offset[t][i] = all.n;
+        if (is_live(m, t, i))
+          add_bridged(m, mds_identify(t, i), bridge_dim, &all);
+      }
+      c->offset[t][m->end[t]] = all.n;
+    }
+  c->e = all.e;
+  m->frozen_bridges |= (1 << bridge_dim);
+}
+
+void mds_thaw(struct mds* m)
+{
+  int d;
+  if (!m->frozen)
+    return;
+  for (d = 0; d < 4; ++d) {
+    free_csr(m->frozen_up + d);
+    free_csr(m->frozen_bridge + d);
+  }
+  m->frozen = 0;
+  m->frozen_bridges = 0;
+}
+
+mds_id const* mds_get_bridges(struct mds* m, mds_id e, int bridge_dim,
+    int* n)
+{
+  struct mds_csr* c;
+  mds_id* o;
+  if (!(m->frozen_bridges & (1 << bridge_dim)))
+    return NULL;
+  c = m->frozen_bridge + bridge_dim;
+  o = c->offset[mds_type(e)] + mds_index(e);
+  *n = o[1] - o[0];
+  return c->e + o[0];
+}
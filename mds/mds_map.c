@@ -0,0 +1,235 @@
+/******************************************************************************
+
+  Copyright 2014 Scientific Computation Research Center,
+      Rensselaer Polytechnic Institute. All rights reserved.
+
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+
+#include "mds.h"
+#include <stdlib.h>
+#include <string.h>
+#include <reel.h>
+#include <pcu_util.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* the private file mappings that arrays of loaded meshes may
+   point into. Pages are copied by the kernel when written, and
+   arrays are copied out of the mapping when they are resized,
+   since the C library can not realloc or free them. */
+struct mds_map {
+  char* start;
+  size_t bytes;
+  struct mds_map* next;
+};
+
+static struct mds_map* maps = NULL;
+
+/* every other array is preceded by this header. Arrays from
+   the C library have (reserved) zero. In arena mode, arrays are
+   given ranges of address space of their own, starting at the
+   header, of which only the first (bytes) are readable and
+   writable. Growing such an array makes more of its range
+   writable, so it stays where it is and nothing is copied,
+   instead of realloc making a second, larger copy of it while
+   the first is still alive. The union keeps arrays aligned. */
+typedef union {
+  struct {
+    size_t bytes;
+    size_t reserved;
+  } s;
+  double align[2];
+} mds_block;
+
+static int arena = 0;
+
+/* arrays reserve this many times the size they are created or
+   moved with, and are moved once they outgrow that */
+static int arena_growth = 8;
+
+static mds_block* get_block(void* p)
+{
+  return ((mds_block*)p) - 1;
+}
+
+static struct mds_map* find_file(void const* p)
+{
+  struct mds_map* map;
+  char const* c = p;
+  for (map = maps; map; map = map->next)
+    if (map->start <= c && c < map->start + map->bytes)
+      return map;
+  return NULL;
+}
+
+static size_t round_to_pages(size_t n)
+{
+  size_t page = sysconf(_SC_PAGESIZE);
+  return ((n + page - 1) / page) * page;
+}
+
+static void commit(mds_block* b, size_t n)
+{
+  n = round_to_pages(n);
+  if (n <= b->s.bytes)
+    return;
+  if (mprotect((char*)b + b->s.bytes, n - b->s.bytes,
+        PROT_READ | PROT_WRITE))
+    reel_fail("MDS: could not commit %lu bytes of an arena\n",
+        (unsigned long)n);
+  b->s.bytes = n;
+}
+
+static void* arena_alloc(size_t n)
+{
+  mds_block* b;
+  size_t need;
+  size_t reserved;
+  need = sizeof(*b) + n;
+  reserved = round_to_pages(sizeof(*b) + n * arena_growth);
+  b = mmap(NULL, reserved, PROT_NONE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (b == MAP_FAILED)
+    reel_fail("MDS: could not reserve %lu bytes for an arena\n",
+        (unsigned long)reserved);
+  if (mprotect(b, round_to_pages(need), PROT_READ | PROT_WRITE))
+    reel_fail("MDS: could not commit %lu bytes of an arena\n",
+        (unsigned long)need);
+  b->s.bytes = round_to_pages(need);
+  b->s.reserved = reserved;
+  return b + 1;
+}
+
+static void* heap_realloc(void* p, size_t n)
+{
+  mds_block* b;
+  b = realloc(p ? get_block(p) : NULL, sizeof(*b) + n);
+  if (!b)
+    return NULL;
+  b->s.bytes = sizeof(*b) + n;
+  b->s.reserved = 0;
+  return b + 1;
+}
+
+static void* alloc(size_t n)
+{
+  if (arena)
+    return arena_alloc(n);
+  return heap_realloc(NULL, n);
+}
+
+static void free_block(mds_block* b)
+{
+  if (b->s.reserved)
+    munmap(b, b->s.reserved);
+  else
+    free(b);
+}
+
+void mds_set_arena(int on, int growth)
+{
+  PCU_ALWAYS_ASSERT(growth >= 1);
+  arena = on;
+  arena_growth = growth;
+}
+
+int mds_get_arena(void)
+{
+  return arena;
+}
+
+void* mds_map_file(const char* path, size_t* bytes)
+{
+  int fd;
+  struct stat st;
+  struct mds_map* map;
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    reel_fail("MDS: could not open \"%s\"\n", path);
+  if (fstat(fd, &st))
+    reel_fail("MDS: could not stat \"%s\"\n", path);
+  map = malloc(sizeof(*map));
+  map->bytes = st.st_size;
+  map->start = mmap(NULL, map->bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+      fd, 0);
+  if (map->start == MAP_FAILED)
+    reel_fail("MDS: could not map \"%s\"\n", path);
+  close(fd);
+  map->next = maps;
+  maps = map;
+  *bytes = map->bytes;
+  return map->start;
+}
+
+void mds_unmap_file(void* start)
+{
+  struct mds_map** p;
+  struct mds_map* map;
+  for (p = &maps; (*p)->start != start; p = &((*p)->next));
+  map = *p;
+  *p = map->next;
+  munmap(map->start, map->bytes);
+  free(map);
+}
+
+/* copies at most (n) bytes out of (p), which lies in (map),
+   into new storage of (n) bytes */
+static void* copy_out(struct mds_map* map, void* p, size_t n)
+{
+  void* q;
+  size_t rest;
+  q = alloc(n);
+  /* the old size is unknown, but not past the end of the mapping */
+  rest = map->start + map->bytes - (char*)p;
+  memcpy(q, p, n < rest ? n : rest);
+  return q;
+}
+
+void* mds_map_realloc(void* p, size_t n)
+{
+  struct mds_map* map;
+  mds_block* b;
+  void* q;
+  size_t old;
+  if (!p)
+    return n ? alloc(n) : NULL;
+  map = find_file(p);
+  if (map)
+    return n ? copy_out(map, p, n) : NULL;
+  b = get_block(p);
+  /* arrays that were allocated before arena mode was turned on
+     stay with the C library */
+  if (!b->s.reserved) {
+    if (!n) {
+      free(b);
+      return NULL;
+    }
+    return heap_realloc(p, n);
+  }
+  if (!n) {
+    free_block(b);
+    return NULL;
+  }
+  if (sizeof(*b) + n <= b->s.reserved) {
+    commit(b, sizeof(*b) + n);
+    return p;
+  }
+  q = arena_alloc(n);
+  old = b->s.bytes - sizeof(*b);
+  memcpy(q, p, n < old ? n : old);
+  free_block(b);
+  return q;
+}
+
+void mds_map_free(void* p)
+{
+  if (!p || find_file(p))
+    return;
+  free_block(get_block(p));
+}
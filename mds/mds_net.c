@@ -19,22 +19,66 @@ void mds_create_net(struct mds_net* net)
   memset(net, 0, sizeof(*net));
 }
 
+static size_t copies_bytes(int n)
+{
+  return sizeof(struct mds_copies) + (n - 1) * sizeof(struct mds_copy);
+}
+
+static int in_pool(struct mds_net* net, struct mds_copies* c)
+{
+  char* p = (char*)c;
+  return net->pool <= p && p < net->pool + net->pool_bytes;
+}
+
+static void free_copies(struct mds_net* net, struct mds_copies* c)
+{
+  if (!c)
+    return;
+  if (!in_pool(net, c)) {
+    free(c);
+    return;
+  }
+  --net->pooled;
+  if (!net->pooled) {
+    free(net->pool);
+    net->pool = NULL;
+    net->pool_bytes = 0;
+  }
+}
+
+static void drop_peers(struct mds_net* net)
+{
+  int t;
+  if (!net->packed)
+    return;
+  for (t = 0; t < MDS_TYPES; ++t) {
+    free(net->peers[t].p);
+    free(net->peers[t].offset);
+    free(net->peers[t].e);
+  }
+  memset(net->peers, 0, sizeof(net->peers));
+  net->packed = 0;
+}
+
 void mds_destroy_net(struct mds_net* net, struct mds* m)
 {
   int t;
   mds_id i;
+  drop_peers(net);
   for (t = 0; t < MDS_TYPES; ++t) {
     if (net->data[t])
       for (i = 0; i < m->cap[t]; ++i)
-        free(net->data[t][i]);
-    free(net->data[t]);
+        if (!in_pool(net, net->data[t][i]))
+          free(net->data[t][i]);
+    mds_map_free(net->data[t]);
   }
+  free(net->pool);
 }
 
 struct mds_copies* mds_make_copies(int n)
 {
   struct mds_copies* c;
-  c = malloc(sizeof(struct mds_copies) + (n - 1) * sizeof(struct mds_copy));
+  c = malloc(copies_bytes(n));
   c->n = n;
   return c;
 }
@@ -48,9 +92,11 @@ void mds_set_copies(struct mds_net* net, struct mds* m, mds_id e,
   t = mds_type(e);
   i = mds_index(e);
   if (!net->data[t]) {
-    if (c)
-      net->data[t] = calloc(m->cap[t], sizeof(*(net->data[t])));
-    else
+    if (c) {
+      net->data[t] = mds_map_realloc(NULL,
+          m->cap[t] * sizeof(*(net->data[t])));
+      memset(net->data[t], 0, m->cap[t] * sizeof(*(net->data[t])));
+    } else
       return;
   }
   p = &net->data[t][i];
@@ -59,10 +105,11 @@ void mds_set_copies(struct mds_net* net, struct mds* m, mds_id e,
     ++net->n[t];
   else if (*p && !c)
     --net->n[t];
-  free(*p);
+  drop_peers(net);
+  free_copies(net, *p);
   *p = c;
   if (!net->n[t]) {
-    free(net->data[t]);
+    mds_map_free(net->data[t]);
     net->data[t] = NULL;
   }
 }
@@ -84,7 +131,7 @@ void mds_grow_net(
   mds_id i;
   for (t = 0; t < MDS_TYPES; ++t)
     if (net->data[t]) {
-      net->data[t] = realloc(net->data[t],
+      net->data[t] = mds_map_realloc(net->data[t],
           m->cap[t] * sizeof(struct mds_copies*));
       for (i = old_cap[t]; i < m->cap[t]; ++i)
         net->data[t][i] = NULL;
@@ -110,10 +157,17 @@ void mds_add_copy(struct mds_net* net, struct mds* m, mds_id e,
   t = mds_type(e);
   i = mds_index(e);
   cs = mds_get_copies(net, e);
+  drop_peers(net);
+  if (cs && in_pool(net, cs)) {
+    /* pooled copies can not grow in place */
+    net->data[t][i] = mds_make_copies(cs->n);
+    memcpy(net->data[t][i], cs, copies_bytes(cs->n));
+    free_copies(net, cs);
+    cs = net->data[t][i];
+  }
   if (cs) {
     p = find_place(cs, c.p);
-    cs = realloc(cs, sizeof(struct mds_copies) +
-        (cs->n) * sizeof(struct mds_copy));
+    cs = realloc(cs, copies_bytes(cs->n + 1));
 /* insert sorted by moving greater items up by one */
     memmove(&cs->c[p + 1], &cs->c[p], (cs->n - p) * sizeof(struct mds_copy));
     cs->c[p] = c;
@@ -370,3 +424,141 @@ void mds_free_local_links(struct mds_links* ln)
   free(ln->l[other]);
   ln->l[self] = ln->l[other] = NULL;
 }
+
+static int compare_ints(const void* a, const void* b)
+{
+  int x = *(const int*)a;
+  int y = *(const int*)b;
+  return (x > y) - (x < y);
+}
+
+static int find_part(struct mds_peers* ps, int p)
+{
+  int lo = 0;
+  int hi = ps->np;
+  int mid;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (ps->p[mid] < p)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < ps->np && ps->p[lo] == p)
+    return lo;
+  return -1;
+}
+
+static void build_peers(struct mds_net* net, struct mds* m, int t)
+{
+  struct mds_peers* ps = &net->peers[t];
+  struct mds_copies* cs;
+  mds_id* at;
+  mds_id i;
+  mds_id links = 0;
+  int np;
+  int j;
+  int k;
+  if (!net->data[t])
+    return;
+  for (i = 0; i < m->end[t]; ++i)
+    if ((cs = net->data[t][i]))
+      links += cs->n;
+  /* the distinct parts, by sorting all of them */
+  ps->p = malloc(links * sizeof(int));
+  k = 0;
+  for (i = 0; i < m->end[t]; ++i)
+    if ((cs = net->data[t][i]))
+      for (j = 0; j < cs->n; ++j)
+        ps->p[k++] = cs->c[j].p;
+  qsort(ps->p, links, sizeof(int), compare_ints);
+  np = 0;
+  for (k = 0; k < links; ++k)
+    if (!np || ps->p[np - 1] != ps->p[k])
+      ps->p[np++] = ps->p[k];
+  ps->np = np;
+  ps->p = realloc(ps->p, np * sizeof(int));
+  ps->offset = calloc(np + 1, sizeof(mds_id));
+  for (i = 0; i < m->end[t]; ++i)
+    if ((cs = net->data[t][i]))
+      for (j = 0; j < cs->n; ++j)
+        ++ps->offset[find_part(ps, cs->c[j].p) + 1];
+  for (k = 0; k < np; ++k)
+    ps->offset[k + 1] += ps->offset[k];
+  ps->e = malloc(links * sizeof(mds_id));
+  at = malloc(np * sizeof(mds_id));
+  memcpy(at, ps->offset, np * sizeof(mds_id));
+  for (i = 0; i < m->end[t]; ++i)
+    if ((cs = net->data[t][i]))
+      for (j = 0; j < cs->n; ++j)
+        ps->e[at[find_part(ps, cs->c[j].p)]++] = i;
+  free(at);
+}
+
+void mds_pack_net(struct mds_net* net, struct mds* m)
+{
+  char* old_pool;
+  char* at;
+  size_t bytes = 0;
+  size_t b;
+  struct mds_copies* cs;
+  mds_id i;
+  int t;
+  if (net->packed)
+    return;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (net->data[t])
+      for (i = 0; i < m->end[t]; ++i)
+        if ((cs = net->data[t][i]))
+          bytes += copies_bytes(cs->n);
+  old_pool = net->pool;
+  net->pool = at = malloc(bytes);
+  net->pooled = 0;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (net->data[t])
+      for (i = 0; i < m->end[t]; ++i)
+        if ((cs = net->data[t][i])) {
+          b = copies_bytes(cs->n);
+          memcpy(at, cs, b);
+          /* the old pool is still recorded, so this frees
+             only copies that were malloc'd on their own */
+          if (!(old_pool <= (char*)cs &&
+                (char*)cs < old_pool + net->pool_bytes))
+            free(cs);
+          net->data[t][i] = (struct mds_copies*)at;
+          at += b;
+          ++net->pooled;
+        }
+  free(old_pool);
+  net->pool_bytes = bytes;
+  if (!net->pooled) {
+    free(net->pool);
+    net->pool = NULL;
+    net->pool_bytes = 0;
+  }
+  for (t = 0; t < MDS_TYPES; ++t)
+    build_peers(net, m, t);
+  net->packed = 1;
+}
+
+struct mds_peers* mds_get_peers(struct mds_net* net, struct mds* m, int t)
+{
+  mds_pack_net(net, m);
+  return &net->peers[t];
+}
+
+/* the indices of the entities of type (t) shared with part (p) */
+mds_id mds_get_shared_with(struct mds_net* net, struct mds* m, int t,
+    int p, mds_id** e)
+{
+  struct mds_peers* ps;
+  int i;
+  ps = mds_get_peers(net, m, t);
+  i = find_part(ps, p);
+  if (i == -1) {
+    *e = NULL;
+    return 0;
+  }
+  *e = ps->e + ps->offset[i];
+  return ps->offset[i + 1] - ps->offset[i];
+}
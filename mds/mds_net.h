@@ -23,9 +23,29 @@ struct mds_copies {
   struct mds_copy c[1];
 };
 
+/* the parts sharing entities of one type with this one, in
+   increasing order, and the indices of those entities grouped
+   by part: part p[i] shares e[offset[i]] to e[offset[i+1]-1] */
+struct mds_peers {
+  int np;
+  int* p;
+  mds_id* offset;
+  mds_id* e;
+};
+
+/* copies are malloc'd per entity as they are added. Packing moves
+   them end to end into one pool, in iteration order, and builds
+   the mds_peers index. Changing the copies of an entity after that
+   drops the index and takes its copies out of the pool; the rest
+   stay there until the next packing. */
 struct mds_net {
   mds_id n[MDS_TYPES];
   struct mds_copies** data[MDS_TYPES];
+  char* pool;
+  size_t pool_bytes;
+  mds_id pooled;
+  int packed;
+  struct mds_peers peers[MDS_TYPES];
 };
 
 struct mds_links {
@@ -58,6 +78,11 @@ void mds_free_links(struct mds_links* ln);
 
 int mds_net_empty(struct mds_net* net);
 
+void mds_pack_net(struct mds_net* net, struct mds* m);
+struct mds_peers* mds_get_peers(struct mds_net* net, struct mds* m, int t);
+mds_id mds_get_shared_with(struct mds_net* net, struct mds* m, int t,
+    int p, mds_id** e);
+
 void mds_get_local_matches(struct mds_net* net, struct mds* m,
                          int t, struct mds_links* ln);
 void mds_set_local_matches(struct mds_net* net, struct mds* m,
@@ -134,6 +134,181 @@ struct mds_tag* mds_number_verts_bfs(struct mds_apf* m)
   return tag;
 }
 
+/* space-filling curve keys take 21 bits from each coordinate */
+#define SFC_BITS 21
+
+/* the transpose of the Hilbert index of X, see J. Skilling,
+   "Programming the Hilbert curve", AIP Conf. Proc. 707 (2004) */
+static void hilbert_transpose(unsigned X[3])
+{
+  unsigned M, P, Q, t;
+  int i;
+  M = 1u << (SFC_BITS - 1);
+  for (Q = M; Q > 1; Q >>= 1) {
+    P = Q - 1;
+    for (i = 0; i < 3; ++i)
+      if (X[i] & Q)
+        X[0] ^= P;
+      else {
+        t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+  }
+  for (i = 1; i < 3; ++i)
+    X[i] ^= X[i - 1];
+  t = 0;
+  for (Q = M; Q > 1; Q >>= 1)
+    if (X[2] & Q)
+      t ^= Q - 1;
+  for (i = 0; i < 3; ++i)
+    X[i] ^= t;
+}
+
+static unsigned long long interleave(unsigned X[3])
+{
+  unsigned long long key;
+  int b, i;
+  key = 0;
+  for (b = SFC_BITS - 1; b >= 0; --b)
+    for (i = 0; i < 3; ++i)
+      key = (key << 1) | ((X[i] >> b) & 1);
+  return key;
+}
+
+struct sfc_box {
+  double min[3];
+  double scale[3];
+};
+
+static void get_sfc_box(struct mds_apf* m, struct sfc_box* box)
+{
+  double max[3];
+  double* p;
+  mds_id v;
+  int i;
+  for (i = 0; i < 3; ++i) {
+    box->min[i] = 0;
+    max[i] = 0;
+  }
+  v = mds_begin(&m->mds, 0);
+  if (v != MDS_NONE) {
+    p = mds_apf_point(m, v);
+    for (i = 0; i < 3; ++i)
+      box->min[i] = max[i] = p[i];
+  }
+  for (; v != MDS_NONE; v = mds_next(&m->mds, v)) {
+    p = mds_apf_point(m, v);
+    for (i = 0; i < 3; ++i) {
+      if (p[i] < box->min[i])
+        box->min[i] = p[i];
+      if (p[i] > max[i])
+        max[i] = p[i];
+    }
+  }
+  for (i = 0; i < 3; ++i)
+    if (max[i] > box->min[i])
+      box->scale[i] = ((1u << SFC_BITS) - 1) / (max[i] - box->min[i]);
+    else
+      box->scale[i] = 0;
+}
+
+static unsigned long long sfc_key(struct sfc_box* box, double const x[3],
+    int curve)
+{
+  unsigned X[3];
+  int i;
+  for (i = 0; i < 3; ++i)
+    X[i] = (x[i] - box->min[i]) * box->scale[i];
+  if (curve == MDS_HILBERT)
+    hilbert_transpose(X);
+  return interleave(X);
+}
+
+struct sfc_item {
+  unsigned long long key;
+  mds_id e;
+};
+
+static int compare_items(const void* a, const void* b)
+{
+  struct sfc_item const* x = a;
+  struct sfc_item const* y = b;
+  if (x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  return x->e < y->e ? -1 : (x->e > y->e);
+}
+
+static void get_centroid(struct mds_apf* m, mds_id e, double x[3])
+{
+  struct mds_set vs;
+  double* p;
+  int i, j;
+  if (mds_type(e) == MDS_VERTEX) {
+    p = mds_apf_point(m, e);
+    for (j = 0; j < 3; ++j)
+      x[j] = p[j];
+    return;
+  }
+  mds_get_adjacent(&m->mds, e, 0, &vs);
+  for (j = 0; j < 3; ++j)
+    x[j] = 0;
+  for (i = 0; i < vs.n; ++i) {
+    p = mds_apf_point(m, vs.e[i]);
+    for (j = 0; j < 3; ++j)
+      x[j] += p[j] / vs.n;
+  }
+}
+
+/* labels the entities of one type in curve order */
+static void number_type_sfc(struct mds_apf* m, struct sfc_box* box,
+    int curve, int type, struct mds_tag* tag)
+{
+  struct sfc_item* items;
+  mds_id n;
+  mds_id i;
+  mds_id e;
+  double x[3];
+  int label;
+  n = m->mds.n[type];
+  PCU_ALWAYS_ASSERT(n < INT_MAX);
+  items = malloc(n * sizeof(*items));
+  i = 0;
+  for (e = mds_begin(&m->mds, mds_dim[type]);
+       e != MDS_NONE;
+       e = mds_next(&m->mds, e)) {
+    if (mds_type(e) != type)
+      continue;
+    get_centroid(m, e, x);
+    items[i].key = sfc_key(box, x, curve);
+    items[i].e = e;
+    ++i;
+  }
+  PCU_ALWAYS_ASSERT(i == n);
+  qsort(items, n, sizeof(*items), compare_items);
+  label = 0;
+  for (i = 0; i < n; ++i)
+    visit(&m->mds, tag, &label, items[i].e);
+  free(items);
+}
+
+/* numbers vertices and elements along the curve through
+   their coordinates and centroids. mds_reorder numbers the
+   remaining entities from the vertex order as usual */
+struct mds_tag* mds_number_sfc(struct mds_apf* m, int curve)
+{
+  struct mds_tag* tag;
+  struct sfc_box box;
+  int type;
+  tag = mds_create_tag(&m->tags, "mds_number", sizeof(int), 1);
+  get_sfc_box(m, &box);
+  number_type_sfc(m, &box, curve, MDS_VERTEX, tag);
+  for (type = 0; type < MDS_TYPES; ++type)
+    if (mds_dim[type] == m->mds.d && type != MDS_VERTEX)
+      number_type_sfc(m, &box, curve, type, tag);
+  return tag;
+}
+
 static mds_id* sort_verts(struct mds_apf* m, struct mds_tag* tag)
 {
   mds_id v;
@@ -20,6 +20,7 @@
 #include <sys/types.h> /*required for mode_t for mkdir on some systems*/
 #include <sys/stat.h> /*using POSIX mkdir call for SMB "foo/" path*/
 #include <errno.h> /* for checking the error from mkdir */
+#include <stdint.h>
 
 enum { SMB_VERSION = 5 };
 
@@ -556,11 +557,10 @@ static void write_matches(struct pcu_file* f, struct mds_apf* m,
     write_type_matches(f, m, smb2mds(t), ignore_peers);
 }
 
-static struct mds_apf* read_smb(struct gmi_model* model, const char* filename,
-    int zip, int ignore_peers, void* apf_mesh)
+static struct mds_apf* read_smb(struct gmi_model* model, struct pcu_file* f,
+    int ignore_peers, void* apf_mesh)
 {
   struct mds_apf* m;
-  struct pcu_file* f;
   unsigned version;
   unsigned dim;
   unsigned n[SMB_TYPES];
@@ -568,8 +568,6 @@ static struct mds_apf* read_smb(struct gmi_model* model, const char* filename,
   int i;
   unsigned tmp;
   unsigned pi, pj;
-  f = pcu_fopen(filename, 0, zip);
-  PCU_ALWAYS_ASSERT(f);
   read_header(f, &version, &dim, ignore_peers);
   pcu_read_unsigneds(f, n, SMB_TYPES);
   for (i = 0; i < MDS_TYPES; ++i) {
@@ -598,7 +596,6 @@ static struct mds_apf* read_smb(struct gmi_model* model, const char* filename,
     read_matches_old(f, m, ignore_peers);
   if (version >= 5)
     mds_read_smb_meta(f, m, apf_mesh);
-  pcu_fclose(f);
   return m;
 }
 
@@ -611,14 +608,11 @@ static void write_coords(struct pcu_file* f, struct mds_apf* m)
   pcu_write_doubles(f, &m->param[0][0], count);
 }
 
-static void write_smb(struct mds_apf* m, const char* filename,
-    int zip, int ignore_peers, void* apf_mesh)
+static void write_smb(struct mds_apf* m, struct pcu_file* f,
+    int ignore_peers, void* apf_mesh)
 {
-  struct pcu_file* f;
   unsigned n[SMB_TYPES] = {0};
   int i;
-  f = pcu_fopen(filename, 1, zip);
-  PCU_ALWAYS_ASSERT(f);
   write_header(f, m->mds.d, ignore_peers);
   for (i = 0; i < MDS_TYPES; ++i)
     n[mds2smb(i)] = m->mds.end[i];
@@ -630,7 +624,268 @@ static void write_smb(struct mds_apf* m, const char* filename,
   write_tags(f, m);
   write_matches(f, m, ignore_peers);
   mds_write_smb_meta(f, apf_mesh);
+}
+
+/* the mapped variant of SMB keeps the arrays of a compact mesh
+   in native byte order, each aligned in the file, so a loaded mesh
+   can point into a private mapping of the file instead of reading it.
+   The header and tag table come first, then the arrays, then the
+   remotes, classification and matches in ordinary SMB encoding. */
+
+enum {
+  SMBM_MAGIC = 0x6d626d73,
+  SMBM_VERSION = 1,
+  SMBM_ENDIAN = 0x01020304,
+  SMBM_ALIGN = 64
+};
+
+struct smbm_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t endian;
+  uint32_t id_bytes;
+  uint32_t dim;
+  uint32_t np;
+  uint32_t ntags;
+  uint32_t mrm; /* bit 4 * i + j is mrm[i][j] */
+  uint64_t n[MDS_TYPES];
+  uint64_t tail;
+};
+
+/* followed by the name, padded to name_bytes */
+struct smbm_tag {
+  uint32_t bytes;
+  uint32_t user_type;
+  uint32_t types; /* bit t is set if the tag has data for type t */
+  uint32_t name_bytes;
+};
+
+struct smbm_cursor {
+  struct pcu_file* f;
+  char* map;
+  size_t at;
+};
+
+typedef void (*smbm_array_fn)(struct smbm_cursor* c, void** a, size_t bytes);
+
+static size_t smbm_align(size_t at, size_t to)
+{
+  return ((at + to - 1) / to) * to;
+}
+
+static void visit_arrays(struct mds_apf* m, smbm_array_fn f,
+    struct smbm_cursor* c)
+{
+  struct mds* mds = &m->mds;
+  int i, j, t;
+  for (i = 0; i <= 3; ++i)
+  for (j = 0; j <= 3; ++j) {
+    if (!mds->mrm[i][j])
+      continue;
+    for (t = 0; t < MDS_TYPES; ++t) {
+      if (i > j && mds_dim[t] == i)
+        f(c, (void**)&mds->down[j][t],
+            mds->end[t] * mds_degree[t][j] * sizeof(mds_id));
+      if (i < j && mds_dim[t] == j)
+        f(c, (void**)&mds->up[i][t],
+            mds->end[t] * mds_degree[t][i] * sizeof(mds_id));
+      if (i < j && mds_dim[t] == i)
+        f(c, (void**)&mds->first_up[j][t], mds->end[t] * sizeof(mds_id));
+    }
+  }
+  for (t = 0; t < MDS_TYPES; ++t)
+    f(c, (void**)&mds->free[t], mds->end[t] * sizeof(mds_id));
+  f(c, (void**)&m->point, mds->end[MDS_VERTEX] * sizeof(*m->point));
+  f(c, (void**)&m->param, mds->end[MDS_VERTEX] * sizeof(*m->param));
+}
+
+static void visit_tag_arrays(struct mds_apf* m, struct mds_tag* tag,
+    unsigned types, smbm_array_fn f, struct smbm_cursor* c)
+{
+  int t;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (types & (1 << t)) {
+      f(c, (void**)&tag->has[t], m->mds.end[t] / 8 + 1);
+      f(c, (void**)&tag->data[t], tag->bytes * m->mds.end[t]);
+    }
+}
+
+static unsigned tag_types(struct mds_tag* tag)
+{
+  unsigned types = 0;
+  int t;
+  for (t = 0; t < MDS_TYPES; ++t)
+    if (tag->has[t])
+      types |= (1 << t);
+  return types;
+}
+
+static void measure_array(struct smbm_cursor* c, void** a, size_t bytes)
+{
+  (void)a;
+  c->at = smbm_align(c->at, SMBM_ALIGN) + bytes;
+}
+
+static void write_array(struct smbm_cursor* c, void** a, size_t bytes)
+{
+  static char const zeros[SMBM_ALIGN] = {0};
+  size_t start = smbm_align(c->at, SMBM_ALIGN);
+  pcu_write(c->f, zeros, start - c->at);
+  pcu_write(c->f, *a, bytes);
+  c->at = start + bytes;
+}
+
+static void map_array(struct smbm_cursor* c, void** a, size_t bytes)
+{
+  size_t start = smbm_align(c->at, SMBM_ALIGN);
+  *a = bytes ? c->map + start : NULL;
+  c->at = start + bytes;
+}
+
+static void visit_all_arrays(struct mds_apf* m, struct smbm_tag** toc,
+    smbm_array_fn f, struct smbm_cursor* c)
+{
+  struct mds_tag* tag;
+  unsigned i = 0;
+  visit_arrays(m, f, c);
+  for (tag = m->tags.first; tag; tag = tag->next)
+    visit_tag_arrays(m, tag, toc[i++]->types, f, c);
+}
+
+static void write_mapped(struct mds_apf* m, const char* filename,
+    int ignore_peers, void* apf_mesh)
+{
+  struct smbm_header h;
+  struct smbm_tag* toc[MAX_TAGS];
+  struct smbm_cursor c;
+  struct mds_tag* tag;
+  struct pcu_file* f;
+  unsigned i, j;
+  int t;
+  memset(&h, 0, sizeof(h));
+  h.magic = SMBM_MAGIC;
+  h.version = SMBM_VERSION;
+  h.endian = SMBM_ENDIAN;
+  h.id_bytes = sizeof(mds_id);
+  h.dim = m->mds.d;
+  h.np = ignore_peers ? 1 : PCU_Comm_Peers();
+  for (i = 0; i < 4; ++i)
+  for (j = 0; j < 4; ++j)
+    if (m->mds.mrm[i][j])
+      h.mrm |= (1 << (4 * i + j));
+  for (t = 0; t < MDS_TYPES; ++t)
+    h.n[t] = m->mds.end[t];
+  c.at = sizeof(h);
+  for (tag = m->tags.first; tag; tag = tag->next) {
+    PCU_ALWAYS_ASSERT(h.ntags < MAX_TAGS);
+    toc[h.ntags] = calloc(1, sizeof(struct smbm_tag));
+    toc[h.ntags]->bytes = tag->bytes;
+    toc[h.ntags]->user_type = tag->user_type;
+    toc[h.ntags]->types = tag_types(tag);
+    toc[h.ntags]->name_bytes = smbm_align(strlen(tag->name) + 1, 8);
+    c.at += sizeof(struct smbm_tag) + toc[h.ntags]->name_bytes;
+    ++h.ntags;
+  }
+  visit_all_arrays(m, toc, measure_array, &c);
+  h.tail = c.at;
+  f = pcu_fopen(filename, 1, 0);
+  PCU_ALWAYS_ASSERT(f);
+  pcu_write(f, (char*)&h, sizeof(h));
+  i = 0;
+  for (tag = m->tags.first; tag; tag = tag->next) {
+    static char const zeros[8] = {0};
+    pcu_write(f, (char*)toc[i], sizeof(struct smbm_tag));
+    pcu_write(f, tag->name, strlen(tag->name));
+    pcu_write(f, zeros, toc[i]->name_bytes - strlen(tag->name));
+    ++i;
+  }
+  c.f = f;
+  c.at = sizeof(h);
+  for (i = 0; i < h.ntags; ++i)
+    c.at += sizeof(struct smbm_tag) + toc[i]->name_bytes;
+  visit_all_arrays(m, toc, write_array, &c);
+  PCU_ALWAYS_ASSERT(c.at == h.tail);
+  write_remotes(f, m, ignore_peers);
+  write_class(f, m);
+  write_matches(f, m, ignore_peers);
+  mds_write_smb_meta(f, apf_mesh);
+  pcu_fclose(f);
+  for (i = 0; i < h.ntags; ++i)
+    free(toc[i]);
+}
+
+static void check_mapped(struct smbm_header* h, size_t bytes,
+    const char* filename, int ignore_peers)
+{
+  if (bytes < sizeof(*h) || h->magic != SMBM_MAGIC)
+    reel_fail("MDS: \"%s\" is not a mapped SMB file\n", filename);
+  if (h->version > SMBM_VERSION)
+    reel_fail("MDS: \"%s\" has unknown version %u\n", filename, h->version);
+  if (h->endian != SMBM_ENDIAN)
+    reel_fail("MDS: \"%s\" was written with the other byte order\n",
+        filename);
+  if (h->id_bytes != sizeof(mds_id))
+    reel_fail("MDS: \"%s\" was written with %u byte MDS_ID_TYPE\n",
+        filename, h->id_bytes);
+  if (h->tail > bytes)
+    reel_fail("MDS: \"%s\" is truncated\n", filename);
+  if (!ignore_peers && h->np != (unsigned)PCU_Comm_Peers())
+    reel_fail("To whom it may concern\n"
+        "the # of mesh partitions != the # of MPI ranks");
+}
+
+static struct mds_apf* read_mapped(struct gmi_model* model,
+    const char* filename, int ignore_peers, void* apf_mesh)
+{
+  struct mds_apf* m;
+  struct smbm_header* h;
+  struct smbm_tag* toc[MAX_TAGS];
+  struct smbm_cursor c;
+  struct pcu_file* f;
+  mds_id zero[MDS_TYPES] = {0};
+  size_t bytes;
+  char* map;
+  unsigned i, j;
+  int t;
+  map = mds_map_file(filename, &bytes);
+  h = (struct smbm_header*)map;
+  check_mapped(h, bytes, filename, ignore_peers);
+  PCU_ALWAYS_ASSERT(h->ntags < MAX_TAGS);
+  m = mds_apf_create(model, h->dim, zero);
+  m->map = map;
+  mds_map_free(m->point);
+  mds_map_free(m->param);
+  for (t = 0; t < MDS_TYPES; ++t) {
+    m->mds.n[t] = m->mds.cap[t] = m->mds.end[t] = h->n[t];
+    mds_map_free(m->model[t]);
+    m->model[t] = mds_map_realloc(NULL, h->n[t] * sizeof(*(m->model[t])));
+    mds_map_free(m->parts[t]);
+    m->parts[t] = mds_map_realloc(NULL, h->n[t] * sizeof(*(m->parts[t])));
+    if (h->n[t])
+      memset(m->parts[t], 0, h->n[t] * sizeof(*(m->parts[t])));
+  }
+  for (i = 0; i < 4; ++i)
+  for (j = 0; j < 4; ++j)
+    m->mds.mrm[i][j] = (h->mrm >> (4 * i + j)) & 1;
+  c.map = map;
+  c.at = sizeof(*h);
+  for (i = 0; i < h->ntags; ++i) {
+    toc[i] = (struct smbm_tag*)(map + c.at);
+    c.at += sizeof(struct smbm_tag) + toc[i]->name_bytes;
+  }
+  /* tags are prepended, so creating them backwards keeps their order */
+  for (i = h->ntags; i > 0; --i)
+    mds_create_tag(&m->tags, (char*)(toc[i - 1] + 1),
+        toc[i - 1]->bytes, toc[i - 1]->user_type);
+  visit_all_arrays(m, toc, map_array, &c);
+  PCU_ALWAYS_ASSERT(c.at == h->tail);
+  f = pcu_mem_read(map + h->tail, bytes - h->tail);
+  read_remotes(f, m, ignore_peers);
+  read_class(f, m);
+  read_matches_new(f, m, ignore_peers);
+  mds_read_smb_meta(f, m, apf_mesh);
   pcu_fclose(f);
+  return m;
 }
 
 static int ends_with(const char* s, const char* w)
@@ -685,11 +940,38 @@ static void safe_mkdir(const char* path, mode_t mode)
     reel_fail("MDS: could not create directory \"%s\"\n", path);
 }
 
+static int is_container(const char* path)
+{
+  return ends_with(path, ".smbc");
+}
+
+static int is_mapped(const char* path)
+{
+  return ends_with(path, ".smbm");
+}
+
+/* the compressed variants of "something.smb", whose
+   extension tells pcu_fopen which codec to use */
+static const char* const codec_exts[] = {".bz2", ".zst", ".lz4"};
+#define CODEC_EXTS (sizeof(codec_exts) / sizeof(codec_exts[0]))
+
+static const char* find_codec_ext(const char* path)
+{
+  unsigned i;
+  for (i = 0; i < CODEC_EXTS; ++i)
+    if (ends_with(path, codec_exts[i]))
+      return codec_exts[i];
+  return "";
+}
+
 static char* handle_path(const char* in, int is_write, int* zip,
     int ignore_peers)
 {
   static const char* zippre = "bz2:";
   static const char* smbext = ".smb";
+  static const char* mapext = ".smbm";
+  const char* ext;
+  const char* codec;
   size_t bufsize;
   char* path;
   mode_t const dir_perm = S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH;
@@ -703,6 +985,13 @@ static char* handle_path(const char* in, int is_write, int* zip,
   } else {
     *zip = 0;
   }
+  if (is_container(path)) {
+    if (*zip)
+      reel_fail("MDS: smbc containers can not be compressed \"%s\"\n", in);
+    if (ignore_peers)
+      reel_fail("MDS: smbc containers hold all parts \"%s\"\n", in);
+    return path;
+  }
   if (ignore_peers)
     return path;
   if (ends_with(path, "/")) {
@@ -719,12 +1008,23 @@ static char* handle_path(const char* in, int is_write, int* zip,
         PCU_Barrier();
       }
     }
-  } else if (ends_with(path, smbext)) {
-    remove_ext(path, smbext);
+    ext = smbext;
+    codec = "";
+  } else if (is_mapped(path)) {
+    if (*zip)
+      reel_fail("MDS: smbm files can not be compressed \"%s\"\n", in);
+    remove_ext(path, mapext);
+    ext = mapext;
+    codec = "";
   } else {
-    reel_fail("MDS: invalid smb path \"%s\"\n", path);
+    codec = find_codec_ext(path);
+    remove_ext(path, codec);
+    if (!ends_with(path, smbext))
+      reel_fail("MDS: invalid smb path \"%s\"\n", in);
+    remove_ext(path, smbext);
+    ext = smbext;
   }
-  append(path, bufsize, "%d.smb", self);
+  append(path, bufsize, "%d%s%s", self, ext, codec);
   return path;
 }
 
@@ -734,8 +1034,20 @@ struct mds_apf* mds_read_smb(struct gmi_model* model, const char* pathname,
   char* filename;
   int zip;
   struct mds_apf* m;
+  struct pcu_file* f;
   filename = handle_path(pathname, 0, &zip, ignore_peers);
-  m = read_smb(model, filename, zip, ignore_peers, apf_mesh);
+  if (is_mapped(filename)) {
+    m = read_mapped(model, filename, ignore_peers, apf_mesh);
+    free(filename);
+    return m;
+  }
+  if (is_container(filename))
+    f = pcu_read_container(filename, PCU_Comm_Self());
+  else
+    f = pcu_fopen(filename, 0, zip);
+  PCU_ALWAYS_ASSERT(f);
+  m = read_smb(model, f, ignore_peers, apf_mesh);
+  pcu_fclose(f);
   free(filename);
   return m;
 }
@@ -755,6 +1067,7 @@ struct mds_apf* mds_write_smb(struct mds_apf* m, const char* pathname,
   const char* reorderWarning ="MDS: reordering before writing smb files\n";
   char* filename;
   int zip;
+  struct pcu_file* f;
   if (ignore_peers && (!is_compact(m))) {
     if(!PCU_Comm_Self()) fprintf(stderr, "%s", reorderWarning);
     m = mds_reorder(m, 1, mds_number_verts_bfs(m));
@@ -764,7 +1077,21 @@ struct mds_apf* mds_write_smb(struct mds_apf* m, const char* pathname,
     m = mds_reorder(m, 0, mds_number_verts_bfs(m));
   }
   filename = handle_path(pathname, 1, &zip, ignore_peers);
-  write_smb(m, filename, zip, ignore_peers, apf_mesh);
+  if (is_mapped(filename)) {
+    write_mapped(m, filename, ignore_peers, apf_mesh);
+    free(filename);
+    return m;
+  }
+  if (is_container(filename))
+    f = pcu_mem_open();
+  else
+    f = pcu_fopen(filename, 1, zip);
+  PCU_ALWAYS_ASSERT(f);
+  write_smb(m, f, ignore_peers, apf_mesh);
+  if (is_container(filename))
+    pcu_write_container(filename, f);
+  else
+    pcu_fclose(f);
   free(filename);
   return m;
 }
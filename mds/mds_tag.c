@@ -11,16 +11,90 @@
 #include "mds_tag.h"
 #include <stdlib.h>
 #include <string.h>
+#include <pcu_util.h>
 
 void mds_create_tags(struct mds_tags* ts)
 {
   ts->first = NULL;
+  ts->buckets = NULL;
+  ts->nbuckets = 0;
+  ts->count = 0;
+  ts->by_id = NULL;
+  ts->nids = 0;
 }
 
 void mds_destroy_tags(struct mds_tags* ts)
 {
   while (ts->first)
     mds_destroy_tag(ts,ts->first);
+  free(ts->buckets);
+  free(ts->by_id);
+}
+
+/* FNV-1a */
+static unsigned hash_name(const char* name)
+{
+  unsigned h = 2166136261u;
+  for (; *name; ++name) {
+    h ^= (unsigned char)(*name);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static struct mds_tag** find_in_bucket(struct mds_tags* ts,
+    struct mds_tag* t)
+{
+  struct mds_tag** p;
+  for (p = &(ts->buckets[t->hash % ts->nbuckets]);
+       *p != t; p = &((*p)->next_in_bucket));
+  return p;
+}
+
+static void insert_in_bucket(struct mds_tags* ts, struct mds_tag* t)
+{
+  struct mds_tag** b;
+  b = &(ts->buckets[t->hash % ts->nbuckets]);
+  t->next_in_bucket = *b;
+  *b = t;
+}
+
+static void remove_from_bucket(struct mds_tags* ts, struct mds_tag* t)
+{
+  struct mds_tag** p;
+  p = find_in_bucket(ts, t);
+  *p = t->next_in_bucket;
+}
+
+/* keeps at least as many buckets as tags,
+   counting one that is about to be added */
+static void grow_buckets(struct mds_tags* ts)
+{
+  struct mds_tag* t;
+  if (ts->count < ts->nbuckets)
+    return;
+  free(ts->buckets);
+  ts->nbuckets = ts->nbuckets ? 2 * ts->nbuckets : 16;
+  ts->buckets = calloc(ts->nbuckets, sizeof(*ts->buckets));
+  for (t = ts->first; t; t = t->next)
+    insert_in_bucket(ts, t);
+}
+
+static int take_id(struct mds_tags* ts, struct mds_tag* t)
+{
+  int id;
+  int i;
+  for (id = 0; id < ts->nids; ++id)
+    if ( ! ts->by_id[id])
+      break;
+  if (id == ts->nids) {
+    ts->nids = ts->nids ? 2 * ts->nids : 16;
+    ts->by_id = realloc(ts->by_id, ts->nids * sizeof(*ts->by_id));
+    for (i = id; i < ts->nids; ++i)
+      ts->by_id[i] = NULL;
+  }
+  ts->by_id[id] = t;
+  return id;
 }
 
 static void grow_tag(
@@ -36,10 +110,10 @@ static void grow_tag(
       continue;
     has[0] = (old_cap[t] / 8) + 1;
     has[1] = (m->cap[t] / 8) + 1;
-    tag->has[t] = realloc(tag->has[t], has[1]);
+    tag->has[t] = mds_map_realloc(tag->has[t], has[1]);
     for (i = has[0]; i < has[1]; ++i)
       tag->has[t][i] = 0;
-    tag->data[t] = realloc(tag->data[t],
+    tag->data[t] = mds_map_realloc(tag->data[t],
         tag->bytes * m->cap[t]);
   }
 }
@@ -62,6 +136,8 @@ struct mds_tag* mds_create_tag(
 {
   int l;
   struct mds_tag* t;
+  ++ts->count;
+  grow_buckets(ts);
   t = calloc(1,sizeof(*t));
   t->next = ts->first;
   ts->first = t;
@@ -70,6 +146,9 @@ struct mds_tag* mds_create_tag(
   l = strlen(name);
   t->name = malloc(l + 1);
   strcpy(t->name,name);
+  t->hash = hash_name(name);
+  t->id = take_id(ts, t);
+  insert_in_bucket(ts, t);
   return t;
 }
 
@@ -79,10 +158,13 @@ void mds_destroy_tag(struct mds_tags* ts, struct mds_tag* t)
   int i;
   for (p = &(ts->first); *p != t; p = &((*p)->next));
   *p = (*p)->next;
+  remove_from_bucket(ts, t);
+  ts->by_id[t->id] = NULL;
+  --ts->count;
   for (i = 0; i < MDS_TYPES; ++i)
-    free(t->data[i]);
+    mds_map_free(t->data[i]);
   for (i = 0; i < MDS_TYPES; ++i)
-    free(t->has[i]);
+    mds_map_free(t->has[i]);
   free(t->name);
   free(t);
 }
@@ -95,12 +177,28 @@ void* mds_get_tag(struct mds_tag* tag, mds_id e)
 struct mds_tag* mds_find_tag(struct mds_tags* ts, const char* name)
 {
   struct mds_tag* p;
-  for (p = ts->first; p; p = p->next)
-    if ( ! strcmp(p->name,name))
+  unsigned h;
+  if ( ! ts->count)
+    return 0;
+  h = hash_name(name);
+  for (p = ts->buckets[h % ts->nbuckets]; p; p = p->next_in_bucket)
+    if (p->hash == h && ! strcmp(p->name,name))
       return p;
   return 0;
 }
 
+struct mds_tag* mds_get_tag_by_id(struct mds_tags* ts, int id)
+{
+  if (id < 0 || id >= ts->nids)
+    return 0;
+  return ts->by_id[id];
+}
+
+/* the bits saying which entities have a tag are packed eight to a
+   byte, and threads may give, take and check the tags of entities
+   that share a byte at the same time, so with OpenMP the bytes are
+   read and updated atomically */
+
 int mds_has_tag(struct mds_tag* tag, mds_id e)
 {
   int t;
@@ -114,8 +212,25 @@ int mds_has_tag(struct mds_tag* tag, mds_id e)
   i = mds_index(e);
   c = i / 8;
   b = i % 8;
-  v = tag->has[t][c] & (1 << b);
-  return v != 0;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+  v = tag->has[t][c];
+  return (v & (1 << b)) != 0;
+}
+
+/* the bitmap is published last, so a thread that sees it
+   also sees the cleared bytes and the data array */
+static void alloc_tag(struct mds_tag* tag, struct mds* m, int t)
+{
+  unsigned char* has;
+  tag->data[t] = mds_map_realloc(NULL, tag->bytes * m->cap[t]);
+  has = mds_map_realloc(NULL, (m->cap[t] / 8) + 1);
+  memset(has, 0, (m->cap[t] / 8) + 1);
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+  tag->has[t] = has;
 }
 
 void mds_give_tag(struct mds_tag* tag, struct mds* m, mds_id e)
@@ -126,14 +241,15 @@ void mds_give_tag(struct mds_tag* tag, struct mds* m, mds_id e)
   int b;
   unsigned char* has;
   t = mds_type(e);
-  if ( ! tag->has[t]) {
-    tag->has[t] = calloc((m->cap[t] / 8) + 1, 1);
-    tag->data[t] = malloc(tag->bytes * m->cap[t]);
-  }
+  if ( ! tag->has[t])
+    alloc_tag(tag, m, t);
   i = mds_index(e);
   c = i / 8;
   b = i % 8;
   has = tag->has[t] + c;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
   *has |= (1<<b);
 }
 
@@ -151,16 +267,72 @@ void mds_take_tag(struct mds_tag* tag, mds_id e)
   if (!tag->has[t])
     return;
   has = tag->has[t] + c;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
   *has &= ~(1 << b);
 }
 
-void mds_rename_tag(struct mds_tag* tag, const char* newName)
+/* whether bits [begin,end) are all set, or with (give) sets them.
+   whole bytes are handled at once, the bits before and after them
+   one by one */
+static int has_range(unsigned char* has, mds_id begin, mds_id end,
+    int give)
+{
+  mds_id i;
+  for (i = begin; i < end && (i % 8); ++i) {
+    if (give)
+      has[i / 8] |= (1 << (i % 8));
+    else if ( ! (has[i / 8] & (1 << (i % 8))))
+      return 0;
+  }
+  if (give && i + 8 <= end) {
+    memset(has + i / 8, 0xFF, (end - i) / 8);
+    i += (end - i) / 8 * 8;
+  }
+  for (; i + 8 <= end; i += 8)
+    if (has[i / 8] != 0xFF)
+      return 0;
+  for (; i < end; ++i) {
+    if (give)
+      has[i / 8] |= (1 << (i % 8));
+    else if ( ! (has[i / 8] & (1 << (i % 8))))
+      return 0;
+  }
+  return 1;
+}
+
+/* the values of all entities of one type as a single array,
+   which is only meaningful when there are no free slots between them.
+   With (give) the entities [begin,end) are first given the tag,
+   otherwise NULL is returned unless they all have it already */
+void* mds_get_tag_array(struct mds_tag* tag, struct mds* m, int type,
+    mds_id begin, mds_id end, int give)
+{
+  if (m->n[type] != m->end[type])
+    return NULL;
+  PCU_ALWAYS_ASSERT(0 <= begin && begin <= end && end <= m->n[type]);
+  if ( ! tag->has[type]) {
+    if ( ! give)
+      return NULL;
+    alloc_tag(tag, m, type);
+  }
+  if ( ! has_range(tag->has[type], begin, end, give))
+    return NULL;
+  return tag->data[type];
+}
+
+void mds_rename_tag(struct mds_tags* ts, struct mds_tag* tag,
+    const char* newName)
 {
   int l;
+  remove_from_bucket(ts, tag);
   l = strlen(newName);
   free(tag->name);
   tag->name = malloc(l + 1);
   strcpy(tag->name,newName);
+  tag->hash = hash_name(newName);
+  insert_in_bucket(ts, tag);
 }
 
 static struct mds_tag** find_prev(struct mds_tags* ts, struct mds_tag* t)
@@ -185,15 +357,23 @@ void mds_swap_tag_structs(struct mds_tags* as, struct mds_tag** a,
 {
   struct mds_tag** pa;
   struct mds_tag** pb;
+  struct mds_tag** ha;
+  struct mds_tag** hb;
   struct mds_tag tmp;
   struct mds_tag* tmp_p;
   pa = find_prev(as, *a);
   pb = find_prev(bs, *b);
+  ha = find_in_bucket(as, *a);
+  hb = find_in_bucket(bs, *b);
   tmp = **a;
   **a = **b;
   **b = tmp;
   *pa = *b;
   *pb = *a;
+  *ha = *b;
+  *hb = *a;
+  as->by_id[(*b)->id] = *b;
+  bs->by_id[(*a)->id] = *a;
   tmp_p = *a;
   *a = *b;
   *b = tmp_p;
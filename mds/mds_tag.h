@@ -15,6 +15,9 @@
 
 struct mds_tag {
   struct mds_tag* next;
+  struct mds_tag* next_in_bucket;
+  unsigned hash;
+  int id;
   int bytes;
   int user_type;
   char* data[MDS_TYPES];
@@ -22,8 +25,18 @@ struct mds_tag {
   char* name;
 };
 
+/* besides the list, tags are indexed by a hash of their
+   names and by an integer id, which is the smallest one
+   not in use when the tag is created. The id stays the same
+   until the tag is destroyed, except that mds_reorder
+   gives the tags of the reordered mesh new ids */
 struct mds_tags {
   struct mds_tag* first;
+  struct mds_tag** buckets;
+  int nbuckets;
+  int count;
+  struct mds_tag** by_id;
+  int nids;
 };
 
 void mds_create_tags(struct mds_tags* ts);
@@ -40,10 +53,14 @@ struct mds_tag* mds_create_tag(
 void mds_destroy_tag(struct mds_tags* ts, struct mds_tag* t);
 void* mds_get_tag(struct mds_tag* tag, mds_id e);
 struct mds_tag* mds_find_tag(struct mds_tags* ts, const char* name);
+struct mds_tag* mds_get_tag_by_id(struct mds_tags* ts, int id);
 int mds_has_tag(struct mds_tag* tag, mds_id e);
 void mds_give_tag(struct mds_tag* tag, struct mds* m, mds_id e);
 void mds_take_tag(struct mds_tag* tag, mds_id e);
-void mds_rename_tag(struct mds_tag* tag, const char* newName);
+void* mds_get_tag_array(struct mds_tag* tag, struct mds* m, int type,
+    mds_id begin, mds_id end, int give);
+void mds_rename_tag(struct mds_tags* ts, struct mds_tag* tag,
+    const char* newName);
 
 void mds_swap_tag_structs(struct mds_tags* as, struct mds_tag** a,
     struct mds_tags* bs, struct mds_tag** b);
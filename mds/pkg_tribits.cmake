@@ -10,6 +10,8 @@ include_directories(${CMAKE_CURRENT_BINARY_DIR})
 #Sources & Headers
 set(MDS_SOURCES
   mds.c
+  mds_csr.c
+  mds_map.c
   mds_apf.c
   mds_net.c
   mds_order.c
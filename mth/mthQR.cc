@@ -166,6 +166,42 @@ template void solveFromQR(Matrix<double,0,0> const& q,
     Matrix<double,0,0> const& r,
     Vector<double,0> const& b, Vector<double,0>& x);
 
+template <class T, unsigned M, unsigned N, unsigned K>
+void solveFromQR(Matrix<T,M,M> const& q,
+    Matrix<T,M,N> const& r,
+    Matrix<T,M,K> const& b, Matrix<T,N,K>& x)
+{
+  unsigned m = r.rows();
+  unsigned n = r.cols();
+  unsigned k = b.cols();
+  PCU_ALWAYS_ASSERT(m >= n);
+  PCU_ALWAYS_ASSERT(b.rows() == m);
+  x.resize(n, k);
+  /* x = (Q^T B) restricted to the first n rows,
+     the rest would be ignored by the back substitution */
+  for (unsigned i = 0; i < n; ++i)
+  for (unsigned c = 0; c < k; ++c)
+    x(i,c) = 0;
+  for (unsigned j = 0; j < m; ++j)
+  for (unsigned i = 0; i < n; ++i) {
+    T qji = q(j,i);
+    for (unsigned c = 0; c < k; ++c)
+      x(i,c) += qji * b(j,c);
+  }
+  for (unsigned ii = 0; ii < n; ++ii) {
+    unsigned i = n - ii - 1;
+    for (unsigned j = i + 1; j < n; ++j)
+    for (unsigned c = 0; c < k; ++c)
+      x(i,c) -= r(i,j) * x(j,c);
+    for (unsigned c = 0; c < k; ++c)
+      x(i,c) /= r(i,i);
+  }
+}
+
+template void solveFromQR(Matrix<double,0,0> const& q,
+    Matrix<double,0,0> const& r,
+    Matrix<double,0,0> const& b, Matrix<double,0,0>& x);
+
 template <class T, unsigned M, unsigned N>
 bool solveQR(Matrix<T,M,N> const& a,
     Vector<T,M> const& b, Vector<T,N>& x)
@@ -47,6 +47,23 @@ void solveFromQR(Matrix<T,M,M> const& q,
     Matrix<T,M,N> const& r,
     Vector<T,M> const& b, Vector<T,N>& x);
 
+/** \brief solves AX = B for many right hand sides
+  *        given A's QR factorization
+  * \details when M > N, the least squares problems are solved.
+  *          All columns of B are solved in one pass, and only the
+  *          first N columns of Q are used, so this costs much less
+  *          than calling solveFromQR once per column.
+  *          only the dynamic type is explicitly instantiated.
+  * \param q the MxM orthogonal input matrix
+  * \param r the MxN (M >= N) upper triangular input matrix
+  * \param b the MxK right hand side input matrix
+  * \param x the NxK output solution matrix
+  */
+template <class T, unsigned M, unsigned N, unsigned K>
+void solveFromQR(Matrix<T,M,M> const& q,
+    Matrix<T,M,N> const& r,
+    Matrix<T,M,K> const& b, Matrix<T,N,K>& x);
+
 /** \brief solves Ax = b using A's QR factorization
   * \details when M > N, the least squares problem is solved.
   *          only the dynamic type is explicitly instantiated.
@@ -8,6 +8,7 @@
 #include <limits>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace {
   typedef std::map<int,int> mii;
@@ -148,16 +149,16 @@ namespace {
     }
   }
 
+  /* every vertex resides on this part, so it counts as sharing
+     all of them with itself */
   void getNeighborCounts(apf::Mesh* m, mii& nborToShared) {
-    apf::MeshIterator *it = m->begin(0);
-    apf::MeshEntity* e;
-    while ((e = m->iterate(it))) {
-      apf::Parts sharers;
-      m->getResidence(e,sharers);
-      APF_ITERATE(apf::Parts, sharers, nbor)
-        nborToShared[*nbor]++;
-    }
-    m->end(it);
+    std::vector<int> parts;
+    std::vector<size_t> counts;
+    m->getNeighbors(0, parts, counts);
+    for(size_t i=0; i<parts.size(); i++)
+      nborToShared[parts[i]] = TO_INT(counts[i]);
+    if( m->count(0) )
+      nborToShared[PCU_Comm_Self()] = TO_INT(m->count(0));
   }
 }
 
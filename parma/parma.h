@@ -333,6 +333,9 @@ int Parma_MisNumbering(apf::Mesh* m, int d);
 /**
  * @brief reorder the mesh via a breadth first search
  * @remark the returned tag has the reordered vertex order
+ * @remark the search breaks ties in iteration order, so an MDS mesh
+ *         first reordered with apf::reorderMdsMeshSFC gives it a
+ *         spatially coherent starting point at little cost
  * @param m (In) partitioned mesh
  * @param verbosity (In) output control, higher values output more
  * @return apf mesh tag
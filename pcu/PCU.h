@@ -51,6 +51,11 @@ PCU_Comm_Unpack(&(object),sizeof(object))
   above API on/off*/
 void PCU_Comm_Order(bool on);
 
+/*restricts the above API to a fixed
+  set of neighbors, without barriers*/
+void PCU_Comm_Neighbors(int n, const int* ranks);
+void PCU_Comm_Free_Neighbors(void);
+
 /*collective operations*/
 void PCU_Barrier(void);
 void PCU_Add_Doubles(double* p, size_t n);
@@ -77,6 +82,8 @@ void PCU_Min_Ints(int* p, size_t n);
 int PCU_Min_Int(int x);
 void PCU_Max_Ints(int* p, size_t n);
 int PCU_Max_Int(int x);
+void PCU_Max_Longs(long* p, size_t n);
+long PCU_Max_Long(long x);
 int PCU_Or(int c);
 int PCU_And(int c);
 
@@ -105,6 +112,19 @@ int PCU_Comm_Packed(int to_rank, size_t* size);
 int PCU_Comm_From(int* from_rank);
 int PCU_Comm_Received(size_t* size);
 void* PCU_Comm_Extract(size_t size);
+
+/*lock-free packing from several threads,
+  merged in thread order by PCU_Comm_Send*/
+void PCU_Comm_Pack_Threads(int nthreads);
+int PCU_Comm_Thread_Pack(int thread, int to_rank, const void* data,
+    size_t size);
+#define PCU_COMM_THREAD_PACK(thread,to_rank,object)\
+PCU_Comm_Thread_Pack(thread,to_rank,&(object),sizeof(object))
+
+/*in-place packing and unpacking*/
+void* PCU_Comm_Reserve(int to_rank, size_t size);
+void PCU_Comm_Commit(int to_rank, size_t size);
+void* PCU_Comm_Span(size_t* size);
 int PCU_Comm_Rank(int* rank);
 int PCU_Comm_Size(int* size);
 
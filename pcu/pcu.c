@@ -236,6 +236,38 @@ void PCU_Comm_Order(bool on)
   }
 }
 
+/** \brief Restricts communication phases to a fixed set of neighbors.
+  \details This function must be called by all ranks between phases.
+  Afterwards, each rank may only pack data for the \a n ranks
+  in \a ranks, and every phase exchanges exactly one message
+  with each neighbor, empty ones not being received by the user.
+  This lets phases end without the barriers that ordinary phases
+  need, which pays off when the same neighbors communicate over
+  and over, as parts sharing a boundary do.
+  The neighbors need not be symmetric; this call finds out which
+  ranks will be sending to this one with one ordinary phase.
+  It stays in effect until PCU_Comm_Free_Neighbors is called.
+ */
+void PCU_Comm_Neighbors(int n, const int* ranks)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Neighbors called before Comm_Init");
+  for (int i = 0; i < n; ++i)
+    if ((ranks[i] < 0)||(ranks[i] >= pcu_mpi_size()))
+      reel_fail("Invalid rank in Comm_Neighbors");
+  pcu_msg_set_neighbors(get_msg(), n, ranks);
+}
+
+/** \brief Returns to phases that may communicate with any rank.
+  \details This function must be called by all ranks between phases.
+ */
+void PCU_Comm_Free_Neighbors(void)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Free_Neighbors called before Comm_Init");
+  pcu_msg_free_neighbors(get_msg());
+}
+
 /** \brief Blocking barrier over all threads. */
 void PCU_Barrier(void)
 {
@@ -467,6 +499,23 @@ int PCU_Max_Int(int x)
   return a[0];
 }
 
+/** \brief Performs an Allreduce maximum of long integers
+  */
+void PCU_Max_Longs(long* p, size_t n)
+{
+  if (global_state == uninit)
+    reel_fail("Max_Longs called before Comm_Init");
+  pcu_allreduce(&(get_msg()->coll),pcu_max_longs,p,n*sizeof(long));
+}
+
+long PCU_Max_Long(long x)
+{
+  long a[1];
+  a[0] = x;
+  PCU_Max_Longs(a, 1);
+  return a[0];
+}
+
 /** \brief Performs a parallel logical OR reduction
   */
 int PCU_Or(int c)
@@ -675,6 +724,89 @@ void* PCU_Comm_Extract(size_t size)
   return pcu_msg_unpack(m,size);
 }
 
+/** \brief Prepares for packing from \a nthreads threads of this process.
+  \details This function should be called once per phase, after
+  PCU_Comm_Begin and outside of the threaded region.
+  Each thread then packs with PCU_Comm_Thread_Pack into its own
+  buffers, so no locks are taken.
+  PCU_Comm_Send appends the data of each thread after the data
+  packed by PCU_Comm_Pack, in order of thread index, so messages
+  are deterministic as long as each thread packs the same data.
+  PCU_Comm_Pack and PCU_Comm_Send must not be called from threads.
+ */
+void PCU_Comm_Pack_Threads(int nthreads)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Pack_Threads called before Comm_Init");
+  pcu_msg_threads(get_msg(),nthreads);
+}
+
+/** \brief Packs data to be sent to \a to_rank from thread \a thread.
+  \details \a thread is an index from 0 to the number of threads given
+  to PCU_Comm_Pack_Threads, and no two threads may use the same index
+  at the same time.
+  Otherwise, this behaves like PCU_Comm_Pack.
+ */
+int PCU_Comm_Thread_Pack(int thread, int to_rank, const void* data,
+    size_t size)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Thread_Pack called before Comm_Init");
+  if ((to_rank < 0)||(to_rank >= pcu_mpi_size()))
+    reel_fail("Invalid rank in Comm_Thread_Pack");
+  memcpy(pcu_msg_thread_pack(get_msg(),thread,to_rank,size),data,size);
+  return PCU_SUCCESS;
+}
+
+/** \brief Reserves space at the end of the buffer being sent to \a to_rank.
+  \details This function makes room for at least \a size more bytes in
+  the buffer being sent to \a to_rank and returns a pointer to that room,
+  into which the user may write directly instead of calling PCU_Comm_Pack
+  for each item.
+  Nothing is sent until the written bytes are given to PCU_Comm_Commit.
+  The pointer is invalidated by the next call that packs for \a to_rank.
+  Reserving once for many items also saves PCU_Comm_Pack from
+  growing the buffer repeatedly.
+ */
+void* PCU_Comm_Reserve(int to_rank, size_t size)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Reserve called before Comm_Init");
+  if ((to_rank < 0)||(to_rank >= pcu_mpi_size()))
+    reel_fail("Invalid rank in Comm_Reserve");
+  return pcu_msg_reserve(get_msg(),to_rank,size);
+}
+
+/** \brief Appends \a size bytes written after PCU_Comm_Reserve.
+  \details \a size must not exceed what was reserved for \a to_rank.
+ */
+void PCU_Comm_Commit(int to_rank, size_t size)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Commit called before Comm_Init");
+  if ((to_rank < 0)||(to_rank >= pcu_mpi_size()))
+    reel_fail("Invalid rank in Comm_Commit");
+  pcu_msg_commit(get_msg(),to_rank,size);
+}
+
+/** \brief Returns the rest of the current received buffer in place.
+  \details This function should be called after a successful PCU_Comm_Receive.
+  It returns a pointer to the data not yet unpacked and sets * \a size
+  to the number of those bytes, without unpacking anything.
+  Users who read from it should then call PCU_Comm_Extract with
+  the number of bytes they read, so that unpacking continues after them.
+  The returned pointer must not be freed by the user.
+ */
+void* PCU_Comm_Span(size_t* size)
+{
+  if (global_state == uninit)
+    reel_fail("Comm_Span called before Comm_Init");
+  pcu_msg* m = get_msg();
+  if (m->order)
+    return pcu_order_span(m->order,size);
+  return pcu_msg_span(m,size);
+}
+
 /** \brief Reinitializes PCU with a new MPI communicator.
  \details All of PCU's logic is based off two duplicates
  of this communicator, so you can safely get PCU to act
@@ -686,6 +818,8 @@ void PCU_Switch_Comm(MPI_Comm new_comm)
 {
   if (global_state == uninit)
     reel_fail("Switch_Comm called before Comm_Init");
+  /* neighbor ranks refer to the old communicator */
+  pcu_msg_free_neighbors(get_msg());
   pcu_pmpi_switch(new_comm);
 }
 
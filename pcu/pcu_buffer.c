@@ -24,19 +24,33 @@ void pcu_free_buffer(pcu_buffer* b)
   noto_free(b->start);
 }
 
-void* pcu_push_buffer(pcu_buffer* b, size_t size)
+void* pcu_reserve_buffer(pcu_buffer* b, size_t size)
 {
-  b->size += size;
-  if (b->size > b->capacity)
+  size_t needed = b->size + size;
+  if (needed > b->capacity)
   {
     //this growth formula is from git's cache.h alloc_nr
     size_t min_growth = ((b->capacity + 16)*3)/2;
-    b->capacity = b->size;
+    b->capacity = needed;
     if (min_growth > b->capacity)
       b->capacity = min_growth;
     b->start = noto_realloc(b->start, b->capacity);
   }
-  return b->start + b->size - size;
+  return b->start + b->size;
+}
+
+void pcu_commit_buffer(pcu_buffer* b, size_t size)
+{
+  if (b->size + size > b->capacity)
+    reel_fail("pcu_commit_buffer: committed more than was reserved");
+  b->size += size;
+}
+
+void* pcu_push_buffer(pcu_buffer* b, size_t size)
+{
+  void* at = pcu_reserve_buffer(b, size);
+  b->size += size;
+  return at;
 }
 
 void pcu_begin_buffer(pcu_buffer* b)
@@ -53,6 +67,12 @@ void* pcu_walk_buffer(pcu_buffer* b, size_t size)
   return at;
 }
 
+void* pcu_buffer_rest(pcu_buffer* b, size_t* size)
+{
+  *size = b->capacity - b->size;
+  return b->start + b->size;
+}
+
 bool pcu_buffer_walked(pcu_buffer* b)
 {
   return b->size == b->capacity;
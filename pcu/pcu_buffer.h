@@ -22,9 +22,12 @@ typedef struct
 
 void pcu_make_buffer(pcu_buffer* b);
 void pcu_free_buffer(pcu_buffer* b);
+void* pcu_reserve_buffer(pcu_buffer* b, size_t size);
+void pcu_commit_buffer(pcu_buffer* b, size_t size);
 void* pcu_push_buffer(pcu_buffer* b, size_t size);
 void pcu_begin_buffer(pcu_buffer* b);
 void* pcu_walk_buffer(pcu_buffer* b, size_t size);
+void* pcu_buffer_rest(pcu_buffer* b, size_t* size);
 bool pcu_buffer_walked(pcu_buffer* b);
 void pcu_resize_buffer(pcu_buffer* b, size_t size);
 void pcu_set_buffer(pcu_buffer* b, void* p, size_t size);
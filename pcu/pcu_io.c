@@ -16,69 +16,152 @@
 #include <string.h>
 #include <stdlib.h>
 #include "pcu_util.h"
+#include "pcu_buffer.h"
 #include <sys/types.h>
 #include <limits.h>
 
 #ifdef PCU_BZIP
 #include <bzlib.h>
 #endif
+#ifdef PCU_ZSTD
+#include <zstd.h>
+#endif
+#ifdef PCU_LZ4
+#include <lz4frame.h>
+#endif
+
+typedef struct pcu_codec pcu_codec;
 
 typedef struct pcu_file {
   FILE* f;
-#ifdef PCU_BZIP
-  BZFILE* bzf;
-#endif
+  pcu_codec const* codec;
+  void* state;
+  pcu_buffer mem;
+  bool memory;
+  bool borrowed;
   bool write;
-  bool compress;
 } pcu_file;
 
+/* a codec streams the bytes of a file through pf->f,
+   keeping whatever it needs between calls in pf->state.
+   Codecs that were not compiled in have no functions. */
+struct pcu_codec {
+  const char* ext;
+  const char* option;
+  void (*open)(pcu_file* pf);
+  void (*read)(pcu_file* pf, void* data, size_t size);
+  void (*write)(pcu_file* pf, void const* data, size_t size);
+  void (*close)(pcu_file* pf);
+};
+
+static void raw_open(pcu_file* pf)
+{
+  (void)pf;
+}
+
+static void raw_read(pcu_file* pf, void* data, size_t size)
+{
+  if (size != fread(data, 1, size, pf->f))
+    reel_fail("fread(%p, %lu, %p) failed", data, size, (void*) pf->f);
+}
+
+static void raw_write(pcu_file* pf, void const* data, size_t size)
+{
+  if (size != fwrite(data, 1, size, pf->f))
+    reel_fail("fwrite(%p, %lu, %p) failed", data, size, (void*) pf->f);
+}
+
+static void raw_close(pcu_file* pf)
+{
+  (void)pf;
+}
+
+#if defined(PCU_ZSTD) || defined(PCU_LZ4)
+
+/* a fixed buffer of compressed bytes. Writers compress into it
+   and write it out, readers fill it from the file and decode
+   from pos up to size. */
+typedef struct {
+  char* data;
+  size_t capacity;
+  size_t size;
+  size_t pos;
+} pcu_window;
+
+static void make_window(pcu_window* w, size_t capacity)
+{
+  w->data = noto_malloc(capacity);
+  w->capacity = capacity;
+  w->size = 0;
+  w->pos = 0;
+}
+
+static void free_window(pcu_window* w)
+{
+  noto_free(w->data);
+}
+
+/* decoders may hold output of input they already took,
+   so they call this only when they made no progress */
+static void fill_window(pcu_file* pf, pcu_window* w)
+{
+  if (w->pos < w->size)
+    return;
+  w->size = fread(w->data, 1, w->capacity, pf->f);
+  w->pos = 0;
+  if (!w->size)
+    reel_fail("pcu: unexpected end of compressed file");
+}
+
+#endif
+
 #ifdef PCU_BZIP
 
-static void open_compressed_read(pcu_file* pf)
+static void bzip2_open_read(pcu_file* pf)
 {
   int bzerror;
   int verbosity = 0;
   int small = 0;
   void* unused = NULL;
   int nUnused = 0;
-  pf->bzf = BZ2_bzReadOpen(&bzerror, pf->f, verbosity, small, unused, nUnused);
+  pf->state = BZ2_bzReadOpen(&bzerror, pf->f, verbosity, small, unused, nUnused);
   if (bzerror != BZ_OK)
     reel_fail("BZ2_bzReadOpen failed with code %d", bzerror);
 }
 
-static void open_compressed_write(pcu_file* pf)
+static void bzip2_open_write(pcu_file* pf)
 {
   int bzerror;
   int verbosity = 0;
   int blockSize100k = 9;
   int workFactor = 30;
-  pf->bzf = BZ2_bzWriteOpen(&bzerror, pf->f, blockSize100k, verbosity, workFactor);
+  pf->state = BZ2_bzWriteOpen(&bzerror, pf->f, blockSize100k, verbosity, workFactor);
   if (bzerror != BZ_OK)
     reel_fail("BZ2_bzWriteOpen failed with code %d", bzerror);
 }
 
-static void open_compressed(pcu_file* pf)
+static void bzip2_open(pcu_file* pf)
 {
   if (pf->write)
-    open_compressed_write(pf);
+    bzip2_open_write(pf);
   else
-    open_compressed_read(pf);
+    bzip2_open_read(pf);
 }
 
-static void compressed_read(pcu_file* pf, void* data, size_t size)
+static void bzip2_read(pcu_file* pf, void* data, size_t size)
 {
   int bzerror;
   int len;
   int rv;
   PCU_ALWAYS_ASSERT(size < INT_MAX);
   len = size;
-  rv = BZ2_bzRead(&bzerror, pf->bzf, data, len);
+  rv = BZ2_bzRead(&bzerror, pf->state, data, len);
   if (bzerror != BZ_OK && bzerror != BZ_STREAM_END)
     reel_fail("BZ2_bzRead failed with code %d", bzerror);
   PCU_ALWAYS_ASSERT(rv == len);
 }
 
-static void compressed_write(pcu_file* pf, void const* data, size_t size)
+static void bzip2_write(pcu_file* pf, void const* data, size_t size)
 {
   int bzerror;
   int len;
@@ -86,70 +169,250 @@ static void compressed_write(pcu_file* pf, void const* data, size_t size)
   PCU_ALWAYS_ASSERT(size < INT_MAX);
   len = size;
   bzip2_is_not_const_correct = (void*)data;
-  BZ2_bzWrite(&bzerror, pf->bzf, bzip2_is_not_const_correct, len);
+  BZ2_bzWrite(&bzerror, pf->state, bzip2_is_not_const_correct, len);
   if (bzerror != BZ_OK)
     reel_fail("BZ2_bzWrite failed with code %d", bzerror);
 }
 
-static void close_compressed_read(pcu_file* pf)
+static void bzip2_close_read(pcu_file* pf)
 {
   int bzerror;
-  BZ2_bzReadClose(&bzerror, pf->bzf);
+  BZ2_bzReadClose(&bzerror, pf->state);
   if (bzerror != BZ_OK)
     reel_fail("BZ2_readClose failed with code %d", bzerror);
 }
 
-static void close_compressed_write(pcu_file* pf)
+static void bzip2_close_write(pcu_file* pf)
 {
   int bzerror;
   int abandon = 0;
   unsigned* nbytes_in = NULL;
   unsigned* nbytes_out = NULL;
-  BZ2_bzWriteClose(&bzerror, pf->bzf, abandon, nbytes_in, nbytes_out);
+  BZ2_bzWriteClose(&bzerror, pf->state, abandon, nbytes_in, nbytes_out);
   if (bzerror != BZ_OK)
     reel_fail("BZ2_writeClose failed with code %d", bzerror);
 }
 
-static void close_compressed(pcu_file* pf)
+static void bzip2_close(pcu_file* pf)
 {
   if (pf->write)
-    close_compressed_write(pf);
+    bzip2_close_write(pf);
   else
-    close_compressed_read(pf);
+    bzip2_close_read(pf);
 }
 
+#define PCU_BZIP2_CODEC bzip2_open, bzip2_read, bzip2_write, bzip2_close
 #else
+#define PCU_BZIP2_CODEC NULL, NULL, NULL, NULL
+#endif
+
+#ifdef PCU_ZSTD
+
+/* level 1 is the fast end of zstd, which still
+   compresses SMB files better than it can be read from disk */
+enum { PCU_ZSTD_LEVEL = 1 };
+
+typedef struct {
+  ZSTD_CCtx* cctx;
+  ZSTD_DCtx* dctx;
+  pcu_window window;
+} zstd_state;
 
-static void open_compressed(pcu_file* pf)
+static void zstd_check(size_t code, const char* what)
 {
-  (void)pf;
-  reel_fail("recompile PCU with -DPCU_COMPRESS=ON");
+  if (ZSTD_isError(code))
+    reel_fail("%s failed: %s", what, ZSTD_getErrorName(code));
 }
 
-static void compressed_read(pcu_file* pf, void* data, size_t size)
+static void zstd_open(pcu_file* pf)
 {
-  (void)pf;
-  (void)data;
-  (void)size;
-  reel_fail("recompile PCU with -DPCU_COMPRESS=ON");
+  zstd_state* s = noto_malloc(sizeof(zstd_state));
+  s->cctx = NULL;
+  s->dctx = NULL;
+  if (pf->write) {
+    s->cctx = ZSTD_createCCtx();
+    zstd_check(ZSTD_CCtx_setParameter(s->cctx, ZSTD_c_compressionLevel,
+          PCU_ZSTD_LEVEL), "ZSTD_CCtx_setParameter");
+    make_window(&s->window, ZSTD_CStreamOutSize());
+  } else {
+    s->dctx = ZSTD_createDCtx();
+    make_window(&s->window, ZSTD_DStreamInSize());
+  }
+  pf->state = s;
 }
 
-static void compressed_write(pcu_file* pf, void const* data, size_t size)
+/* compresses into the window and writes it out until zstd
+   has taken all of the input and, when ending, flushed */
+static void zstd_stream(pcu_file* pf, void const* data, size_t size,
+    ZSTD_EndDirective mode)
 {
-  (void)pf;
-  (void)data;
-  (void)size;
-  reel_fail("recompile PCU with -DPCU_COMPRESS=ON");
+  zstd_state* s = pf->state;
+  ZSTD_inBuffer in = {data, size, 0};
+  size_t left;
+  do {
+    ZSTD_outBuffer out = {s->window.data, s->window.capacity, 0};
+    left = ZSTD_compressStream2(s->cctx, &out, &in, mode);
+    zstd_check(left, "ZSTD_compressStream2");
+    raw_write(pf, out.dst, out.pos);
+  } while (in.pos < in.size || (mode == ZSTD_e_end && left));
 }
 
-static void close_compressed(pcu_file* pf)
+static void zstd_write(pcu_file* pf, void const* data, size_t size)
 {
-  (void)pf;
-  reel_fail("recompile PCU with -DPCU_COMPRESS=ON");
+  zstd_stream(pf, data, size, ZSTD_e_continue);
+}
+
+static void zstd_read(pcu_file* pf, void* data, size_t size)
+{
+  zstd_state* s = pf->state;
+  ZSTD_outBuffer out = {data, size, 0};
+  while (out.pos < out.size) {
+    ZSTD_inBuffer in = {s->window.data, s->window.size, s->window.pos};
+    size_t before = out.pos;
+    zstd_check(ZSTD_decompressStream(s->dctx, &out, &in),
+        "ZSTD_decompressStream");
+    s->window.pos = in.pos;
+    if (out.pos == before)
+      fill_window(pf, &s->window);
+  }
 }
 
+static void zstd_close(pcu_file* pf)
+{
+  zstd_state* s = pf->state;
+  if (pf->write) {
+    zstd_stream(pf, NULL, 0, ZSTD_e_end);
+    ZSTD_freeCCtx(s->cctx);
+  } else {
+    ZSTD_freeDCtx(s->dctx);
+  }
+  free_window(&s->window);
+  noto_free(s);
+}
+
+#define PCU_ZSTD_CODEC zstd_open, zstd_read, zstd_write, zstd_close
+#else
+#define PCU_ZSTD_CODEC NULL, NULL, NULL, NULL
 #endif
 
+#ifdef PCU_LZ4
+
+/* input is fed to LZ4F in pieces of at most this size
+   so the output window has a fixed bound */
+enum { PCU_LZ4_CHUNK = 64 * 1024 };
+
+typedef struct {
+  LZ4F_cctx* cctx;
+  LZ4F_dctx* dctx;
+  LZ4F_preferences_t prefs;
+  pcu_window window;
+} lz4_state;
+
+static void lz4_check(size_t code, const char* what)
+{
+  if (LZ4F_isError(code))
+    reel_fail("%s failed: %s", what, LZ4F_getErrorName(code));
+}
+
+static void lz4_open(pcu_file* pf)
+{
+  lz4_state* s = noto_malloc(sizeof(lz4_state));
+  s->cctx = NULL;
+  s->dctx = NULL;
+  memset(&s->prefs, 0, sizeof(s->prefs));
+  if (pf->write) {
+    lz4_check(LZ4F_createCompressionContext(&s->cctx, LZ4F_VERSION),
+        "LZ4F_createCompressionContext");
+    make_window(&s->window, LZ4F_compressBound(PCU_LZ4_CHUNK, &s->prefs)
+        + LZ4F_HEADER_SIZE_MAX);
+    size_t out = LZ4F_compressBegin(s->cctx, s->window.data,
+        s->window.capacity, &s->prefs);
+    lz4_check(out, "LZ4F_compressBegin");
+    raw_write(pf, s->window.data, out);
+  } else {
+    lz4_check(LZ4F_createDecompressionContext(&s->dctx, LZ4F_VERSION),
+        "LZ4F_createDecompressionContext");
+    make_window(&s->window, PCU_LZ4_CHUNK);
+  }
+  pf->state = s;
+}
+
+static void lz4_write(pcu_file* pf, void const* data, size_t size)
+{
+  lz4_state* s = pf->state;
+  char const* p = data;
+  while (size) {
+    size_t n = size < PCU_LZ4_CHUNK ? size : PCU_LZ4_CHUNK;
+    size_t out = LZ4F_compressUpdate(s->cctx, s->window.data,
+        s->window.capacity, p, n, NULL);
+    lz4_check(out, "LZ4F_compressUpdate");
+    raw_write(pf, s->window.data, out);
+    p += n;
+    size -= n;
+  }
+}
+
+static void lz4_read(pcu_file* pf, void* data, size_t size)
+{
+  lz4_state* s = pf->state;
+  char* p = data;
+  while (size) {
+    size_t out = size;
+    size_t in = s->window.size - s->window.pos;
+    lz4_check(LZ4F_decompress(s->dctx, p, &out,
+          s->window.data + s->window.pos, &in, NULL), "LZ4F_decompress");
+    s->window.pos += in;
+    p += out;
+    size -= out;
+    if (!out)
+      fill_window(pf, &s->window);
+  }
+}
+
+static void lz4_close(pcu_file* pf)
+{
+  lz4_state* s = pf->state;
+  if (pf->write) {
+    size_t out = LZ4F_compressEnd(s->cctx, s->window.data,
+        s->window.capacity, NULL);
+    lz4_check(out, "LZ4F_compressEnd");
+    raw_write(pf, s->window.data, out);
+    LZ4F_freeCompressionContext(s->cctx);
+  } else {
+    LZ4F_freeDecompressionContext(s->dctx);
+  }
+  free_window(&s->window);
+  noto_free(s);
+}
+
+#define PCU_LZ4_CODEC lz4_open, lz4_read, lz4_write, lz4_close
+#else
+#define PCU_LZ4_CODEC NULL, NULL, NULL, NULL
+#endif
+
+enum { PCU_RAW, PCU_BZIP2, PCU_ZSTD_FILE, PCU_LZ4_FILE, PCU_CODECS };
+
+static pcu_codec const pcu_codecs[PCU_CODECS] = {
+  {"", "", raw_open, raw_read, raw_write, raw_close},
+  {".bz2", "PCU_COMPRESS", PCU_BZIP2_CODEC},
+  {".zst", "PCU_ZSTD", PCU_ZSTD_CODEC},
+  {".lz4", "PCU_LZ4", PCU_LZ4_CODEC}
+};
+
+/* the file extension picks the codec. Files without one of
+   the codec extensions are bzip2 if compress is set,
+   which is what the "bz2:" prefix of SMB paths does. */
+static pcu_codec const* find_codec(const char* path, bool compress)
+{
+  size_t lp = strlen(path);
+  for (int i = 1; i < PCU_CODECS; ++i) {
+    size_t le = strlen(pcu_codecs[i].ext);
+    if (lp >= le && !strcmp(path + lp - le, pcu_codecs[i].ext))
+      return &pcu_codecs[i];
+  }
+  return &pcu_codecs[compress ? PCU_BZIP2 : PCU_RAW];
+}
+
 /**
  * brief limit the number of ranks that can call fopen simultaneously
  * remark Argonne's GPFS filesystem is failing to open some files when
@@ -184,22 +447,32 @@ FILE* pcu_group_open(const char* path, bool write) {
 pcu_file* pcu_fopen(const char* name, bool write, bool compress)
 {
   pcu_file* pf = (pcu_file*) malloc(sizeof(pcu_file));
-  pf->compress = compress;
+  pf->codec = find_codec(name, compress);
+  if (!pf->codec->open)
+    reel_fail("recompile PCU with -D%s=ON to use \"%s\"",
+        pf->codec->option, name);
+  pf->state = NULL;
   pf->write = write;
+  pf->memory = false;
+  pf->borrowed = false;
   pf->f = pcu_group_open(name, write);
   if (!pf->f) {
     perror("pcu_fopen");
     reel_fail("pcu_fopen couldn't open \"%s\"", name);
   }
-  if(compress)
-    open_compressed(pf);
+  pf->codec->open(pf);
   return pf;
 }
 
 void pcu_fclose(pcu_file* pf)
 {
-  if (pf->compress)
-    close_compressed(pf);
+  if (pf->memory) {
+    if (!pf->borrowed)
+      pcu_free_buffer(&pf->mem);
+    free(pf);
+    return;
+  }
+  pf->codec->close(pf);
   fclose(pf->f);
   free(pf);
 }
@@ -208,24 +481,20 @@ void pcu_fwrite(void const* p, size_t size, size_t nmemb, pcu_file * f)
 {
   if (!f->write)
     reel_fail("pcu_fwrite: file not opened for writing.");
-  if (f->compress) {
-    compressed_write(f, p, size * nmemb);
-  } else {
-    if (nmemb != fwrite(p, size, nmemb, f->f))
-      reel_fail("fwrite(%p, %lu, %lu, %p) failed", p, size, nmemb, (void*) f->f);
-  }
+  if (f->memory)
+    memcpy(pcu_push_buffer(&f->mem, size * nmemb), p, size * nmemb);
+  else
+    f->codec->write(f, p, size * nmemb);
 }
 
 void pcu_fread(void* p, size_t size, size_t nmemb, pcu_file * f)
 {
   if (f->write)
     reel_fail("pcu_fread: file not opened for reading.");
-  if (f->compress) {
-    compressed_read(f, p, size * nmemb);
-  } else {
-    if (nmemb != fread(p, size, nmemb, f->f))
-      reel_fail("fread(%p, %lu, %lu, %p) failed", p, size, nmemb, (void*) f->f);
-  }
+  if (f->memory)
+    memcpy(p, pcu_walk_buffer(&f->mem, size * nmemb), size * nmemb);
+  else
+    f->codec->read(f, p, size * nmemb);
 }
 
 void pcu_read(pcu_file* f, char* p, size_t n)
@@ -362,3 +631,161 @@ FILE* pcu_open_parallel(const char* prefix, const char* ext)
   noto_free(path);
   return file;
 }
+
+pcu_file* pcu_mem_open(void)
+{
+  pcu_file* pf = (pcu_file*) malloc(sizeof(pcu_file));
+  pf->f = NULL;
+  pf->codec = &pcu_codecs[PCU_RAW];
+  pf->state = NULL;
+  pf->write = true;
+  pf->memory = true;
+  pf->borrowed = false;
+  pcu_make_buffer(&pf->mem);
+  return pf;
+}
+
+pcu_file* pcu_mem_read(void* data, size_t size)
+{
+  pcu_file* pf = (pcu_file*) malloc(sizeof(pcu_file));
+  pf->f = NULL;
+  pf->codec = &pcu_codecs[PCU_RAW];
+  pf->state = NULL;
+  pf->write = false;
+  pf->memory = true;
+  pf->borrowed = true;
+  pcu_set_buffer(&pf->mem, data, size);
+  pcu_begin_buffer(&pf->mem);
+  return pf;
+}
+
+/* a container holds the files of all parts in one file, so that
+   large part counts do not create one file per part.
+   In the same big endian encoding as the rest of this file it is:
+     magic, version, part count     (three uint64_t)
+     offsets of parts 0 to n        (n + 1 uint64_t)
+     the bytes of each part, in order
+   so part i is the byte range [offset i, offset i+1) and can be
+   read without touching the others. */
+enum {
+  PCU_CONTAINER_MAGIC = 0x70637563,
+  PCU_CONTAINER_VERSION = 1,
+  PCU_CONTAINER_HEADER = 3
+};
+
+/* MPI counts are int, so bigger ranges take several collective calls */
+#define PCU_CONTAINER_CHUNK (1 << 30)
+
+static void encode_uint64s(uint64_t* p, size_t n)
+{
+  if (PCU_ENDIANNESS != PCU_ENCODED_ENDIAN)
+    for (size_t i = 0; i < n; ++i)
+      pcu_swap_64((uint32_t*)(p + i));
+}
+
+static MPI_File open_container(const char* path, bool write)
+{
+  MPI_File fh;
+  int mode = write ? (MPI_MODE_WRONLY | MPI_MODE_CREATE) : MPI_MODE_RDONLY;
+  if (MPI_SUCCESS != MPI_File_open(PCU_Get_Comm(), (char*)path, mode,
+        MPI_INFO_NULL, &fh))
+    reel_fail("pcu: could not open container \"%s\"", path);
+  if (write)
+    MPI_File_set_size(fh, 0);
+  return fh;
+}
+
+/* collective: every rank moves its own range, which may be empty */
+static void transfer_all(MPI_File fh, MPI_Offset at, void* data,
+    uint64_t size, bool write)
+{
+  char* p = data;
+  long chunks = (size + PCU_CONTAINER_CHUNK - 1) / PCU_CONTAINER_CHUNK;
+  chunks = PCU_Max_Long(chunks);
+  for (long i = 0; i < chunks; ++i) {
+    int n = PCU_CONTAINER_CHUNK;
+    if (size < (uint64_t)n)
+      n = size;
+    int err;
+    if (write)
+      err = MPI_File_write_at_all(fh, at, p, n, MPI_BYTE, MPI_STATUS_IGNORE);
+    else
+      err = MPI_File_read_at_all(fh, at, p, n, MPI_BYTE, MPI_STATUS_IGNORE);
+    if (err != MPI_SUCCESS)
+      reel_fail("pcu: container %s of %d bytes failed",
+          write ? "write" : "read", n);
+    at += n;
+    p += n;
+    size -= n;
+  }
+}
+
+void pcu_write_container(const char* path, pcu_file* f)
+{
+  uint64_t index[PCU_CONTAINER_HEADER + 2];
+  int self = PCU_Comm_Self();
+  int peers = PCU_Comm_Peers();
+  if (!(f->memory && f->write))
+    reel_fail("pcu_write_container: file not opened by pcu_mem_open");
+  uint64_t size = f->mem.size;
+  uint64_t offset = sizeof(uint64_t) * (PCU_CONTAINER_HEADER + peers + 1);
+  offset += PCU_Exscan_Long(size);
+  /* each rank writes its own index entry, rank 0 the header before it
+     and the last rank the end of the data after it */
+  int n = 0;
+  MPI_Offset at = sizeof(uint64_t) * (PCU_CONTAINER_HEADER + self);
+  if (!self) {
+    index[n++] = PCU_CONTAINER_MAGIC;
+    index[n++] = PCU_CONTAINER_VERSION;
+    index[n++] = peers;
+    at = 0;
+  }
+  index[n++] = offset;
+  if (self == peers - 1)
+    index[n++] = offset + size;
+  encode_uint64s(index, n);
+  MPI_File fh = open_container(path, true);
+  transfer_all(fh, at, index, n * sizeof(uint64_t), true);
+  transfer_all(fh, offset, f->mem.start, size, true);
+  MPI_File_close(&fh);
+  pcu_fclose(f);
+}
+
+pcu_file* pcu_read_container(const char* path, int part)
+{
+  uint64_t header[PCU_CONTAINER_HEADER];
+  uint64_t range[2] = {0,0};
+  MPI_File fh = open_container(path, false);
+  transfer_all(fh, 0, header, sizeof(header), false);
+  encode_uint64s(header, PCU_CONTAINER_HEADER);
+  if (header[0] != PCU_CONTAINER_MAGIC)
+    reel_fail("pcu: \"%s\" is not a container", path);
+  if (header[1] > PCU_CONTAINER_VERSION)
+    reel_fail("pcu: container \"%s\" has unknown version %lu",
+        path, (unsigned long)header[1]);
+  if (part >= 0 && (uint64_t)part >= header[2])
+    reel_fail("pcu: container \"%s\" has %lu parts, part %d requested",
+        path, (unsigned long)header[2], part);
+  /* ranks with a negative part take part in the collectives only */
+  if (part >= 0) {
+    MPI_Offset at = sizeof(uint64_t) * (PCU_CONTAINER_HEADER + part);
+    transfer_all(fh, at, range, sizeof(range), false);
+  } else {
+    transfer_all(fh, 0, range, 0, false);
+  }
+  encode_uint64s(range, 2);
+  uint64_t size = range[1] - range[0];
+  void* data = noto_malloc(size);
+  transfer_all(fh, range[0], data, size, false);
+  MPI_File_close(&fh);
+  pcu_file* pf = (pcu_file*) malloc(sizeof(pcu_file));
+  pf->f = NULL;
+  pf->codec = &pcu_codecs[PCU_RAW];
+  pf->state = NULL;
+  pf->write = false;
+  pf->memory = true;
+  pf->borrowed = false;
+  pcu_set_buffer(&pf->mem, data, size);
+  pcu_begin_buffer(&pf->mem);
+  return pf;
+}
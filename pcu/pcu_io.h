@@ -34,6 +34,14 @@ void pcu_write_doubles(struct pcu_file* f, double* p, size_t n);
 void pcu_read_string(struct pcu_file* f, char** p);
 void pcu_write_string(struct pcu_file* f, const char* p);
 
+/* in-memory files and the single-file containers they fill,
+   which are read and written collectively with MPI-IO.
+   pcu_mem_read reads from memory that stays owned by the caller. */
+struct pcu_file* pcu_mem_open(void);
+struct pcu_file* pcu_mem_read(void* data, size_t size);
+void pcu_write_container(const char* path, struct pcu_file* f);
+struct pcu_file* pcu_read_container(const char* path, int part);
+
 FILE* pcu_open_parallel(const char* prefix, const char* ext);
 FILE* pcu_group_open(const char* path, bool write);
 
@@ -12,6 +12,7 @@
 #include "noto_malloc.h"
 #include "reel.h"
 #include <string.h>
+#include <stdlib.h>
 
 /* the pcu_msg algorithm for a communication phase
    is as follows:
@@ -50,8 +51,29 @@
    If another rank is notified first and quickly goes on to
    a new phase, it may be able to send a message that is
    received by the slow rank out-of-phase.
+
+   When the phase is restricted to a fixed graph of neighbors
+   (pcu_msg_set_neighbors), the algorithm is instead:
+
+1  pack data to be sent
+2  requests = send one message to each out-neighbor,
+   empty if nothing was packed for it
+3  while (some in-neighbor has not been received from)
+4    receive and process data from those in-neighbors
+5  wait for requests
+
+   Knowing how many messages to expect replaces the barrier
+   at line 6 above. Receiving only from a specific in-neighbor
+   that has not yet been received from in this phase replaces
+   the barrier at line 1: MPI does not let messages between
+   two ranks overtake each other, so the first message from
+   that in-neighbor belongs to this phase.
+   These messages use their own tag so that a rank still
+   in an ordinary phase cannot receive them.
 */
 
+#define PCU_NEIGHBOR_TAG 1
+
 //enumeration for pcu_msg.state
 enum {
   idle_state, //in between phases
@@ -62,7 +84,6 @@ enum {
 
 static void make_comm(pcu_msg* m)
 {
-  pcu_make_aa(&(m->peers));
   pcu_make_message(&(m->received));
   m->state = idle_state;
 }
@@ -70,107 +91,173 @@ static void make_comm(pcu_msg* m)
 void pcu_make_msg(pcu_msg* m)
 {
   make_comm(m);
+  pcu_make_peers(&(m->peers));
+  m->threads = NULL;
+  m->nthreads = 0;
+  m->neighbors = NULL;
   m->file = NULL;
   m->order = NULL;
 }
 
-static void free_peers(pcu_aa_tree* t)
-{
-  if (pcu_aa_empty(*t))
-    return;
-  free_peers(&((*t)->left));
-  free_peers(&((*t)->right));
-  pcu_msg_peer* peer;
-  peer = (pcu_msg_peer*) *t;
-  pcu_free_message(&(peer->message));
-  noto_free(peer);
-  pcu_make_aa(t);
-}
-
 void pcu_msg_start(pcu_msg* m)
 {
   if (m->state != idle_state)
     reel_fail("PCU_Comm_Begin called at the wrong time");
   /* this barrier ensures no one starts a new superstep
      while others are receiving in the past superstep.
-     It is the only blocking call in the pcu_msg system. */
-  pcu_barrier(&(m->coll));
+     It is the only blocking call in the pcu_msg system.
+     Neighbor phases do not need it, see above. */
+  if (!m->neighbors)
+    pcu_barrier(&(m->coll));
+  pcu_prepare_peers(&(m->peers), pcu_mpi_size());
   m->state = pack_state;
 }
 
-static bool peer_less(pcu_aa_node* a, pcu_aa_node* b)
+void* pcu_msg_pack(pcu_msg* m, int id, size_t size)
 {
-  return ((pcu_msg_peer*)a)->message.peer
-       < ((pcu_msg_peer*)b)->message.peer;
+  if (m->state != pack_state)
+    reel_fail("PCU_Comm_Pack called at the wrong time");
+  pcu_message* peer = pcu_get_peer(&(m->peers),id);
+  return pcu_push_buffer(&(peer->buffer),size);
 }
 
-static pcu_msg_peer* find_peer(pcu_aa_tree t, int id)
+/* each thread packs into its own table of send buffers,
+   so packing needs no locks. pcu_msg_send appends the
+   buffers of each thread in thread order, keeping the
+   contents of every message deterministic. */
+static void free_threads(pcu_msg* m)
 {
-  pcu_msg_peer key;
-  key.message.peer = id;
-  return (pcu_msg_peer*) pcu_aa_find(&(key.node),t,peer_less);
+  for (int i = 0; i < m->nthreads; ++i)
+    pcu_free_peers(m->threads + i);
+  noto_free(m->threads);
+  m->threads = NULL;
+  m->nthreads = 0;
 }
 
-static pcu_msg_peer* make_peer(int id)
+void pcu_msg_threads(pcu_msg* m, int n)
 {
-  pcu_msg_peer* p;
-  NOTO_MALLOC(p,1);
-  pcu_make_message(&(p->message));
-  p->message.peer = id;
-  return p;
+  if (m->state != pack_state)
+    reel_fail("PCU_Comm_Pack_Threads called at the wrong time");
+  if (m->nthreads)
+    reel_fail("PCU_Comm_Pack_Threads called twice in one phase");
+  NOTO_MALLOC(m->threads,n);
+  m->nthreads = n;
+  for (int i = 0; i < n; ++i) {
+    pcu_make_peers(m->threads + i);
+    pcu_prepare_peers(m->threads + i, pcu_mpi_size());
+  }
 }
 
-void* pcu_msg_pack(pcu_msg* m, int id, size_t size)
+void* pcu_msg_thread_pack(pcu_msg* m, int thread, int id, size_t size)
 {
   if (m->state != pack_state)
-    reel_fail("PCU_Comm_Pack called at the wrong time");
-  pcu_msg_peer* peer = find_peer(m->peers,id);
-  if (!peer)
-  {
-    peer = make_peer(id);
-    pcu_aa_insert(&(peer->node),&(m->peers),peer_less);
+    reel_fail("PCU_Comm_Thread_Pack called at the wrong time");
+  if ((thread < 0)||(thread >= m->nthreads))
+    reel_fail("PCU_Comm_Thread_Pack called with an invalid thread");
+  pcu_message* peer = pcu_get_peer(m->threads + thread,id);
+  return pcu_push_buffer(&(peer->buffer),size);
+}
+
+/* the first buffer for a peer is taken over rather than copied */
+static void merge_threads(pcu_msg* m)
+{
+  for (int i = 0; i < m->nthreads; ++i) {
+    pcu_peers* t = m->threads + i;
+    for (int j = 0; j < t->count; ++j) {
+      pcu_buffer* from = &(t->messages[j].buffer);
+      pcu_buffer* to = &(pcu_get_peer(&(m->peers),t->messages[j].peer)->buffer);
+      if (!to->capacity) {
+        pcu_buffer tmp = *to;
+        *to = *from;
+        *from = tmp;
+      } else {
+        memcpy(pcu_push_buffer(to,from->size),from->start,from->size);
+      }
+    }
   }
-  return pcu_push_buffer(&(peer->message.buffer),size);
+  free_threads(m);
+}
+
+void* pcu_msg_reserve(pcu_msg* m, int id, size_t size)
+{
+  if (m->state != pack_state)
+    reel_fail("PCU_Comm_Reserve called at the wrong time");
+  pcu_message* peer = pcu_get_peer(&(m->peers),id);
+  return pcu_reserve_buffer(&(peer->buffer),size);
+}
+
+void pcu_msg_commit(pcu_msg* m, int id, size_t size)
+{
+  if (m->state != pack_state)
+    reel_fail("PCU_Comm_Commit called at the wrong time");
+  pcu_message* peer = pcu_find_peer(&(m->peers),id);
+  if (!peer)
+    reel_fail("PCU_Comm_Commit called but nothing was reserved");
+  pcu_commit_buffer(&(peer->buffer),size);
 }
 
 size_t pcu_msg_packed(pcu_msg* m, int id)
 {
   if (m->state != pack_state)
     reel_fail("PCU_Comm_Packed called at the wrong time");
-  pcu_msg_peer* peer = find_peer(m->peers,id);
+  pcu_message* peer = pcu_find_peer(&(m->peers),id);
   if (!peer)
     reel_fail("PCU_Comm_Packed called but nothing was packed");
-  return peer->message.buffer.size;
+  return peer->buffer.size;
 }
 
-static void send_peers(pcu_aa_tree t)
+static void send_peers(pcu_peers* p)
 {
-  if (pcu_aa_empty(t))
-    return;
-  pcu_msg_peer* peer;
-  peer = (pcu_msg_peer*)t;
-  pcu_mpi_send(&(peer->message),pcu_user_comm);
-  send_peers(t->left);
-  send_peers(t->right);
+  for (int i = 0; i < p->count; ++i)
+    pcu_mpi_send(p->messages + i,pcu_user_comm);
+}
+
+static int compare_ints(const void* a, const void* b)
+{
+  int x = *((const int*)a);
+  int y = *((const int*)b);
+  return (x > y) - (x < y);
+}
+
+static bool is_out_neighbor(pcu_neighbors* n, int id)
+{
+  return bsearch(&id, n->out, n->nout, sizeof(int), compare_ints) != NULL;
+}
+
+static void send_neighbors(pcu_msg* m)
+{
+  pcu_neighbors* n = m->neighbors;
+  pcu_peers* p = &(m->peers);
+  for (int i = 0; i < p->count; ++i)
+    if (!is_out_neighbor(n, p->messages[i].peer))
+      reel_fail("PCU_Comm_Pack to a rank that is not a neighbor");
+  for (int i = 0; i < n->nout; ++i)
+    pcu_get_peer(p, n->out[i]);
+  for (int i = 0; i < p->count; ++i)
+    pcu_pmpi_send2(p->messages + i,PCU_NEIGHBOR_TAG,pcu_user_comm);
+  for (int i = 0; i < n->nin; ++i)
+    n->pending[i] = n->in[i];
+  n->npending = n->nin;
 }
 
 void pcu_msg_send(pcu_msg* m)
 {
   if (m->state != pack_state)
     reel_fail("PCU_Comm_Send called at the wrong time");
-  send_peers(m->peers);
+  merge_threads(m);
+  if (m->neighbors)
+    send_neighbors(m);
+  else
+    send_peers(&(m->peers));
   m->state = send_recv_state;
 }
 
-static bool done_sending_peers(pcu_aa_tree t)
+static bool done_sending_peers(pcu_peers* p)
 {
-  if (pcu_aa_empty(t))
-    return true;
-  pcu_msg_peer* peer;
-  peer = (pcu_msg_peer*)t;
-  return pcu_mpi_done(&(peer->message))
-    && done_sending_peers(t->left)
-    && done_sending_peers(t->right);
+  for (int i = 0; i < p->count; ++i)
+    if (!pcu_mpi_done(p->messages + i))
+      return false;
+  return true;
 }
 
 static bool receive_global(pcu_msg* m)
@@ -179,7 +266,7 @@ static bool receive_global(pcu_msg* m)
   while ( ! pcu_mpi_receive(&(m->received),pcu_user_comm))
   {
     if (m->state == send_recv_state)
-      if (done_sending_peers(m->peers))
+      if (done_sending_peers(&(m->peers)))
       {
         pcu_begin_barrier(&(m->coll));
         m->state = recv_state;
@@ -191,9 +278,29 @@ static bool receive_global(pcu_msg* m)
   return true;
 }
 
+/* empty messages only tell the receiver that
+   nothing was packed, so they are not returned */
+static bool receive_neighbors(pcu_msg* m)
+{
+  pcu_neighbors* n = m->neighbors;
+  while (n->npending) {
+    for (int i = 0; i < n->npending; ++i) {
+      m->received.peer = n->pending[i];
+      if (pcu_pmpi_receive2(&(m->received),PCU_NEIGHBOR_TAG,pcu_user_comm)) {
+        n->pending[i] = n->pending[--(n->npending)];
+        if (m->received.buffer.size)
+          return true;
+        --i;
+      }
+    }
+  }
+  while ( ! done_sending_peers(&(m->peers)));
+  return false;
+}
+
 static void free_comm(pcu_msg* m)
 {
-  free_peers(&(m->peers));
+  pcu_clear_peers(&(m->peers));
   pcu_free_message(&(m->received));
 }
 
@@ -204,7 +311,12 @@ bool pcu_msg_receive(pcu_msg* m)
     reel_fail("PCU_Comm_Receive called at the wrong time");
   if ( ! pcu_msg_unpacked(m))
     reel_fail("PCU_Comm_Receive called before previous message unpacked");
-  if (receive_global(m))
+  bool received;
+  if (m->neighbors)
+    received = receive_neighbors(m);
+  else
+    received = receive_global(m);
+  if (received)
   {
     pcu_begin_buffer(&(m->received.buffer));
     return true;
@@ -220,6 +332,11 @@ void* pcu_msg_unpack(pcu_msg* m, size_t size)
   return pcu_walk_buffer(&(m->received.buffer),size);
 }
 
+void* pcu_msg_span(pcu_msg* m, size_t* size)
+{
+  return pcu_buffer_rest(&(m->received.buffer),size);
+}
+
 bool pcu_msg_unpacked(pcu_msg* m)
 {
   return pcu_buffer_walked(&(m->received.buffer));
@@ -237,8 +354,66 @@ size_t pcu_msg_received_size(pcu_msg* m)
 
 void pcu_free_msg(pcu_msg* m)
 {
+  pcu_msg_free_neighbors(m);
+  free_threads(m);
   free_comm(m);
+  pcu_free_peers(&(m->peers));
   if (m->file)
     fclose(m->file);
 }
 
+
+/* finds the in-neighbors with one ordinary phase
+   in which each rank sends nothing to its out-neighbors */
+static void find_in_neighbors(pcu_msg* m, pcu_neighbors* n)
+{
+  pcu_msg_start(m);
+  for (int i = 0; i < n->nout; ++i)
+    pcu_msg_pack(m, n->out[i], 0);
+  pcu_msg_send(m);
+  int cap = 0;
+  while (pcu_msg_receive(m)) {
+    if (n->nin == cap) {
+      cap = (cap + 8) * 2;
+      n->in = noto_realloc(n->in, cap * sizeof(int));
+    }
+    n->in[n->nin++] = pcu_msg_received_from(m);
+  }
+}
+
+void pcu_msg_set_neighbors(pcu_msg* m, int n, const int* ranks)
+{
+  if (m->state != idle_state)
+    reel_fail("PCU_Comm_Neighbors called at the wrong time");
+  pcu_msg_free_neighbors(m);
+  pcu_neighbors* nb;
+  NOTO_MALLOC(nb,1);
+  NOTO_MALLOC(nb->out,n);
+  memcpy(nb->out, ranks, n * sizeof(int));
+  qsort(nb->out, n, sizeof(int), compare_ints);
+  int nout = 0;
+  for (int i = 0; i < n; ++i)
+    if (!nout || nb->out[nout - 1] != nb->out[i])
+      nb->out[nout++] = nb->out[i];
+  nb->nout = nout;
+  nb->nin = 0;
+  nb->in = NULL;
+  find_in_neighbors(m, nb);
+  NOTO_MALLOC(nb->pending,nb->nin);
+  nb->npending = 0;
+  m->neighbors = nb;
+}
+
+void pcu_msg_free_neighbors(pcu_msg* m)
+{
+  pcu_neighbors* n = m->neighbors;
+  if (!n)
+    return;
+  if (m->state != idle_state)
+    reel_fail("PCU_Comm_Neighbors called at the wrong time");
+  noto_free(n->out);
+  noto_free(n->in);
+  noto_free(n->pending);
+  noto_free(n);
+  m->neighbors = NULL;
+}
@@ -11,7 +11,7 @@
 #define PCU_MSG_H
 
 #include "pcu_coll.h"
-#include "pcu_aa.h"
+#include "pcu_peers.h"
 #include "pcu_io.h"
 
 /* the PCU Messenger (pcu_msg for short) system implements
@@ -19,22 +19,31 @@
    it is based on PCU non-blocking Collectives and pcu_mpi,
    so it also works in hybrid mode */
 
-/* a structure containing all data to be sent to a peer during
-   this communication phase. */
+struct pcu_order_struct;
+
+/* a fixed graph of peers that phases are restricted to.
+   every phase sends one message to each out-neighbor and
+   receives one from each in-neighbor, which is enough
+   to detect the end of the phase without barriers */
 typedef struct
 {
-  pcu_aa_node node; //binary tree node for lookup
-  pcu_message message; //send buffer and peer id
-} pcu_msg_peer;
-
-struct pcu_order_struct;
+  int nout; //number of ranks this rank sends to
+  int* out; //sorted ranks this rank sends to
+  int nin; //number of ranks this rank receives from
+  int* in; //ranks this rank receives from
+  int npending; //in-neighbors not yet received from this phase
+  int* pending; //those in-neighbors
+} pcu_neighbors;
 
 struct pcu_msg_struct
 {
-  pcu_aa_tree peers; //binary tree of send buffers
+  pcu_peers peers; //send buffers by peer rank
+  pcu_peers* threads; //send buffers of each packing thread
+  int nthreads; //number of packing threads
   pcu_message received; //current received buffer
   pcu_coll coll; //collective operation object
   int state; //state within a communication phase
+  pcu_neighbors* neighbors; //NULL unless restricted to neighbors
   /* below this point are variables that just need
      to be thread-specific but have been tacked onto
      pcu_msg. if this gets out of hand, create a
@@ -49,15 +58,22 @@ void pcu_msg_start(pcu_msg* b);
 void* pcu_msg_pack(pcu_msg* m, int id, size_t size);
 #define PCU_MSG_PACK(m,id,o) \
 memcpy(pcu_msg_pack(m,id,sizeof(o)),&(o),sizeof(o))
+void pcu_msg_threads(pcu_msg* m, int n);
+void* pcu_msg_thread_pack(pcu_msg* m, int thread, int id, size_t size);
+void* pcu_msg_reserve(pcu_msg* m, int id, size_t size);
+void pcu_msg_commit(pcu_msg* m, int id, size_t size);
 size_t pcu_msg_packed(pcu_msg* m, int id);
 void pcu_msg_send(pcu_msg* m);
 bool pcu_msg_receive(pcu_msg* m);
 void* pcu_msg_unpack(pcu_msg* m, size_t size);
 #define PCU_MSG_UNPACK(m,o) \
 memcpy(&(o),pcu_msg_unpack(m,sizeof(o)),sizeof(o))
+void* pcu_msg_span(pcu_msg* m, size_t* size);
 bool pcu_msg_unpacked(pcu_msg* m);
 int pcu_msg_received_from(pcu_msg* m);
 size_t pcu_msg_received_size(pcu_msg* m);
 void pcu_free_msg(pcu_msg* m);
+void pcu_msg_set_neighbors(pcu_msg* m, int n, const int* ranks);
+void pcu_msg_free_neighbors(pcu_msg* m);
 
 #endif //PCU_MSG_H
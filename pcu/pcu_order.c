@@ -136,6 +136,11 @@ void* pcu_order_unpack(pcu_order o, size_t size)
   return pcu_walk_buffer(&o->array[o->at]->buf, size);
 }
 
+void* pcu_order_span(pcu_order o, size_t* size)
+{
+  return pcu_buffer_rest(&o->array[o->at]->buf, size);
+}
+
 bool pcu_order_unpacked(pcu_order o)
 {
 /* compatibility with pcu_msg_unpacked before pcu_msg_receive */
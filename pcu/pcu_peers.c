@@ -0,0 +1,141 @@
+/****************************************************************************** 
+
+  Copyright 2014 Scientific Computation Research Center, 
+      Rensselaer Polytechnic Institute. All rights reserved.
+  
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+#include "pcu_peers.h"
+#include "noto_malloc.h"
+#include <string.h>
+#include <stdint.h>
+
+/* up to this many ranks, slots are a dense array,
+   costing at most this many ints per rank */
+#define PCU_DENSE_PEERS 4096
+
+/* hashed slot arrays start at this size and double
+   whenever they become half full */
+#define PCU_MIN_HASH_SLOTS 64
+
+void pcu_make_peers(pcu_peers* p)
+{
+  p->messages = NULL;
+  p->count = 0;
+  p->capacity = 0;
+  p->slots = NULL;
+  p->nslots = 0;
+  p->shift = 32;
+  p->dense = false;
+  p->last = -1;
+}
+
+void pcu_free_peers(pcu_peers* p)
+{
+  pcu_clear_peers(p);
+  noto_free(p->messages);
+  noto_free(p->slots);
+  pcu_make_peers(p);
+}
+
+static void empty_slots(pcu_peers* p)
+{
+  memset(p->slots, -1, p->nslots * sizeof(int));
+}
+
+static void make_slots(pcu_peers* p, int nslots)
+{
+  p->nslots = nslots;
+  p->shift = 32;
+  while ((1 << (32 - p->shift)) < nslots)
+    --p->shift;
+  NOTO_MALLOC(p->slots, nslots);
+  empty_slots(p);
+}
+
+/* chooses the slots for a communicator of the given size,
+   keeping the ones from the last phase if they still fit */
+void pcu_prepare_peers(pcu_peers* p, int size)
+{
+  bool dense = (size <= PCU_DENSE_PEERS);
+  if (p->slots && p->dense == dense && (!dense || p->nslots == size))
+    return;
+  pcu_free_peers(p);
+  p->dense = dense;
+  make_slots(p, dense ? size : PCU_MIN_HASH_SLOTS);
+}
+
+/* Fibonacci hashing, the multiplier is 2^32 over the golden ratio.
+   The slot comes from the high bits of the product, which depend on
+   all bits of the rank, so strided ranks still spread out. */
+static int hash_slot(pcu_peers* p, int id)
+{
+  return (int)(((uint32_t)id * UINT32_C(2654435769)) >> p->shift);
+}
+
+static int* find_slot(pcu_peers* p, int id)
+{
+  if (p->dense)
+    return p->slots + id;
+  int i = hash_slot(p, id);
+  while (p->slots[i] != -1 && p->messages[p->slots[i]].peer != id)
+    i = (i + 1) & (p->nslots - 1);
+  return p->slots + i;
+}
+
+pcu_message* pcu_find_peer(pcu_peers* p, int id)
+{
+  if (p->last != -1 && p->messages[p->last].peer == id)
+    return p->messages + p->last;
+  int i = *find_slot(p, id);
+  if (i == -1)
+    return NULL;
+  p->last = i;
+  return p->messages + i;
+}
+
+static void grow_slots(pcu_peers* p)
+{
+  noto_free(p->slots);
+  make_slots(p, p->nslots * 2);
+  for (int i = 0; i < p->count; ++i)
+    *find_slot(p, p->messages[i].peer) = i;
+}
+
+/* returns the message for this peer, adding it if needed */
+pcu_message* pcu_get_peer(pcu_peers* p, int id)
+{
+  pcu_message* m = pcu_find_peer(p, id);
+  if (m)
+    return m;
+  if (p->count == p->capacity) {
+    p->capacity = (p->capacity + 8) * 2;
+    p->messages = noto_realloc(p->messages,
+        p->capacity * sizeof(pcu_message));
+  }
+  int i = p->count++;
+  m = p->messages + i;
+  pcu_make_message(m);
+  m->peer = id;
+  *find_slot(p, id) = i;
+  if ((!p->dense) && (p->count * 2 > p->nslots))
+    grow_slots(p);
+  p->last = i;
+  return m;
+}
+
+/* frees all messages, keeping the memory of the table */
+void pcu_clear_peers(pcu_peers* p)
+{
+  for (int i = 0; i < p->count; ++i) {
+    if (p->dense)
+      p->slots[p->messages[i].peer] = -1;
+    pcu_free_message(p->messages + i);
+  }
+  if ((!p->dense) && p->count)
+    empty_slots(p);
+  p->count = 0;
+  p->last = -1;
+}
@@ -0,0 +1,40 @@
+/****************************************************************************** 
+
+  Copyright 2014 Scientific Computation Research Center, 
+      Rensselaer Polytechnic Institute. All rights reserved.
+  
+  This work is open source software, licensed under the terms of the
+  BSD license as described in the LICENSE file in the top-level directory.
+
+*******************************************************************************/
+#ifndef PCU_PEERS_H
+#define PCU_PEERS_H
+
+#include "pcu_mpi.h"
+
+/* the send buffers of a communication phase, looked up by peer rank.
+   With few ranks, the lookup is a dense array indexed by rank,
+   otherwise it is an open-addressing hash table keyed by rank.
+   Either way the messages themselves are kept in one array
+   in the order they were first packed, which is how they
+   are visited for sending. */
+typedef struct
+{
+  pcu_message* messages; //send buffers in order of first pack
+  int count; //number of send buffers
+  int capacity; //allocated send buffers
+  int* slots; //index into messages or -1, by rank or hash of rank
+  int nslots; //number of slots, a power of two when hashed
+  int shift; //32 minus the base two logarithm of nslots when hashed
+  bool dense; //whether slots are indexed by rank
+  int last; //index of the most recently found message or -1
+} pcu_peers;
+
+void pcu_make_peers(pcu_peers* p);
+void pcu_free_peers(pcu_peers* p);
+void pcu_prepare_peers(pcu_peers* p, int size);
+pcu_message* pcu_find_peer(pcu_peers* p, int id);
+pcu_message* pcu_get_peer(pcu_peers* p, int id);
+void pcu_clear_peers(pcu_peers* p);
+
+#endif
@@ -1,6 +1,8 @@
 tribits_package(SCORECpcu)
 
 option(PCU_COMPRESS "Enable SMB compression using libbzip2 [ON|OFF]" OFF)
+option(PCU_ZSTD "Enable .zst SMB compression using libzstd [ON|OFF]" OFF)
+option(PCU_LZ4 "Enable .lz4 SMB compression using liblz4 [ON|OFF]" OFF)
 
 set(CMAKE_MODULE_PATH
    ${CMAKE_MODULE_PATH}
@@ -41,6 +43,7 @@ set(SOURCES
    pcu_mpi.c
    pcu_msg.c
    pcu_order.c
+   pcu_peers.c
    pcu_pmpi.c
    pcu_util.c
    noto/noto_malloc.c
@@ -65,4 +68,20 @@ if (PCU_COMPRESS)
   add_definitions(-DPCU_BZIP)
 endif (PCU_COMPRESS)
 
+if (PCU_ZSTD)
+  find_path(ZSTD_INCLUDE_DIR zstd.h)
+  find_library(ZSTD_LIBRARY zstd)
+  include_directories(${ZSTD_INCLUDE_DIR})
+  target_link_libraries(pcu ${ZSTD_LIBRARY})
+  add_definitions(-DPCU_ZSTD)
+endif (PCU_ZSTD)
+
+if (PCU_LZ4)
+  find_path(LZ4_INCLUDE_DIR lz4frame.h)
+  find_library(LZ4_LIBRARY lz4)
+  include_directories(${LZ4_INCLUDE_DIR})
+  target_link_libraries(pcu ${LZ4_LIBRARY})
+  add_definitions(-DPCU_LZ4)
+endif (PCU_LZ4)
+
 tribits_package_postprocess()
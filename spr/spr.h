@@ -32,11 +32,36 @@ apf::Field* getGradIPField(apf::Field* f,
                            const char* name, 
                            int order);
 
+/** @brief compute the gradient of a vector or scalar
+  *        field at integration points using stored
+  *        element Jacobians
+  * @param f (In) scalar or vector nodal field
+  * @param name (In) name of integration point field
+  * @param cache (In) element geometry of the mesh of f,
+  *        whose order is the integration order. It is
+  *        filled again if the mesh changed since the last use
+  */
+apf::Field* getGradIPField(apf::Field* f,
+                           const char* name,
+                           apf::GeometryCache* cache);
+
 /** @brief recover a nodal field using patch recovery
   * @param ip_field (In) integration point field
   */
 apf::Field* recoverField(apf::Field* ip_field);
 
+/** @brief set the number of threads that recoverField uses
+  * @details with more than one thread, the patches of entities
+  *          whose cavities are already local are fit concurrently,
+  *          and the cavity operator recovers the others as before.
+  *          Threads require building with ENABLE_OPENMP.
+  *          The default is one thread.
+  */
+void setThreads(int threads);
+
+/** @brief get the number of threads that recoverField uses */
+int getThreads();
+
 /** @brief run the SPR ZZ error estimator
   * @param f the integration-point input field
   * @param adapt_ratio the fraction of allowable error,
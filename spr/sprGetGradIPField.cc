@@ -7,6 +7,9 @@
 
 #include "spr.h"
 #include "apfMesh.h"
+#include "apfShape.h"
+#include "apfIntegrate.h"
+#include "apfGeometryCache.h"
 #include <pcu_util.h>
 
 namespace spr {
@@ -15,37 +18,77 @@ apf::Field* getGradIPField(apf::Field* f, const char* name, int order)
 {
   PCU_ALWAYS_ASSERT(f);
   apf::Mesh* m = getMesh(f);
+  apf::GeometryCache cache(m, m->getDimension(), order);
+  return getGradIPField(f, name, &cache);
+}
+
+apf::Field* getGradIPField(apf::Field* f, const char* name,
+    apf::GeometryCache* cache)
+{
+  PCU_ALWAYS_ASSERT(f);
+  apf::Mesh* m = getMesh(f);
+  PCU_ALWAYS_ASSERT(cache->getMesh() == m);
+  PCU_ALWAYS_ASSERT(cache->getDimension() == m->getDimension());
   int vt = apf::getValueType(f);
   PCU_ALWAYS_ASSERT(vt == apf::SCALAR || vt == apf::VECTOR);
+  int order = cache->getOrder();
+  cache->update();
   apf::Field* ip_field = apf::createIPField(m,name,vt+1,order);
-  apf::MeshIterator* it = m->begin(m->getDimension());
-  apf::MeshEntity* e;
-  while ((e = m->iterate(it)))
+  apf::FieldShape* fs = apf::getShape(f);
+  apf::NewArray<double> scalars;
+  apf::NewArray<apf::Vector3> vectors;
+  apf::NewArray<apf::Vector3> localGrads;
+  apf::ShapeTable const* tables[apf::Mesh::TYPES];
+  for (int type = 0; type < apf::Mesh::TYPES; ++type)
+    if (apf::Mesh::typeDimension[type] == cache->getDimension())
+      tables[type] = apf::getShapeTable(fs, type, order);
+    else
+      tables[type] = 0;
+  for (size_t i = 0; i < cache->countElements(); ++i)
   {
-    apf::MeshElement* me = apf::createMeshElement(m,e);
-    apf::Element* fe = apf::createElement(f,me);
-    int np = countIntPoints(me,order);
-    for (int p=0; p < np; ++p)
+    apf::MeshEntity* e = cache->getElement(i);
+    int type = m->getType(e);
+    apf::EntityShape* es = fs->getEntityShape(type);
+    apf::ShapeTable const* table = tables[type];
+    int nen = es->countNodes();
+    /* the Jacobians are cached, so the element only
+       needs the nodal values of f */
+    apf::Element* fe = apf::createElement(f,e);
+    if (vt == apf::SCALAR)
+      apf::getScalarNodes(fe,scalars);
+    else
+      apf::getVectorNodes(fe,vectors);
+    apf::destroyElement(fe);
+    for (int p=0; p < cache->countPoints(i); ++p)
     {
-      apf::Vector3 xi;
-      apf::getIntPoint(me,order,p,xi);
+      apf::Vector3 const* lg;
+      if (table)
+        lg = table->getLocalGradients(p);
+      else
+      {
+        apf::Vector3 const& xi = apf::getIntegration(type)
+          ->getAccurate(order)->getPoint(p)->param;
+        es->getLocalGradients(m,e,xi,localGrads);
+        lg = &localGrads[0];
+      }
+      apf::Matrix3x3 const& jinv = cache->getJacobianInverse(i,p);
       if (vt == apf::SCALAR)
       {
-        apf::Vector3 value;
-        apf::getGrad(fe,xi,value);
+        apf::Vector3 value(0,0,0);
+        for (int n=0; n < nen; ++n)
+          value = value + (jinv * lg[n]) * scalars[n];
         apf::setVector(ip_field,e,p,value);
       }
       else
       {
-        apf::Matrix3x3 value;
-        apf::getVectorGrad(fe,xi,value);
+        apf::Matrix3x3 value =
+          apf::tensorProduct(jinv * lg[0], vectors[0]);
+        for (int n=1; n < nen; ++n)
+          value = value + apf::tensorProduct(jinv * lg[n], vectors[n]);
         apf::setMatrix(ip_field,e,p,value);
       }
     }
-    apf::destroyElement(fe);
-    apf::destroyMeshElement(me);
   }
-  m->end(it);
   return ip_field;
 }
 
@@ -16,6 +16,7 @@
 #include <mthQR.h>
 
 #include <set>
+#include <vector>
 #include <pcu_util.h>
 
 namespace spr {
@@ -110,6 +111,16 @@ struct QRDecomp {
 
 typedef std::set<apf::MeshEntity*> EntitySet;
 
+/* patches may only grow over local elements.
+   The cavity operator requests the missing ones,
+   worker threads leave such patches to the operator */
+class Locality
+{
+  public:
+    virtual ~Locality() {}
+    virtual bool request(apf::MeshEntity** entities, int count) = 0;
+};
+
 struct Patch {
   apf::Mesh* mesh;
   Recovery* recovery;
@@ -153,9 +164,9 @@ static void addElementsToPatch(Patch* p, apf::DynamicArray<apf::MeshEntity*>& es
     addElementToPatch(p, es[i]);
 }
 
-static bool getInitialPatch(Patch* p, apf::CavityOp* o)
+static bool getInitialPatch(Patch* p, Locality* o)
 {
-  if ( ! o->requestLocality(&p->entity,1))
+  if ( ! o->request(&p->entity,1))
     return false;
   apf::DynamicArray<apf::MeshEntity*> adjacent;
   p->mesh->getAdjacent(p->entity, p->recovery->dim, adjacent);
@@ -164,7 +175,7 @@ static bool getInitialPatch(Patch* p, apf::CavityOp* o)
 }
 
 static bool addElementsThatShare(Patch* p, int dim,
-    EntitySet& old_elements, apf::CavityOp* o)
+    EntitySet& old_elements, Locality* o)
 {
   EntitySet bridges;
   APF_ITERATE(EntitySet, old_elements, it)
@@ -177,7 +188,7 @@ static bool addElementsThatShare(Patch* p, int dim,
   std::vector<apf::MeshEntity*> 
     bridge_array(bridges.begin(),bridges.end());
   bridges.clear();
-  if ( ! o->requestLocality(&(bridge_array[0]),bridge_array.size()))
+  if ( ! o->request(&(bridge_array[0]),bridge_array.size()))
     return false;
   for (size_t i=0; i < bridge_array.size(); ++i)
   {
@@ -302,21 +313,14 @@ static bool preparePolynomialFit(
   return rank == A.cols();
 }
 
+/* one column of values and coefficients per component */
 static void runPolynomialFit(QRDecomp const& qr,
-                             mth::Vector<double> const& values,
-                             mth::Vector<double>& coeffs)
+                             mth::Matrix<double> const& values,
+                             mth::Matrix<double>& coeffs)
 {
   mth::solveFromQR(qr.Q, qr.R, values, coeffs);
 }
 
-static double evalPolynomial(int dim, int order, apf::Vector3& point,
-    mth::Vector<double>& coeffs)
-{
-  mth::Vector<double> terms;
-  evalPolynomialTerms(dim, order, point, terms);
-  return coeffs * terms;
-}
-
 static bool prepareSpr(Patch* p)
 {
   Recovery* r = p->recovery;
@@ -325,7 +329,18 @@ static bool prepareSpr(Patch* p)
       p->samples.points, p->qr);
 }
 
-static void runSpr(Patch* p)
+static int countRecoveredValues(Recovery* r, apf::MeshEntity* e)
+{
+  apf::Mesh* m = r->mesh;
+  return m->getShape()->countNodesOn(m->getType(e)) *
+         apf::countComponents(r->f_star);
+}
+
+/* fits all components of the patch at once and writes
+   the recovered values of its nodes, node by node, to (recovered).
+   This only reads the mesh and fields, so
+   patches may be fit concurrently */
+static void fitPatch(Patch* p, double* recovered)
 {
   Recovery* r = p->recovery;
   apf::Mesh* m = r->mesh;
@@ -333,24 +348,41 @@ static void runSpr(Patch* p)
   getSampleValues(p);
   int num_components = apf::countComponents(r->f_star);
   int num_nodes = m->getShape()->countNodesOn(m->getType(p->entity));
-  mth::Vector<double> values(s->num_points);
-  apf::NewArray<apf::Vector3> nodal_points(num_nodes);
-  apf::NewArray<apf::NewArray<double> > recovered_values(num_nodes);
-  for (int i = 0; i < num_nodes; ++i) {
-    recovered_values[i].allocate(num_components);
-    m->getPoint(p->entity, i, nodal_points[i]);
-  }
-  for (int i = 0; i < num_components; ++i) {
-    for (int j = 0; j < s->num_points; ++j)
-      values(j) = s->values[j][i];
-    mth::Vector<double> coeffs;
-    runPolynomialFit(p->qr, values, coeffs);
-    for (int j = 0; j < num_nodes; ++j)
-      recovered_values[j][i] = evalPolynomial(
-          r->dim, r->order, nodal_points[j], coeffs);
+  mth::Matrix<double> values(s->num_points, num_components);
+  for (int j = 0; j < s->num_points; ++j)
+    for (int i = 0; i < num_components; ++i)
+      values(j,i) = s->values[j][i];
+  mth::Matrix<double> coeffs;
+  runPolynomialFit(p->qr, values, coeffs);
+  mth::Vector<double> terms;
+  for (int j = 0; j < num_nodes; ++j) {
+    apf::Vector3 point;
+    m->getPoint(p->entity, j, point);
+    evalPolynomialTerms(r->dim, r->order, point, terms);
+    for (int i = 0; i < num_components; ++i) {
+      double v = 0;
+      for (unsigned k = 0; k < terms.size(); ++k)
+        v += coeffs(k,i) * terms(k);
+      recovered[j * num_components + i] = v;
+    }
   }
+}
+
+static void setRecoveredValues(Recovery* r, apf::MeshEntity* e,
+    double const* recovered)
+{
+  int num_components = apf::countComponents(r->f_star);
+  int num_nodes = r->mesh->getShape()->countNodesOn(r->mesh->getType(e));
   for (int i = 0; i < num_nodes; ++i)
-    apf::setComponents(r->f_star, p->entity, i, &(recovered_values[i][0]));
+    apf::setComponents(r->f_star, e, i, &recovered[i * num_components]);
+}
+
+static void runSpr(Patch* p)
+{
+  Recovery* r = p->recovery;
+  apf::NewArray<double> recovered(countRecoveredValues(r, p->entity));
+  fitPatch(p, &recovered[0]);
+  setRecoveredValues(r, p->entity, &recovered[0]);
 }
 
 static bool hasEnoughPoints(Patch* p)
@@ -363,7 +395,7 @@ static bool hasEnoughPoints(Patch* p)
   return prepareSpr(p);
 }
 
-static bool expandAsNecessary(Patch* p, apf::CavityOp* o)
+static bool expandAsNecessary(Patch* p, Locality* o)
 {
   if (hasEnoughPoints(p))
     return true;
@@ -386,14 +418,14 @@ static bool expandAsNecessary(Patch* p, apf::CavityOp* o)
   }
 }
 
-static bool buildPatch(Patch* p, apf::CavityOp* o)
+static bool buildPatch(Patch* p, Locality* o)
 {
   if (!getInitialPatch(p, o)) return false;
   if (!expandAsNecessary(p, o)) return false;
   return true;
 }
 
-class PatchOp : public apf::CavityOp
+class PatchOp : public apf::CavityOp, public Locality
 {
 public:
   PatchOp(Recovery* r):
@@ -401,6 +433,10 @@ public:
   {
     setupPatch(&patch, r);
   }
+  virtual bool request(apf::MeshEntity** entities, int count)
+  {
+    return requestLocality(entities, count);
+  }
   virtual Outcome setEntity(apf::MeshEntity* e)
   {
     if (hasEntity(patch.recovery->f_star, e))
@@ -417,14 +453,93 @@ public:
   Patch patch;
 };
 
+/* worker threads may only look at which entities are shared */
+class SharingLocality : public Locality
+{
+public:
+  SharingLocality(apf::Sharing* s):sharing(s) {}
+  virtual bool request(apf::MeshEntity** entities, int count)
+  {
+    for (int i=0; i < count; ++i)
+      if (sharing->isShared(entities[i]))
+        return false;
+    return true;
+  }
+  apf::Sharing* sharing;
+};
+
+static int recoveryThreads = 1;
+
+void setThreads(int threads)
+{
+  PCU_ALWAYS_ASSERT(threads > 0);
+  recoveryThreads = threads;
+}
+
+int getThreads()
+{
+  return recoveryThreads;
+}
+
+/* fits the patches of owned entities of dimension (d) whose
+   cavities are local, concurrently. The fits are kept aside
+   and written by one thread afterwards, since writing a field
+   may change its storage. PatchOp then skips these entities
+   and recovers the rest, pulling cavities as needed. */
+static void recoverLocalPatches(Recovery* r, int d, int threads)
+{
+  apf::Mesh* m = r->mesh;
+  apf::Sharing* sharing = apf::getSharing(m);
+  std::vector<apf::MeshEntity*> entities;
+  std::vector<size_t> offsets(1, 0);
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(d);
+  while ((e = m->iterate(it)))
+    if (sharing->isOwned(e) && !hasEntity(r->f_star, e)) {
+      entities.push_back(e);
+      offsets.push_back(offsets.back() + countRecoveredValues(r, e));
+    }
+  m->end(it);
+  std::vector<double> recovered(offsets.back());
+  std::vector<char> fitted(entities.size(), 0);
+  SharingLocality locality(sharing);
+  long n = entities.size();
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#else
+  (void)threads;
+#endif
+  {
+    Patch patch;
+    setupPatch(&patch, r);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+    for (long i = 0; i < n; ++i) {
+      startPatch(&patch, entities[i]);
+      if (buildPatch(&patch, &locality)) {
+        fitPatch(&patch, &recovered[offsets[i]]);
+        fitted[i] = 1;
+      }
+    }
+  }
+  for (long i = 0; i < n; ++i)
+    if (fitted[i])
+      setRecoveredValues(r, entities[i], &recovered[offsets[i]]);
+  delete sharing;
+}
+
 apf::Field* recoverField(apf::Field* f)
 {
   Recovery recovery;
   setupRecovery(&recovery, f);
   PatchOp op(&recovery);
   for (int d = 0; d <= 3; ++d)
-    if (recovery.mesh->getShape()->hasNodesIn(d))
+    if (recovery.mesh->getShape()->hasNodesIn(d)) {
+      if (recoveryThreads > 1)
+        recoverLocalPatches(&recovery, d, recoveryThreads);
       op.applyToDimension(d);
+    }
   return recovery.f_star;
 }
 
@@ -0,0 +1,190 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfCavityOp.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include "testBox.h"
+
+namespace {
+
+/* splits the tagged edges at their midpoints */
+class EdgeSplitter : public apf::CavityOp
+{
+  public:
+    EdgeSplitter(apf::Mesh2* m, apf::MeshTag* t):
+      apf::CavityOp(m, true),
+      mesh2(m),
+      marks(t),
+      edge(0)
+    {
+    }
+    virtual Outcome setEntity(apf::MeshEntity* e)
+    {
+      if ( ! mesh->hasTag(e, marks))
+        return SKIP;
+      if ( ! requestLocality(&e, 1))
+        return REQUEST;
+      edge = e;
+      return OK;
+    }
+    virtual void apply()
+    {
+      apf::MeshEntity* v[2];
+      mesh->getDownward(edge, 0, v);
+      apf::ModelEntity* c = mesh->toModel(edge);
+      apf::Vector3 x = (getPoint(v[0]) + getPoint(v[1])) / 2;
+      apf::MeshEntity* mid = mesh2->createVertex(c, x, apf::Vector3(0,0,0));
+      apf::MeshEntity* ev[2] = {v[0], mid};
+      apf::buildElement(mesh2, c, apf::Mesh::EDGE, ev);
+      ev[0] = mid; ev[1] = v[1];
+      apf::buildElement(mesh2, c, apf::Mesh::EDGE, ev);
+      apf::Adjacent tets;
+      mesh->getAdjacent(edge, 3, tets);
+      apf::Adjacent faces;
+      mesh->getAdjacent(edge, 2, faces);
+      for (size_t i = 0; i < faces.getSize(); ++i)
+        splitAround(faces[i], apf::Mesh::TRIANGLE, v, mid);
+      for (size_t i = 0; i < tets.getSize(); ++i)
+        splitAround(tets[i], apf::Mesh::TET, v, mid);
+      for (size_t i = 0; i < tets.getSize(); ++i)
+        remove(tets[i]);
+      for (size_t i = 0; i < faces.getSize(); ++i)
+        remove(faces[i]);
+      remove(edge);
+    }
+    virtual apf::CavityOp* makeThreadCopy()
+    {
+      return new EdgeSplitter(mesh2, marks);
+    }
+    virtual int getMaxCreated(int type)
+    {
+      /* splits make the edges near them grow, this allows
+         sixteen faces and sixteen tets around one edge */
+      static int const most[apf::Mesh::TYPES] = {1,18,48,0,32,0,0,0};
+      return most[type];
+    }
+  private:
+    apf::Vector3 getPoint(apf::MeshEntity* v)
+    {
+      apf::Vector3 x;
+      mesh->getPoint(v, 0, x);
+      return x;
+    }
+    /* replaces each edge vertex in turn by the midpoint,
+       which keeps the orientation of the entity */
+    void splitAround(apf::MeshEntity* e, int type,
+        apf::MeshEntity** ev, apf::MeshEntity* mid)
+    {
+      apf::Downward v;
+      int n = mesh->getDownward(e, 0, v);
+      apf::ModelEntity* c = mesh->toModel(e);
+      for (int side = 0; side < 2; ++side)
+      {
+        apf::Downward nv;
+        for (int i = 0; i < n; ++i)
+          nv[i] = (v[i] == ev[side]) ? mid : v[i];
+        apf::buildElement(mesh2, c, type, nv);
+      }
+    }
+    void remove(apf::MeshEntity* e)
+    {
+      preDeletion(e);
+      mesh2->destroy(e);
+    }
+    apf::Mesh2* mesh2;
+    apf::MeshTag* marks;
+    apf::MeshEntity* edge;
+};
+
+/* marks the edges crossing the plane x = y + 0.1z */
+long markEdges(apf::Mesh* m, apf::MeshTag* marks)
+{
+  long n = 0;
+  int one = 1;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(1);
+  while ((e = m->iterate(it)))
+  {
+    apf::MeshEntity* v[2];
+    m->getDownward(e, 0, v);
+    double s[2];
+    for (int i = 0; i < 2; ++i)
+    {
+      apf::Vector3 x;
+      m->getPoint(v[i], 0, x);
+      s[i] = x[0] - x[1] - 0.1 * x[2];
+    }
+    if (s[0] * s[1] < 0)
+    {
+      m->setIntTag(e, marks, &one);
+      ++n;
+    }
+  }
+  m->end(it);
+  return n;
+}
+
+double getVolume(apf::Mesh* m)
+{
+  double v = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it)))
+    v += apf::measure(m, e);
+  m->end(it);
+  return v;
+}
+
+/* splits the marked edges of a fresh box on (threads)
+   threads and returns the time it took */
+double split(int n, int threads)
+{
+  apf::Mesh2* m = test::makeBox(n);
+  apf::MeshTag* marks = m->createIntTag("split", 1);
+  long verts = m->count(0);
+  long marked = markEdges(m, marks);
+  EdgeSplitter op(m, marks);
+  op.setThreads(threads);
+  double t0 = PCU_Time();
+  op.applyToDimension(1);
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(m->count(0) == size_t(verts + marked));
+  apf::removeTagFromDimension(m, marks, 1);
+  m->destroyTag(marks);
+  m->acceptChanges();
+  m->verify();
+  PCU_ALWAYS_ASSERT(fabs(getVolume(m) - 1) < 1e-10);
+  printf("%d threads: split %ld edges into %lu elements in %f s\n",
+      threads, marked, (unsigned long)m->count(3), t);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  return t;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <threads>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  int n = atoi(argv[1]);
+  int threads = atoi(argv[2]);
+  gmi_register_mesh();
+  double serial = split(n, 1);
+  double threaded = split(n, threads);
+  printf("speedup %.2f\n", serial / threaded);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -14,7 +14,7 @@ int main(int argc, char** argv)
   PCU_Comm_Init();
   gmi_register_mesh();
   gmi_register_null();
-  int* conn;
+  apf::Gid* conn;
   double* coords;
   int nelem;
   int etype;
@@ -0,0 +1,133 @@
+#include <gmi_null.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfConvert.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+/* an in-memory generator of n x n x n cubes, each cut into the six
+   tetrahedra around its main diagonal. Every part generates a slab
+   of cube layers and provides the coordinates of a contiguous range
+   of global vertex ids, as apf::setCoords expects. */
+struct Box
+{
+  Box(int divisions)
+  {
+    n = divisions;
+    int self = PCU_Comm_Self();
+    int peers = PCU_Comm_Peers();
+    firstLayer = (long(n) * self) / peers;
+    endLayer = (long(n) * (self + 1)) / peers;
+  }
+  apf::Gid vertex(long i, long j, long k)
+  {
+    return i + (n + 1) * (j + (n + 1) * k);
+  }
+  int countElements()
+  {
+    return 6 * n * n * (endLayer - firstLayer);
+  }
+  apf::Gid* makeConnectivity()
+  {
+    static int const axes[6][3] = {
+      {0,1,2},{1,2,0},{2,0,1},{0,2,1},{2,1,0},{1,0,2}};
+    apf::Gid* conn = new apf::Gid[countElements() * 4];
+    apf::Gid* c = conn;
+    for (long k = firstLayer; k < endLayer; ++k)
+    for (long j = 0; j < n; ++j)
+    for (long i = 0; i < n; ++i)
+      for (int t = 0; t < 6; ++t) {
+        long p[3] = {i, j, k};
+        *c++ = vertex(p[0], p[1], p[2]);
+        for (int s = 0; s < 3; ++s) {
+          ++p[axes[t][s]];
+          c[s] = vertex(p[0], p[1], p[2]);
+        }
+        /* odd permutations of the axes give negative volume */
+        if (t >= 3)
+          std::swap(c[1], c[2]);
+        c += 3;
+      }
+    return conn;
+  }
+  /* the last part also owns the top layer of vertices */
+  int countVerts()
+  {
+    long layers = endLayer - firstLayer;
+    if (PCU_Comm_Self() == PCU_Comm_Peers() - 1)
+      ++layers;
+    return (n + 1) * (n + 1) * layers;
+  }
+  double* makeCoords()
+  {
+    double* coords = new double[countVerts() * 3];
+    double* c = coords;
+    long end = endLayer;
+    if (PCU_Comm_Self() == PCU_Comm_Peers() - 1)
+      ++end;
+    for (long k = firstLayer; k < end; ++k)
+    for (long j = 0; j <= n; ++j)
+    for (long i = 0; i <= n; ++i) {
+      *c++ = double(i) / n;
+      *c++ = double(j) / n;
+      *c++ = double(k) / n;
+    }
+    return coords;
+  }
+  int n;
+  long firstLayer;
+  long endLayer;
+};
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  gmi_register_null();
+  Box box(atoi(argv[1]));
+  int nelem = box.countElements();
+  apf::Gid* conn = box.makeConnectivity();
+  gmi_model* model = gmi_load(".null");
+  apf::Mesh2* m = apf::makeEmptyMdsMesh(model, 3, false);
+  apf::GlobalToVert outMap;
+  double t0 = PCU_Time();
+  apf::construct(m, conn, nelem, apf::Mesh::TET, outMap);
+  double t1 = PCU_Time();
+  delete [] conn;
+  apf::alignMdsRemotes(m);
+  apf::deriveMdsModel(m);
+  double* coords = box.makeCoords();
+  double t2 = PCU_Time();
+  apf::setCoords(m, coords, box.countVerts(), outMap);
+  double t3 = PCU_Time();
+  delete [] coords;
+  outMap.clear();
+  long elements = PCU_Add_Long(m->count(3));
+  long verts = PCU_Add_Long(apf::countOwned(m, 0));
+  long n = box.n;
+  PCU_ALWAYS_ASSERT(elements == 6 * n * n * n);
+  PCU_ALWAYS_ASSERT(verts == (n + 1) * (n + 1) * (n + 1));
+  m->verify();
+  if (!PCU_Comm_Self()) {
+    printf("%ld elements, %ld vertices\n", elements, verts);
+    printf("construct %f s, setCoords %f s\n", t1 - t0, t3 - t2);
+  }
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,114 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <ma.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* a boundary layer at z = 0 whose frame turns with x */
+class Layer : public ma::AnisotropicFunction
+{
+  public:
+    Layer(ma::Mesh* m)
+    {
+      mesh = m;
+      average = ma::getAverageEdgeLength(m);
+    }
+    virtual void getValue(ma::Entity* v, ma::Matrix& r, ma::Vector& h)
+    {
+      ma::Vector x = ma::getPosition(mesh, v);
+      double a = x[0];
+      r = ma::Matrix(cos(a), -sin(a), 0,
+                     sin(a),  cos(a), 0,
+                     0,       0,      1);
+      h = ma::Vector(average, average * 2, average * (0.1 + x[2]));
+    }
+  private:
+    ma::Mesh* mesh;
+    double average;
+};
+
+void getEdges(ma::Mesh* m, std::vector<ma::Entity*>& edges)
+{
+  ma::Entity* e;
+  ma::Iterator* it = m->begin(1);
+  while ((e = m->iterate(it)))
+    edges.push_back(e);
+  m->end(it);
+}
+
+/* the batch must agree with measuring and marking edge by edge */
+void checkBatch(ma::SizeField* sf, std::vector<ma::Entity*>& edges,
+    const char* name)
+{
+  size_t n = edges.size();
+  std::vector<double> single(n);
+  double t0 = PCU_Time();
+  for (size_t i = 0; i < n; ++i)
+    single[i] = sf->measure(edges[i]);
+  double t1 = PCU_Time();
+  std::vector<double> batch(n);
+  sf->measureEdges(n, &edges[0], &batch[0]);
+  double t2 = PCU_Time();
+  for (size_t i = 0; i < n; ++i)
+    PCU_ALWAYS_ASSERT(fabs(single[i] - batch[i]) <= 1e-12 * single[i]);
+  bool* split = new bool[n];
+  bool* collapse = new bool[n];
+  sf->shouldSplitEdges(n, &edges[0], split);
+  sf->shouldCollapseEdges(n, &edges[0], collapse);
+  long splits = 0;
+  long collapses = 0;
+  for (size_t i = 0; i < n; ++i) {
+    PCU_ALWAYS_ASSERT(split[i] == sf->shouldSplit(edges[i]));
+    PCU_ALWAYS_ASSERT(collapse[i] == sf->shouldCollapse(edges[i]));
+    splits += split[i];
+    collapses += collapse[i];
+  }
+  delete [] split;
+  delete [] collapse;
+  printf("%s: %lu edges, %ld to split, %ld to collapse, "
+      "one by one %f s, batched %f s, speedup %.2f\n",
+      name, (unsigned long)n, splits, collapses,
+      t1 - t0, t2 - t1, (t1 - t0) / (t2 - t1));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  int n = atoi(argv[1]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  std::vector<ma::Entity*> edges;
+  getEdges(m, edges);
+  Layer layer(m);
+  ma::SizeField* sf = ma::makeSizeField(m, &layer);
+  checkBatch(sf, edges, "anisotropic");
+  delete sf;
+  sf = ma::makeSizeField(m, &layer, 1);
+  checkBatch(sf, edges, "log metric");
+  delete sf;
+  ma::IdentitySizeField identity(m);
+  checkBatch(&identity, edges, "identity");
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
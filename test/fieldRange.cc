@@ -0,0 +1,202 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfShape.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* node values are a function of the entity position
+   in iteration and the component, so both ways of
+   reading and writing them can be checked against it */
+double value(std::size_t i, int c)
+{
+  return i * 10.0 + c;
+}
+
+std::size_t countValues(apf::Field* f, int dim)
+{
+  apf::Mesh* m = apf::getMesh(f);
+  return m->count(dim) *
+    apf::getShape(f)->countNodesOn(apf::Mesh::simplexTypes[dim]) *
+    apf::countComponents(f);
+}
+
+void setOneByOne(apf::Field* f, int dim)
+{
+  apf::Mesh* m = apf::getMesh(f);
+  int nc = apf::countComponents(f);
+  std::vector<double> v(nc);
+  std::size_t i = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(dim);
+  while ((e = m->iterate(it))) {
+    for (int n = 0; n < apf::getShape(f)->countNodesOn(m->getType(e)); ++n) {
+      for (int c = 0; c < nc; ++c)
+        v[c] = value(i, c);
+      apf::setComponents(f, e, n, &v[0]);
+      ++i;
+    }
+  }
+  m->end(it);
+}
+
+void checkOneByOne(apf::Field* f, int dim)
+{
+  apf::Mesh* m = apf::getMesh(f);
+  int nc = apf::countComponents(f);
+  std::vector<double> v(nc);
+  std::size_t i = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(dim);
+  while ((e = m->iterate(it))) {
+    for (int n = 0; n < apf::getShape(f)->countNodesOn(m->getType(e)); ++n) {
+      apf::getComponents(f, e, n, &v[0]);
+      for (int c = 0; c < nc; ++c)
+        PCU_ALWAYS_ASSERT(v[c] == value(i, c));
+      ++i;
+    }
+  }
+  m->end(it);
+}
+
+void setRange(apf::Field* f, int dim)
+{
+  int nc = apf::countComponents(f);
+  std::vector<double> v(countValues(f, dim));
+  for (std::size_t i = 0; i < v.size(); ++i)
+    v[i] = value(i / nc, i % nc);
+  apf::Mesh* m = apf::getMesh(f);
+  std::size_t half = m->count(dim) / 2;
+  std::size_t n = apf::setComponents(f, dim, 0, half, &v[0]);
+  n += apf::setComponents(f, dim, half, m->count(dim), &v[n]);
+  PCU_ALWAYS_ASSERT(n == v.size());
+}
+
+void checkRange(apf::Field* f, int dim)
+{
+  int nc = apf::countComponents(f);
+  std::vector<double> v(countValues(f, dim));
+  apf::Mesh* m = apf::getMesh(f);
+  std::size_t n = apf::getComponents(f, dim, 0, m->count(dim), &v[0]);
+  PCU_ALWAYS_ASSERT(n == v.size());
+  for (std::size_t i = 0; i < v.size(); ++i)
+    PCU_ALWAYS_ASSERT(v[i] == value(i / nc, i % nc));
+}
+
+void check(apf::Field* f, int dim)
+{
+  setOneByOne(f, dim);
+  checkRange(f, dim);
+  setRange(f, dim);
+  checkOneByOne(f, dim);
+}
+
+/* setting the first half of the vertices must leave
+   the rest of them without values */
+void checkPartial(apf::Mesh* m)
+{
+  apf::Field* f = apf::createLagrangeField(m, "partial", apf::SCALAR, 1);
+  std::size_t half = m->count(0) / 2;
+  std::vector<double> v(half);
+  for (std::size_t i = 0; i < half; ++i)
+    v[i] = value(i, 0);
+  PCU_ALWAYS_ASSERT(apf::setComponents(f, 0, 0, half, &v[0]) == half);
+  std::size_t i = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(0);
+  while ((e = m->iterate(it))) {
+    PCU_ALWAYS_ASSERT(apf::hasEntity(f, e) == (i < half));
+    ++i;
+  }
+  m->end(it);
+  std::vector<double> w(half);
+  PCU_ALWAYS_ASSERT(apf::getComponents(f, 0, 0, half, &w[0]) == half);
+  PCU_ALWAYS_ASSERT(w == v);
+  apf::destroyField(f);
+}
+
+double timeOneByOne(apf::Field* f, int dim, int reps)
+{
+  apf::Mesh* m = apf::getMesh(f);
+  int nc = apf::countComponents(f);
+  std::vector<double> v(nc);
+  double sum = 0;
+  double t0 = PCU_Time();
+  for (int r = 0; r < reps; ++r) {
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = m->begin(dim);
+    while ((e = m->iterate(it))) {
+      apf::getComponents(f, e, 0, &v[0]);
+      sum += v[0];
+    }
+    m->end(it);
+  }
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(sum > 0);
+  return t;
+}
+
+double timeRange(apf::Field* f, int dim, int reps)
+{
+  apf::Mesh* m = apf::getMesh(f);
+  std::vector<double> v(countValues(f, dim));
+  double sum = 0;
+  double t0 = PCU_Time();
+  for (int r = 0; r < reps; ++r) {
+    apf::getComponents(f, dim, 0, m->count(dim), &v[0]);
+    sum += v[0] + v.back();
+  }
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(sum > 0);
+  return t;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  apf::Field* u = apf::createLagrangeField(m, "u", apf::VECTOR, 2);
+  apf::Field* p = apf::createStepField(m, "p", apf::SCALAR);
+  check(u, 0);
+  check(u, 1);
+  check(p, 3);
+  checkPartial(m);
+  double one = timeOneByOne(u, 0, reps);
+  double range = timeRange(u, 0, reps);
+  /* a deleted element leaves a hole in the storage,
+     so ranges fall back to visiting elements */
+  apf::MeshIterator* it = m->begin(3);
+  apf::MeshEntity* e = m->iterate(it);
+  m->end(it);
+  m->destroy(e);
+  check(p, 3);
+  check(u, 0);
+  if (!PCU_Comm_Self())
+    printf("%d x %lu vertex values: one by one %f s, range %f s\n",
+        reps, (unsigned long)m->count(0), one, range);
+  apf::destroyField(u);
+  apf::destroyField(p);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
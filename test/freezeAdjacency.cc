@@ -0,0 +1,136 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include "testBox.h"
+
+namespace {
+
+/* the upward walk that patch and ghosting loops do */
+long walkUp(apf::Mesh* m)
+{
+  long sum = 0;
+  for (int d = 0; d < m->getDimension(); ++d) {
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = m->begin(d);
+    while ((e = m->iterate(it))) {
+      apf::Up up;
+      m->getUp(e, up);
+      sum += up.n;
+      apf::Adjacent elems;
+      m->getAdjacent(e, m->getDimension(), elems);
+      sum += elems.getSize();
+    }
+    m->end(it);
+  }
+  return sum;
+}
+
+long walkBridges(apf::Mesh2* m, int bridgeDim)
+{
+  long sum = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it))) {
+    apf::Adjacent adj;
+    apf::getMdsBridgeAdjacent(m, e, bridgeDim, adj);
+    sum += adj.getSize();
+  }
+  m->end(it);
+  return sum;
+}
+
+void compareAll(apf::Mesh2* m, int bridgeDim)
+{
+  int dim = m->getDimension();
+  for (int d = 0; d <= dim; ++d) {
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = m->begin(d);
+    while ((e = m->iterate(it))) {
+      apf::Adjacent a;
+      apf::Adjacent b;
+      for (int ud = d + 1; ud <= dim; ++ud) {
+        m->getAdjacent(e, ud, a);
+        apf::thawMdsAdjacency(m);
+        m->getAdjacent(e, ud, b);
+        apf::freezeMdsBridges(m, bridgeDim);
+        PCU_ALWAYS_ASSERT(a.getSize() == b.getSize());
+        for (size_t i = 0; i < a.getSize(); ++i)
+          PCU_ALWAYS_ASSERT(a[i] == b[i]);
+      }
+      if (d == dim) {
+        apf::getMdsBridgeAdjacent(m, e, bridgeDim, a);
+        apf::getBridgeAdjacent(m, e, bridgeDim, dim, b);
+        PCU_ALWAYS_ASSERT(a.getSize() == b.getSize());
+        for (size_t i = 0; i < a.getSize(); ++i)
+          PCU_ALWAYS_ASSERT(a[i] == b[i]);
+      }
+    }
+    m->end(it);
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  for (int b = 0; b < 3; ++b) {
+    apf::freezeMdsBridges(m, b);
+    compareAll(m, b);
+    apf::thawMdsAdjacency(m);
+  }
+  double t0 = PCU_Time();
+  long linked = 0;
+  for (int i = 0; i < reps; ++i)
+    linked += walkUp(m);
+  double t1 = PCU_Time();
+  long bridged = 0;
+  for (int i = 0; i < reps; ++i)
+    bridged += walkBridges(m, 0);
+  double t2 = PCU_Time();
+  apf::freezeMdsBridges(m, 0);
+  double t3 = PCU_Time();
+  long frozen = 0;
+  for (int i = 0; i < reps; ++i)
+    frozen += walkUp(m);
+  double t4 = PCU_Time();
+  long frozenBridged = 0;
+  for (int i = 0; i < reps; ++i)
+    frozenBridged += walkBridges(m, 0);
+  double t5 = PCU_Time();
+  PCU_ALWAYS_ASSERT(linked == frozen);
+  PCU_ALWAYS_ASSERT(bridged == frozenBridged);
+  /* modification drops the frozen arrays */
+  apf::MeshIterator* it = m->begin(m->getDimension());
+  apf::MeshEntity* e = m->iterate(it);
+  m->end(it);
+  m->destroy(e);
+  PCU_ALWAYS_ASSERT(!apf::isMdsAdjacencyFrozen(m));
+  if (!PCU_Comm_Self()) {
+    printf("upward walk: linked lists %f s, frozen %f s\n",
+        t1 - t0, t4 - t3);
+    printf("vertex-bridged elements: sets %f s, frozen %f s\n",
+        t2 - t1, t5 - t4);
+    printf("freezing took %f s\n", t3 - t2);
+  }
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,157 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfShape.h>
+#include <apfGeometryCache.h>
+#include <apf.h>
+#include <spr.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include "testBox.h"
+
+namespace {
+
+double distance(apf::Matrix3x3 const& a, apf::Matrix3x3 const& b)
+{
+  double d = 0;
+  for (int i = 0; i < 3; ++i)
+    d += (a[i] - b[i]).getLength();
+  return d;
+}
+
+/* the cache must agree with what a MeshElement computes */
+void checkCache(apf::Mesh* m, apf::GeometryCache* cache)
+{
+  int order = cache->getOrder();
+  for (size_t i = 0; i < cache->countElements(); ++i) {
+    apf::MeshElement* me = apf::createMeshElement(m, cache->getElement(i));
+    PCU_ALWAYS_ASSERT(cache->countPoints(i) == apf::countIntPoints(me, order));
+    for (int p = 0; p < cache->countPoints(i); ++p) {
+      apf::Vector3 xi;
+      apf::getIntPoint(me, order, p, xi);
+      apf::Matrix3x3 J;
+      apf::getJacobian(me, xi, J);
+      PCU_ALWAYS_ASSERT(distance(J, cache->getJacobian(i, p)) < 1e-12);
+      apf::Matrix3x3 jinv;
+      apf::getJacobianInv(me, xi, jinv);
+      PCU_ALWAYS_ASSERT(distance(jinv, cache->getJacobianInverse(i, p)) < 1e-9);
+      PCU_ALWAYS_ASSERT(std::abs(apf::getDV(me, xi) - cache->getDV(i, p))
+          < 1e-12);
+    }
+    apf::destroyMeshElement(me);
+  }
+}
+
+class Measurer : public apf::Integrator
+{
+  public:
+    Measurer(int order):apf::Integrator(order),v(0) {}
+    void atPoint(apf::Vector3 const&, double w, double dV)
+    {
+      v += w * dV;
+    }
+    double v;
+};
+
+double timeIntegrator(apf::Mesh* m, apf::GeometryCache* cache, int order,
+    int reps, double& volume)
+{
+  double t0 = PCU_Time();
+  for (int r = 0; r < reps; ++r) {
+    Measurer measurer(order);
+    if (cache)
+      measurer.process(cache);
+    else
+      measurer.process(m);
+    volume = measurer.v;
+  }
+  return PCU_Time() - t0;
+}
+
+/* the way SPR used to get gradients at integration points */
+void checkGradients(apf::Field* f, apf::Field* ip, int order)
+{
+  apf::Mesh* m = apf::getMesh(f);
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it))) {
+    apf::MeshElement* me = apf::createMeshElement(m, e);
+    apf::Element* fe = apf::createElement(f, me);
+    for (int p = 0; p < apf::countIntPoints(me, order); ++p) {
+      apf::Vector3 xi;
+      apf::getIntPoint(me, order, p, xi);
+      apf::Matrix3x3 expected, value;
+      apf::getVectorGrad(fe, xi, expected);
+      apf::getMatrix(ip, e, p, value);
+      PCU_ALWAYS_ASSERT(distance(expected, value) < 1e-9);
+    }
+    apf::destroyElement(fe);
+    apf::destroyMeshElement(me);
+  }
+  m->end(it);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  int order = 2;
+  double t0 = PCU_Time();
+  apf::GeometryCache cache(m, 3, order);
+  double fill = PCU_Time() - t0;
+  checkCache(m, &cache);
+  double volume;
+  double plain = timeIntegrator(m, 0, order, reps, volume);
+  PCU_ALWAYS_ASSERT(std::abs(volume - 1) < 1e-10);
+  double cached = timeIntegrator(m, &cache, order, reps, volume);
+  PCU_ALWAYS_ASSERT(std::abs(volume - 1) < 1e-10);
+  printf("%d x integrating over %lu tets: elements %f s, cache %f s "
+      "(filled in %f s)\n", reps, (unsigned long)m->count(3),
+      plain, cached, fill);
+  /* stretching the mesh invalidates the cache */
+  apf::Field* d = apf::createLagrangeField(m, "d", apf::VECTOR, 1);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(v, 0, x);
+    apf::setVector(d, v, 0, apf::Vector3(x.x(), 0, 0));
+  }
+  m->end(it);
+  PCU_ALWAYS_ASSERT(cache.isValid());
+  apf::displaceMesh(m, d);
+  PCU_ALWAYS_ASSERT(!cache.isValid());
+  timeIntegrator(m, &cache, order, 1, volume);
+  PCU_ALWAYS_ASSERT(cache.isValid());
+  PCU_ALWAYS_ASSERT(std::abs(volume - 2) < 1e-10);
+  checkCache(m, &cache);
+  /* and so does curving it */
+  m->changeShape(apf::getLagrange(2));
+  PCU_ALWAYS_ASSERT(!cache.isValid());
+  cache.update();
+  checkCache(m, &cache);
+  apf::Field* eps = spr::getGradIPField(d, "eps", &cache);
+  checkGradients(d, eps, order);
+  apf::destroyField(eps);
+  apf::destroyField(d);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
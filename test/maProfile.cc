@@ -0,0 +1,155 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <ma.h>
+#include <parma.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* fine at x = 0 and coarse at x = 1 */
+class Gradation : public ma::IsotropicFunction
+{
+  public:
+    Gradation(ma::Mesh* m)
+    {
+      mesh = m;
+      average = ma::getAverageEdgeLength(m);
+    }
+    virtual double getValue(ma::Entity* v)
+    {
+      double x = ma::getPosition(mesh, v)[0];
+      return average * (0.5 + 1.5 * x);
+    }
+  private:
+    ma::Mesh* mesh;
+    double average;
+};
+
+std::vector<std::string> split(std::string const& line)
+{
+  std::vector<std::string> fields;
+  std::stringstream ss(line);
+  std::string field;
+  while (std::getline(ss, field, ','))
+    fields.push_back(field);
+  return fields;
+}
+
+/* checks the CSV profile and returns the column sums */
+std::vector<double> checkCSV(const char* name, int iterations)
+{
+  std::ifstream file(name);
+  PCU_ALWAYS_ASSERT(file.is_open());
+  std::string line;
+  std::getline(file, line);
+  std::vector<std::string> header = split(line);
+  PCU_ALWAYS_ASSERT(header[0] == "iteration");
+  PCU_ALWAYS_ASSERT(header[1] == "phase");
+  std::vector<double> sums(header.size(), 0);
+  int rows = 0;
+  while (std::getline(file, line)) {
+    std::vector<std::string> row = split(line);
+    PCU_ALWAYS_ASSERT(row.size() == header.size());
+    double minTime = atof(row[2].c_str());
+    double maxTime = atof(row[3].c_str());
+    double avgTime = atof(row[4].c_str());
+    PCU_ALWAYS_ASSERT(minTime <= avgTime * (1 + 1e-9));
+    PCU_ALWAYS_ASSERT(avgTime <= maxTime * (1 + 1e-9));
+    for (size_t i = 2; i < row.size(); ++i)
+      sums[i] += atof(row[i].c_str());
+    ++rows;
+  }
+  /* preBalance, 5 phases per iteration, then
+     fixElementShapes, cleanupLayer and postBalance */
+  PCU_ALWAYS_ASSERT(rows == 1 + 5 * iterations + 3);
+  printf("%s:", name);
+  for (size_t i = 2; i < header.size(); ++i)
+    printf(" %s %g", header[i].c_str(), sums[i]);
+  printf("\n");
+  return sums;
+}
+
+size_t countPhases(const char* name)
+{
+  std::ifstream file(name);
+  PCU_ALWAYS_ASSERT(file.is_open());
+  std::stringstream ss;
+  ss << file.rdbuf();
+  std::string s = ss.str();
+  PCU_ALWAYS_ASSERT(s[0] == '{');
+  size_t n = 0;
+  for (size_t at = s.find("\"phase\""); at != std::string::npos;
+       at = s.find("\"phase\"", at + 1))
+    ++n;
+  return n;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  gmi_register_mesh();
+  /* every part builds its own box and sends the half x < 0.5
+     to part 1, leaving the parts out of balance for ParMA to fix */
+  apf::Mesh2* m = test::makeBox(n);
+  if (PCU_Comm_Peers() > 1)
+    test::migrateHalf(m, 1);
+  Gradation sf(m);
+  ma::Input* in = ma::configure(m, &sf);
+  in->profileFile = "adapt_profile.csv";
+  in->shouldRunPreParma = true;
+  int iterations = in->maximumIterations;
+  ma::adapt(in);
+  m->verify();
+  if (!PCU_Comm_Self()) {
+    std::vector<double> sums = checkCSV("adapt_profile.csv", iterations);
+    /* splits, collapses, collapse tries, swaps, cavity passes
+       and the elements ParMA moved */
+    PCU_ALWAYS_ASSERT(sums[5] > 0);
+    PCU_ALWAYS_ASSERT(sums[7] > 0);
+    PCU_ALWAYS_ASSERT(sums[6] >= sums[7]);
+    PCU_ALWAYS_ASSERT(sums[9] >= sums[10]);
+    PCU_ALWAYS_ASSERT(sums[13] > 0);
+    if (PCU_Comm_Peers() > 1)
+      PCU_ALWAYS_ASSERT(sums[12] > 0);
+  }
+  /* unbalance the parts again and let the
+     refinement balance itself as it goes */
+  if (PCU_Comm_Peers() > 1)
+    test::migrateHalf(m, 1);
+  in = ma::configureUniformRefine(m, 1);
+  in->profileFile = "refine_profile.json";
+  in->shouldRunRefineParma = true;
+  iterations = in->maximumIterations;
+  ma::adapt(in);
+  m->verify();
+  double imbalance[4];
+  Parma_GetEntImbalance(m, &imbalance);
+  PCU_ALWAYS_ASSERT(imbalance[3] < 1.2);
+  if (!PCU_Comm_Self())
+    PCU_ALWAYS_ASSERT(countPhases("refine_profile.json") ==
+        size_t(1 + 5 * iterations + 3));
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
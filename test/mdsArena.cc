@@ -0,0 +1,73 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <ma.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include "testBox.h"
+
+namespace {
+
+double getVolume(apf::Mesh* m)
+{
+  double v = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it)))
+    v += apf::measure(m, e);
+  m->end(it);
+  return v;
+}
+
+/* refines a fresh box once and returns its element count */
+size_t refine(int n, const char* name)
+{
+  apf::Mesh2* m = test::makeBox(n);
+  size_t before = m->count(3);
+  double t0 = PCU_Time();
+  ma::Input* in = ma::configureUniformRefine(m, 1);
+  in->shouldFixShape = false;
+  ma::adapt(in);
+  double t = PCU_Time() - t0;
+  m->verify();
+  PCU_ALWAYS_ASSERT(m->count(3) == 8 * before);
+  PCU_ALWAYS_ASSERT(fabs(getVolume(m) - 1) < 1e-10);
+  size_t elements = m->count(3);
+  printf("%s: refined %lu tets into %lu in %f s\n", name,
+      (unsigned long)before, (unsigned long)elements, t);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  return elements;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <arena growth>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  int n = atoi(argv[1]);
+  int growth = atoi(argv[2]);
+  gmi_register_mesh();
+  size_t heap = refine(n, "default");
+  /* a small growth makes the arrays outgrow their ranges
+     and move, a large one keeps them in place */
+  apf::setMdsArena(true, growth);
+  PCU_ALWAYS_ASSERT(apf::isMdsArena());
+  size_t arena = refine(n, "arena");
+  apf::setMdsArena(false);
+  PCU_ALWAYS_ASSERT(heap == arena);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
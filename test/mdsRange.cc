@@ -0,0 +1,145 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "testBox.h"
+
+namespace {
+
+struct Sums
+{
+  double volume;
+  long faces;
+};
+
+/* the kind of work an assembly loop does per element:
+   downward adjacency, coordinates and a little geometry */
+void visit(apf::Mesh* m, apf::MeshEntity* e, Sums& s)
+{
+  apf::MeshEntity* v[4];
+  m->getDownward(e, 0, v);
+  apf::Vector3 x[4];
+  for (int i = 0; i < 4; ++i)
+    m->getPoint(v[i], 0, x[i]);
+  apf::Vector3 a = x[1] - x[0];
+  apf::Vector3 b = x[2] - x[0];
+  apf::Vector3 c = x[3] - x[0];
+  s.volume += std::fabs(apf::cross(a, b) * c) / 6;
+  apf::Adjacent f;
+  m->getAdjacent(e, 2, f);
+  s.faces += f.getSize();
+}
+
+Sums loopSerial(apf::Mesh* m)
+{
+  Sums s = {0, 0};
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it)))
+    visit(m, e, s);
+  m->end(it);
+  return s;
+}
+
+Sums loopThreaded(apf::Mesh2* m)
+{
+  double volume = 0;
+  long faces = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:volume,faces)
+#endif
+  {
+    int self = 0;
+    int peers = 1;
+#ifdef _OPENMP
+    self = omp_get_thread_num();
+    peers = omp_get_num_threads();
+#endif
+    Sums s = {0, 0};
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = apf::beginMdsRange(m, 3, self, peers);
+    while ((e = m->iterate(it)))
+      visit(m, e, s);
+    m->end(it);
+    volume += s.volume;
+    faces += s.faces;
+  }
+  Sums s = {volume, faces};
+  return s;
+}
+
+void checkRanges(apf::Mesh2* m, int n)
+{
+  long count = 0;
+  for (int i = 0; i < n; ++i) {
+    apf::MeshIterator* it = apf::beginMdsRange(m, 3, i, n);
+    while (m->iterate(it))
+      ++count;
+    m->end(it);
+  }
+  PCU_ALWAYS_ASSERT(count == (long)m->count(3));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  for (int i = 1; i <= 7; ++i)
+    checkRanges(m, i);
+  /* holes left by destroyed entities must not break ranges */
+  apf::MeshIterator* it = m->begin(3);
+  apf::MeshEntity* e = m->iterate(it);
+  m->end(it);
+  m->destroy(e);
+  checkRanges(m, 3);
+  Sums serial = {0, 0};
+  Sums threaded = {0, 0};
+  double t0 = PCU_Time();
+  for (int i = 0; i < reps; ++i)
+    serial = loopSerial(m);
+  double t1 = PCU_Time();
+  for (int i = 0; i < reps; ++i)
+    threaded = loopThreaded(m);
+  double t2 = PCU_Time();
+  PCU_ALWAYS_ASSERT(serial.faces == threaded.faces);
+  PCU_ALWAYS_ASSERT(std::fabs(serial.volume - threaded.volume) < 1e-10);
+  double serialTime = PCU_Max_Double(t1 - t0);
+  double threadedTime = PCU_Max_Double(t2 - t1);
+  double elements = PCU_Add_Double(double(m->count(3)) * reps);
+  if (!PCU_Comm_Self()) {
+    printf("%d ranks x %d threads, %.0f elements visited\n",
+        PCU_Comm_Peers(), threads, elements);
+    printf("serial iterator: %f seconds, %e elements/second\n",
+        serialTime, elements / serialTime);
+    printf("range iterators: %f seconds, %e elements/second\n",
+        threadedTime, elements / threadedTime);
+  }
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,77 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include "testBox.h"
+
+namespace {
+
+/* every part builds its own box, so the parts are disconnected
+   and any element may move anywhere. Each repetition sends the
+   elements in the half x < 0.5 to the next part, with a tag. */
+void tagElements(apf::Mesh2* m, apf::MeshTag* tag)
+{
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it))) {
+    apf::Vector3 c = apf::getLinearCentroid(m, e);
+    double x[3];
+    c.toArray(x);
+    m->setDoubleTag(e, tag, x);
+  }
+  m->end(it);
+}
+
+void checkTags(apf::Mesh2* m, apf::MeshTag* tag)
+{
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it))) {
+    double x[3];
+    m->getDoubleTag(e, tag, x);
+    apf::Vector3 c = apf::getLinearCentroid(m, e);
+    PCU_ALWAYS_ASSERT((apf::Vector3(x) - c).getLength() < 1e-12);
+  }
+  m->end(it);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  apf::MeshTag* tag = m->createDoubleTag("centroid", 3);
+  tagElements(m, tag);
+  long elements = PCU_Add_Long(m->count(3));
+  double t0 = PCU_Time();
+  for (int i = 0; i < reps; ++i)
+    test::migrateHalfToNext(m);
+  double t1 = PCU_Max_Double(PCU_Time() - t0);
+  PCU_ALWAYS_ASSERT(PCU_Add_Long(m->count(3)) == elements);
+  checkTags(m, tag);
+  m->verify();
+  if (!PCU_Comm_Self())
+    printf("%d migrations of half of %ld elements took %f s\n",
+        reps, elements, t1);
+  apf::removeTagFromDimension(m, tag, 3);
+  m->destroyTag(tag);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
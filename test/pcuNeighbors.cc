@@ -0,0 +1,94 @@
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <set>
+
+namespace {
+
+/* the face neighbors of this rank in a periodic
+   three-dimensional grid of ranks, like parts of a mesh */
+std::vector<int> getGridNeighbors()
+{
+  int dims[3] = {0,0,0};
+  MPI_Dims_create(PCU_Comm_Peers(), 3, dims);
+  int self = PCU_Comm_Self();
+  int c[3];
+  c[0] = self % dims[0];
+  c[1] = (self / dims[0]) % dims[1];
+  c[2] = self / (dims[0] * dims[1]);
+  std::set<int> neighbors;
+  for (int d = 0; d < 3; ++d)
+    for (int s = -1; s <= 1; s += 2) {
+      int o[3] = {c[0], c[1], c[2]};
+      o[d] = (o[d] + s + dims[d]) % dims[d];
+      int rank = o[0] + dims[0] * (o[1] + dims[1] * o[2]);
+      if (rank != self)
+        neighbors.insert(rank);
+    }
+  return std::vector<int>(neighbors.begin(), neighbors.end());
+}
+
+/* every phase sends the phase number and sender to each neighbor,
+   padded to the message size, and checks what it receives */
+double runPhases(std::vector<int> const& neighbors, int phases, int ints)
+{
+  std::vector<int> data(ints);
+  std::set<int> senders(neighbors.begin(), neighbors.end());
+  double t0 = PCU_Time();
+  for (int p = 0; p < phases; ++p) {
+    PCU_Comm_Begin();
+    data[0] = p;
+    data[1] = PCU_Comm_Self();
+    for (size_t i = 0; i < neighbors.size(); ++i)
+      PCU_Comm_Pack(neighbors[i], &data[0], ints * sizeof(int));
+    PCU_Comm_Send();
+    size_t received = 0;
+    while (PCU_Comm_Receive()) {
+      PCU_Comm_Unpack(&data[0], ints * sizeof(int));
+      PCU_ALWAYS_ASSERT(data[0] == p);
+      PCU_ALWAYS_ASSERT(data[1] == PCU_Comm_Sender());
+      PCU_ALWAYS_ASSERT(senders.count(data[1]));
+      ++received;
+    }
+    PCU_ALWAYS_ASSERT(received == senders.size());
+  }
+  return PCU_Max_Double(PCU_Time() - t0);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <phases> <message bytes>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int phases = atoi(argv[1]);
+  int ints = atoi(argv[2]) / sizeof(int);
+  if (ints < 2)
+    ints = 2;
+  std::vector<int> neighbors = getGridNeighbors();
+  double global = runPhases(neighbors, phases, ints);
+  PCU_Comm_Neighbors(neighbors.size(), neighbors.empty() ? 0 : &neighbors[0]);
+  double local = runPhases(neighbors, phases, ints);
+  PCU_Comm_Order(false);
+  double unordered = runPhases(neighbors, phases, ints);
+  PCU_Comm_Free_Neighbors();
+  double after = runPhases(neighbors, phases, ints);
+  if (!PCU_Comm_Self()) {
+    printf("%d ranks, %d phases of %lu bytes to %lu neighbors\n",
+        PCU_Comm_Peers(), phases, (unsigned long)(ints * sizeof(int)),
+        (unsigned long)neighbors.size());
+    printf("ordinary phases: %f s\n", global);
+    printf("neighbor phases: %f s, unordered %f s\n", local, unordered);
+    printf("ordinary phases afterwards: %f s\n", after);
+  }
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
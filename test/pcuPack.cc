@@ -0,0 +1,53 @@
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* measures the throughput of many small PCU_Comm_Pack calls
+   spread over several peers, the pattern of migration and ghosting */
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <items per peer> <peers>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  long items = atol(argv[1]);
+  int npeers = atoi(argv[2]);
+  int self = PCU_Comm_Self();
+  int size = PCU_Comm_Peers();
+  std::vector<int> peers(npeers);
+  for (int i = 0; i < npeers; ++i)
+    peers[i] = (self + i + 1) % size;
+  double t0 = PCU_Time();
+  PCU_Comm_Begin();
+  for (long i = 0; i < items; ++i)
+    for (int j = 0; j < npeers; ++j) {
+      long item = i * npeers + j;
+      PCU_COMM_PACK(peers[j], item);
+    }
+  double t1 = PCU_Time();
+  PCU_Comm_Send();
+  long received = 0;
+  while (PCU_Comm_Receive()) {
+    long item;
+    PCU_COMM_UNPACK(item);
+    ++received;
+  }
+  double t2 = PCU_Time();
+  PCU_ALWAYS_ASSERT(PCU_Add_Long(received) == items * npeers * size);
+  double pack = PCU_Max_Double(t1 - t0);
+  double exchange = PCU_Max_Double(t2 - t1);
+  if (!PCU_Comm_Self()) {
+    printf("%d ranks packed %ld items each to %d peers\n",
+        size, items, npeers);
+    printf("pack %f s (%e packs/second), exchange %f s\n",
+        pack, (items * npeers) / pack, exchange);
+  }
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,82 @@
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+/* items 0 to n-1 go to every other rank: the first is packed
+   by PCU_Comm_Pack and the rest by threads owning contiguous
+   ranges of them, so they must arrive in increasing order */
+void exchange(long n, int threads)
+{
+  int self = PCU_Comm_Self();
+  int peers = PCU_Comm_Peers();
+  PCU_Comm_Begin();
+  long first = 0;
+  for (int to = 0; to < peers; ++to)
+    if (to != self)
+      PCU_COMM_PACK(to, first);
+  PCU_Comm_Pack_Threads(threads);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(threads)
+#endif
+  for (int t = 0; t < threads; ++t) {
+    long begin = 1 + ((n - 1) * t) / threads;
+    long end = 1 + ((n - 1) * (t + 1)) / threads;
+    for (long i = begin; i < end; ++i)
+      for (int to = 0; to < peers; ++to)
+        if (to != self)
+          PCU_COMM_THREAD_PACK(t, to, i);
+  }
+  PCU_Comm_Send();
+  int senders = 0;
+  while (PCU_Comm_Listen()) {
+    for (long i = 0; i < n; ++i) {
+      long item;
+      PCU_COMM_UNPACK(item);
+      PCU_ALWAYS_ASSERT(item == i);
+    }
+    PCU_ALWAYS_ASSERT(PCU_Comm_Unpacked());
+    ++senders;
+  }
+  PCU_ALWAYS_ASSERT(senders == peers - 1);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <items>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  long n = atol(argv[1]);
+  int threads = 4;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  double t0 = PCU_Time();
+  exchange(n, 1);
+  double t1 = PCU_Time();
+  exchange(n, threads);
+  double t2 = PCU_Time();
+  PCU_Comm_Order(false);
+  exchange(n, threads);
+  double serial = PCU_Max_Double(t1 - t0);
+  double threaded = PCU_Max_Double(t2 - t1);
+  if (!PCU_Comm_Self()) {
+    printf("%d ranks x %d threads, %ld items to each peer\n",
+        PCU_Comm_Peers(), threads, n);
+    printf("one thread: %f s, all threads: %f s\n", serial, threaded);
+  }
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,91 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* compares the index against the default of visiting every entity */
+void checkIndex(apf::Mesh2* m)
+{
+  for (int d = 0; d < m->getDimension(); ++d) {
+    std::vector<int> parts, expectedParts;
+    std::vector<size_t> counts, expectedCounts;
+    m->getNeighbors(d, parts, counts);
+    m->apf::Mesh::getNeighbors(d, expectedParts, expectedCounts);
+    PCU_ALWAYS_ASSERT(parts == expectedParts);
+    PCU_ALWAYS_ASSERT(counts == expectedCounts);
+    for (size_t i = 0; i < parts.size(); ++i) {
+      std::vector<apf::MeshEntity*> shared, expected;
+      m->getSharedWith(d, parts[i], shared);
+      m->apf::Mesh::getSharedWith(d, parts[i], expected);
+      PCU_ALWAYS_ASSERT(shared == expected);
+      PCU_ALWAYS_ASSERT(shared.size() == counts[i]);
+    }
+  }
+}
+
+double timeSharedWith(apf::Mesh2* m, int reps, bool indexed)
+{
+  std::vector<int> parts;
+  std::vector<size_t> counts;
+  m->getNeighbors(0, parts, counts);
+  size_t expected = 0;
+  for (size_t i = 0; i < counts.size(); ++i)
+    expected += reps * counts[i];
+  size_t total = 0;
+  double t0 = PCU_Time();
+  for (int r = 0; r < reps; ++r)
+    for (size_t i = 0; i < parts.size(); ++i) {
+      std::vector<apf::MeshEntity*> shared;
+      if (indexed)
+        m->getSharedWith(0, parts[i], shared);
+      else
+        m->apf::Mesh::getSharedWith(0, parts[i], shared);
+      total += shared.size();
+    }
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(total == expected);
+  return PCU_Max_Double(t);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  /* every part builds its own box and sends the half x < 0.5 to
+     the next part, whose half x > 0.5 it then shares a boundary with */
+  apf::Mesh2* m = test::makeBox(n);
+  test::migrateHalfToNext(m);
+  checkIndex(m);
+  /* changing copies drops the index until it is asked for again */
+  test::migrateHalfToNext(m);
+  checkIndex(m);
+  m->verify();
+  double brute = timeSharedWith(m, reps, false);
+  double indexed = timeSharedWith(m, reps, true);
+  if (!PCU_Comm_Self())
+    printf("%d x shared vertices of all neighbors: "
+        "visiting %f s, indexed %f s\n", reps, brute, indexed);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
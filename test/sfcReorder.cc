@@ -0,0 +1,159 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfNumbering.h>
+#include <apfShape.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* a random vertex order, standing in for a mesh read
+   in whatever order its generator produced */
+void scramble(apf::Mesh2* m)
+{
+  std::vector<int> order(m->count(0));
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  srand(42);
+  for (size_t i = order.size(); i > 1; --i)
+    std::swap(order[i - 1], order[rand() % i]);
+  apf::MeshTag* tag = m->createIntTag("scramble", 1);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  size_t i = 0;
+  while ((v = m->iterate(it)))
+    m->setIntTag(v, tag, &order[i++]);
+  m->end(it);
+  /* the ordering tag does not survive the reordering */
+  apf::reorderMdsMesh(m, tag);
+}
+
+/* sums element volumes computed from vertex coordinates
+   and a vertex field, the access pattern of assembly */
+double loopElements(apf::Mesh2* m, apf::Field* f, int reps, double& sum)
+{
+  sum = 0;
+  double t0 = PCU_Time();
+  for (int r = 0; r < reps; ++r) {
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = m->begin(m->getDimension());
+    while ((e = m->iterate(it))) {
+      apf::Downward vs;
+      int nv = m->getDownward(e, 0, vs);
+      apf::Vector3 x[4];
+      double u = 0;
+      for (int i = 0; i < nv; ++i) {
+        m->getPoint(vs[i], 0, x[i]);
+        u += apf::getScalar(f, vs[i], 0);
+      }
+      sum += u * ((x[1] - x[0]) * apf::cross(x[2] - x[0], x[3] - x[0]));
+    }
+    m->end(it);
+  }
+  return PCU_Time() - t0;
+}
+
+/* the largest and mean difference between the numbers of
+   the vertices of an element */
+void measureBandwidth(apf::Mesh2* m, apf::Numbering* n,
+    long& max, double& mean)
+{
+  max = 0;
+  mean = 0;
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(m->getDimension());
+  while ((e = m->iterate(it))) {
+    apf::Downward vs;
+    int nv = m->getDownward(e, 0, vs);
+    int lo = apf::getNumber(n, vs[0], 0, 0);
+    int hi = lo;
+    for (int i = 1; i < nv; ++i) {
+      int k = apf::getNumber(n, vs[i], 0, 0);
+      lo = std::min(lo, k);
+      hi = std::max(hi, k);
+    }
+    max = std::max(max, long(hi - lo));
+    mean += hi - lo;
+  }
+  m->end(it);
+  mean /= m->count(m->getDimension());
+}
+
+void run(apf::Mesh2* m, const char* name, int reps, double& expected)
+{
+  apf::Field* f = m->findField("u");
+  double sum;
+  double t = loopElements(m, f, reps, sum);
+  if (expected == 0)
+    expected = sum;
+  PCU_ALWAYS_ASSERT(std::abs(sum - expected) < 1e-9 * std::abs(expected));
+  apf::Numbering* naive = apf::createNumbering(f);
+  apf::NaiveOrder(naive);
+  long naiveMax;
+  double naiveMean;
+  measureBandwidth(m, naive, naiveMax, naiveMean);
+  apf::destroyNumbering(naive);
+  apf::Numbering* adj = apf::createNumbering(f);
+  apf::AdjReorder(adj);
+  long adjMax;
+  double adjMean;
+  measureBandwidth(m, adj, adjMax, adjMean);
+  apf::destroyNumbering(adj);
+  printf("%-10s %e elements/s, bandwidth naive %ld (mean %.1f) "
+         "adjacency %ld (mean %.1f)\n", name,
+         reps * m->count(m->getDimension()) / t,
+         naiveMax, naiveMean, adjMax, adjMean);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <repetitions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  int n = atoi(argv[1]);
+  int reps = atoi(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  apf::Field* f = apf::createLagrangeField(m, "u", apf::SCALAR, 1);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(v, 0, x);
+    apf::setScalar(f, v, 0, x.x() + 2 * x.y() + 3 * x.z());
+  }
+  m->end(it);
+  double expected = 0;
+  scramble(m);
+  run(m, "scrambled", reps, expected);
+  apf::reorderMdsMesh(m);
+  run(m, "bfs", reps, expected);
+  scramble(m);
+  apf::reorderMdsMeshSFC(m, apf::MORTON);
+  run(m, "morton", reps, expected);
+  scramble(m);
+  apf::reorderMdsMeshSFC(m, apf::HILBERT);
+  run(m, "hilbert", reps, expected);
+  m->verify();
+  apf::destroyField(f);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,155 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apfShape.h>
+#include <apfIntegrate.h>
+#include <apf.h>
+#include <crv.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* the batched values, the tabulated values and those
+   of one point at a time must all agree */
+void checkShape(apf::FieldShape* s, int type, int order)
+{
+  apf::EntityShape* es = s->getEntityShape(type);
+  if (!es)
+    return;
+  apf::EntityIntegration const* ei = apf::getIntegration(type);
+  if (!ei || !ei->getAccurate(order))
+    return;
+  apf::Integration const* in = ei->getAccurate(order);
+  int np = in->countPoints();
+  int nen = es->countNodes();
+  std::vector<apf::Vector3> xi(np);
+  for (int i = 0; i < np; ++i)
+    xi[i] = in->getPoint(i)->param;
+  std::vector<double> values(np * nen);
+  std::vector<apf::Vector3> grads(np * nen);
+  es->getValuesAtPoints(0, 0, np, &xi[0], &values[0]);
+  es->getLocalGradientsAtPoints(0, 0, np, &xi[0], &grads[0]);
+  apf::ShapeTable const* table = apf::getShapeTable(s, type, order);
+  PCU_ALWAYS_ASSERT(table);
+  PCU_ALWAYS_ASSERT(table == apf::getShapeTable(s, type, order));
+  PCU_ALWAYS_ASSERT(table->countPoints() == np);
+  PCU_ALWAYS_ASSERT(table->countNodes() == nen);
+  for (int i = 0; i < np; ++i) {
+    apf::NewArray<double> v;
+    apf::NewArray<apf::Vector3> g;
+    es->getValues(0, 0, xi[i], v);
+    es->getLocalGradients(0, 0, xi[i], g);
+    for (int j = 0; j < nen; ++j) {
+      PCU_ALWAYS_ASSERT(std::abs(values[i * nen + j] - v[j]) < 1e-14);
+      PCU_ALWAYS_ASSERT(table->getValues(i)[j] == values[i * nen + j]);
+      if (type == apf::Mesh::VERTEX)
+        continue;
+      PCU_ALWAYS_ASSERT((grads[i * nen + j] - g[j]).getLength() < 1e-13);
+      PCU_ALWAYS_ASSERT(
+          (table->getLocalGradients(i)[j] - grads[i * nen + j]).getLength()
+          < 1e-13);
+    }
+  }
+}
+
+void checkShapes(apf::FieldShape* s)
+{
+  for (int type = 0; type < apf::Mesh::TYPES; ++type)
+    for (int order = 1; order <= 3; ++order)
+      checkShape(s, type, order);
+}
+
+/* the way integration loops used to get their shape functions */
+double timePerPoint(apf::Mesh* m, apf::FieldShape* s, int order, double& sum)
+{
+  sum = 0;
+  int type = apf::Mesh::TET;
+  apf::EntityShape* es = s->getEntityShape(type);
+  apf::Integration const* in = apf::getIntegration(type)->getAccurate(order);
+  double t0 = PCU_Time();
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it)))
+    for (int p = 0; p < in->countPoints(); ++p) {
+      apf::NewArray<double> v;
+      apf::NewArray<apf::Vector3> g;
+      es->getValues(m, e, in->getPoint(p)->param, v);
+      es->getLocalGradients(m, e, in->getPoint(p)->param, g);
+      sum += v[0] + g[1][0];
+    }
+  m->end(it);
+  return PCU_Time() - t0;
+}
+
+double timeTable(apf::Mesh* m, apf::FieldShape* s, int order, double& sum)
+{
+  sum = 0;
+  int type = apf::Mesh::TET;
+  double t0 = PCU_Time();
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it))) {
+    apf::ShapeTable const* t = apf::getShapeTable(s, type, order);
+    for (int p = 0; p < t->countPoints(); ++p)
+      sum += t->getValues(p)[0] + t->getLocalGradients(p)[1][0];
+  }
+  m->end(it);
+  return PCU_Time() - t0;
+}
+
+double timeMeasure(apf::Mesh* m, double& volume)
+{
+  volume = 0;
+  double t0 = PCU_Time();
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(3);
+  while ((e = m->iterate(it)))
+    volume += apf::measure(m, e);
+  m->end(it);
+  return PCU_Time() - t0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  gmi_register_mesh();
+  checkShapes(apf::getLagrange(1));
+  checkShapes(apf::getLagrange(2));
+  checkShapes(apf::getSerendipity());
+  for (int p = 2; p <= 4; ++p)
+    checkShapes(crv::getBezier(p));
+  apf::Mesh2* m = test::makeBox(n);
+  for (int o = 1; o <= 2; ++o) {
+    apf::FieldShape* s = apf::getLagrange(o);
+    double expected, sum;
+    double point = timePerPoint(m, s, 3, expected);
+    double table = timeTable(m, s, 3, sum);
+    PCU_ALWAYS_ASSERT(std::abs(sum - expected) < 1e-9 * std::abs(expected));
+    printf("Lagrange %d on %lu tets: per point %f s, table %f s\n",
+        o, (unsigned long)m->count(3), point, table);
+  }
+  double volume;
+  double t = timeMeasure(m, volume);
+  PCU_ALWAYS_ASSERT(std::abs(volume - 1) < 1e-10);
+  printf("measuring all tets took %f s\n", t);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
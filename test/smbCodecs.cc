@@ -0,0 +1,93 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#ifdef HAVE_SIMMETRIX
+#include <gmi_sim.h>
+#include <SimUtil.h>
+#include <MeshSim.h>
+#include <SimModel.h>
+#endif
+#include <pcu_util.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace {
+
+/* "outN.smb.zst" for "out.smb.zst", as mds names part files */
+long partFileSize(std::string const& path)
+{
+  size_t at = path.rfind(".smb");
+  std::stringstream ss;
+  ss << path.substr(0, at) << PCU_Comm_Self() << path.substr(at);
+  struct stat st;
+  PCU_ALWAYS_ASSERT(!stat(ss.str().c_str(), &st));
+  return st.st_size;
+}
+
+/* writes the mesh to path, reads it back and reports the
+   time of each and the size of the files relative to raw */
+void measure(const char* model, apf::Mesh2* m, const char* path,
+    long& raw)
+{
+  double t0 = PCU_Time();
+  m->writeNative(path);
+  double t1 = PCU_Time();
+  apf::Mesh2* m2 = apf::loadMdsMesh(model, path);
+  double t2 = PCU_Time();
+  for (int d = 0; d <= m->getDimension(); ++d)
+    PCU_ALWAYS_ASSERT(m2->count(d) == m->count(d));
+  m2->destroyNative();
+  apf::destroyMesh(m2);
+  long bytes = PCU_Add_Long(partFileSize(path));
+  if (!raw)
+    raw = bytes;
+  double write = PCU_Max_Double(t1 - t0);
+  double read = PCU_Max_Double(t2 - t1);
+  if (!PCU_Comm_Self())
+    printf("%s: %ld bytes (%.1f%%), write %f s (%.1f MB/s),"
+        " read %f s (%.1f MB/s)\n", path, bytes, 100.0 * bytes / raw,
+        write, raw / write / 1e6, read, raw / read / 1e6);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc < 4) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <model> <mesh> <out.smb> [out.smb.zst ...]\n",
+          argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+#ifdef HAVE_SIMMETRIX
+  MS_init();
+  SimModel_start();
+  Sim_readLicenseFile(0);
+  gmi_sim_start();
+  gmi_register_sim();
+#endif
+  gmi_register_mesh();
+  apf::Mesh2* m = apf::loadMdsMesh(argv[1], argv[2]);
+  /* the first output sets the size the others are compared to */
+  long raw = 0;
+  for (int i = 3; i < argc; ++i)
+    measure(argv[1], m, argv[i], raw);
+  m->destroyNative();
+  apf::destroyMesh(m);
+#ifdef HAVE_SIMMETRIX
+  gmi_sim_stop();
+  Sim_unregisterAllKeys();
+  SimModel_stop();
+  MS_exit();
+#endif
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,79 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_io.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include "testBox.h"
+
+namespace {
+
+double sumCoords(apf::Mesh* m)
+{
+  double sum = 0;
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(v, 0, x);
+    sum += x.x() + x.y() + x.z();
+  }
+  m->end(it);
+  return sum;
+}
+
+/* every part reads the part of its mirror rank straight from
+   the container, the way a different partition would pick parts */
+void checkMirror(const char* path)
+{
+  int self = PCU_Comm_Self();
+  int part = PCU_Comm_Peers() - 1 - self;
+  if (self % 2)
+    part = -1;
+  pcu_file* f = pcu_read_container(path, part);
+  if (part >= 0) {
+    unsigned header[4];
+    pcu_read_unsigneds(f, header, 4);
+    PCU_ALWAYS_ASSERT(header[3] == (unsigned)PCU_Comm_Peers());
+  }
+  pcu_fclose(f);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <out.smbc>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]) + PCU_Comm_Self();
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  double t0 = PCU_Time();
+  m->writeNative(argv[2]);
+  double t1 = PCU_Max_Double(PCU_Time() - t0);
+  apf::disownMdsModel(m);
+  apf::Mesh2* m2 = apf::loadMdsMesh(m->getModel(), argv[2]);
+  double t2 = PCU_Max_Double(PCU_Time() - t0) - t1;
+  for (int d = 0; d <= 3; ++d)
+    PCU_ALWAYS_ASSERT(m2->count(d) == m->count(d));
+  PCU_ALWAYS_ASSERT(sumCoords(m2) == sumCoords(m));
+  m2->verify();
+  checkMirror(argv[2]);
+  if (!PCU_Comm_Self())
+    printf("container write %f s, read %f s\n", t1, t2);
+  m2->destroyNative();
+  apf::destroyMesh(m2);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,138 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include "testBox.h"
+
+namespace {
+
+/* vertices get their coordinates as a double tag and
+   elements a long tag, so both come back from the file */
+void tagMesh(apf::Mesh2* m)
+{
+  apf::MeshTag* coords = m->createDoubleTag("coords", 3);
+  apf::MeshTag* ids = m->createLongTag("ids", 1);
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(0);
+  while ((e = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(e, 0, x);
+    double d[3];
+    x.toArray(d);
+    m->setDoubleTag(e, coords, d);
+  }
+  m->end(it);
+  long id = 0;
+  it = m->begin(3);
+  while ((e = m->iterate(it))) {
+    m->setLongTag(e, ids, &id);
+    ++id;
+  }
+  m->end(it);
+}
+
+void checkTags(apf::Mesh2* m)
+{
+  apf::MeshTag* coords = m->findTag("coords");
+  apf::MeshTag* ids = m->findTag("ids");
+  PCU_ALWAYS_ASSERT(coords && ids);
+  apf::MeshEntity* e;
+  apf::MeshIterator* it = m->begin(0);
+  while ((e = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(e, 0, x);
+    double d[3];
+    m->getDoubleTag(e, coords, d);
+    PCU_ALWAYS_ASSERT(d[0] == x[0] && d[1] == x[1] && d[2] == x[2]);
+  }
+  m->end(it);
+  long expected = 0;
+  it = m->begin(3);
+  while ((e = m->iterate(it))) {
+    long id;
+    m->getLongTag(e, ids, &id);
+    PCU_ALWAYS_ASSERT(id == expected);
+    ++expected;
+  }
+  m->end(it);
+}
+
+/* adding vertices past the mapped capacity copies the
+   arrays out of the mapping, which must keep their contents */
+void growMesh(apf::Mesh2* m)
+{
+  apf::MeshTag* coords = m->findTag("coords");
+  apf::ModelEntity* c = m->toModel(apf::getMdsEntity(m, 3, 0));
+  size_t before = m->count(0);
+  for (int i = 0; i < 10; ++i) {
+    apf::Vector3 x(i, i, i);
+    apf::MeshEntity* v = m->createVert(c);
+    m->setPoint(v, 0, x);
+    double d[3];
+    x.toArray(d);
+    m->setDoubleTag(v, coords, d);
+  }
+  PCU_ALWAYS_ASSERT(m->count(0) == before + 10);
+}
+
+/* plain SMB files do not store long tags */
+void destroy(apf::Mesh2* m)
+{
+  apf::MeshTag* coords = m->findTag("coords");
+  apf::removeTagFromDimension(m, coords, 0);
+  m->destroyTag(coords);
+  apf::MeshTag* ids = m->findTag("ids");
+  if (ids) {
+    apf::removeTagFromDimension(m, ids, 3);
+    m->destroyTag(ids);
+  }
+  m->destroyNative();
+  apf::destroyMesh(m);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 4) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions> <out.smb> <out.smbm>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  tagMesh(m);
+  m->writeNative(argv[2]);
+  m->writeNative(argv[3]);
+  apf::disownMdsModel(m);
+  double t0 = PCU_Time();
+  apf::Mesh2* read = apf::loadMdsMesh(m->getModel(), argv[2]);
+  double t1 = PCU_Time();
+  apf::disownMdsModel(read);
+  apf::Mesh2* mapped = apf::loadMdsMesh(m->getModel(), argv[3]);
+  double t2 = PCU_Time();
+  for (int d = 0; d <= 3; ++d)
+    PCU_ALWAYS_ASSERT(mapped->count(d) == m->count(d));
+  checkTags(mapped);
+  mapped->verify();
+  growMesh(mapped);
+  checkTags(mapped);
+  double readTime = PCU_Max_Double(t1 - t0);
+  double mapTime = PCU_Max_Double(t2 - t1);
+  if (!PCU_Comm_Self())
+    printf("loading %s took %f s, %s took %f s\n",
+        argv[2], readTime, argv[3], mapTime);
+  destroy(read);
+  destroy(m);
+  destroy(mapped);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
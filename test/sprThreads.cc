@@ -0,0 +1,106 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <spr.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "testBox.h"
+
+namespace {
+
+apf::Field* makeGradient(apf::Mesh2* m)
+{
+  apf::Field* u = apf::createLagrangeField(m, "u", apf::VECTOR, 1);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(v, 0, x);
+    apf::setVector(u, v, 0, apf::Vector3(x.x() * x.x(), x.x() * x.y(), x.z()));
+  }
+  m->end(it);
+  apf::Field* eps = spr::getGradIPField(u, "eps", 1);
+  apf::destroyField(u);
+  return eps;
+}
+
+double timeRecovery(apf::Field* eps, int threads, apf::Field*& recovered)
+{
+  spr::setThreads(threads);
+  double t0 = PCU_Time();
+  recovered = spr::recoverField(eps);
+  double t = PCU_Max_Double(PCU_Time() - t0);
+  spr::setThreads(1);
+  return t;
+}
+
+void checkSame(apf::Field* a, apf::Field* b)
+{
+  apf::Mesh* m = apf::getMesh(a);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it))) {
+    if (!m->isOwned(v))
+      continue;
+    apf::Matrix3x3 x, y;
+    apf::getMatrix(a, v, 0, x);
+    apf::getMatrix(b, v, 0, y);
+    for (int i = 0; i < 3; ++i)
+      PCU_ALWAYS_ASSERT((x[i] - y[i]).getLength() < 1e-9);
+  }
+  m->end(it);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int n = atoi(argv[1]);
+  int maxThreads = 4;
+#ifdef _OPENMP
+  maxThreads = omp_get_max_threads();
+#endif
+  gmi_register_mesh();
+  /* every part builds its own box and sends the half x < 0.5 to
+     the next part, so some patches have to be pulled together */
+  apf::Mesh2* m = test::makeBox(n);
+  if (PCU_Comm_Peers() > 1)
+    test::migrateHalfToNext(m);
+  apf::Field* eps = makeGradient(m);
+  apf::Field* serial;
+  double one = timeRecovery(eps, 1, serial);
+  apf::renameField(serial, "serial");
+  if (!PCU_Comm_Self())
+    printf("%d ranks, %lu tets on rank 0: 1 thread %f s\n",
+        PCU_Comm_Peers(), (unsigned long)m->count(3), one);
+  for (int t = 2; t <= maxThreads; t *= 2) {
+    apf::Field* threaded;
+    double time = timeRecovery(eps, t, threaded);
+    checkSame(serial, threaded);
+    apf::destroyField(threaded);
+    if (!PCU_Comm_Self())
+      printf("%d threads %f s, speedup %.2f\n", t, time, one / time);
+  }
+  apf::destroyField(serial);
+  apf::destroyField(eps);
+  m->verify();
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
@@ -0,0 +1,131 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "testBox.h"
+
+namespace {
+
+/* names like the ones apf fields give their tags */
+std::string getName(int i)
+{
+  char s[32];
+  sprintf(s, "solution_%d_ver", i);
+  return s;
+}
+
+void checkTags(apf::Mesh2* m, std::vector<apf::MeshTag*>& tags)
+{
+  for (size_t i = 0; i < tags.size(); ++i) {
+    std::string name = getName(i);
+    PCU_ALWAYS_ASSERT(m->findTag(name.c_str()) == tags[i]);
+    PCU_ALWAYS_ASSERT(name == m->getTagName(tags[i]));
+    int id = apf::getMdsTagId(m, tags[i]);
+    PCU_ALWAYS_ASSERT(apf::getMdsTag(m, id) == tags[i]);
+  }
+}
+
+double timeFind(apf::Mesh2* m, int ntags, long lookups)
+{
+  std::vector<std::string> names(ntags);
+  for (int i = 0; i < ntags; ++i)
+    names[i] = getName(i);
+  long found = 0;
+  double t0 = PCU_Time();
+  for (long i = 0; i < lookups; ++i)
+    if (m->findTag(names[i % ntags].c_str()))
+      ++found;
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(found == lookups);
+  return t;
+}
+
+double timeIds(apf::Mesh2* m, std::vector<apf::MeshTag*>& tags, long lookups)
+{
+  std::vector<int> ids(tags.size());
+  for (size_t i = 0; i < tags.size(); ++i)
+    ids[i] = apf::getMdsTagId(m, tags[i]);
+  long found = 0;
+  double t0 = PCU_Time();
+  for (long i = 0; i < lookups; ++i)
+    if (apf::getMdsTag(m, ids[i % ids.size()]))
+      ++found;
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(found == lookups);
+  return t;
+}
+
+/* apf::Mesh::isGhost looks up a tag for every entity */
+double timeGhostQueries(apf::Mesh2* m, int reps)
+{
+  long ghosts = 0;
+  double t0 = PCU_Time();
+  for (int r = 0; r < reps; ++r) {
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = m->begin(0);
+    while ((e = m->iterate(it)))
+      if (m->isGhost(e))
+        ++ghosts;
+    m->end(it);
+  }
+  double t = PCU_Time() - t0;
+  PCU_ALWAYS_ASSERT(ghosts == 0);
+  return t;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 3) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <tags> <lookups>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  int ntags = atoi(argv[1]);
+  long lookups = atol(argv[2]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(4);
+  std::vector<apf::MeshTag*> tags(ntags);
+  for (int i = 0; i < ntags; ++i)
+    tags[i] = m->createDoubleTag(getName(i).c_str(), 1);
+  checkTags(m, tags);
+  /* renaming and recreating a tag keeps the index consistent */
+  m->renameTag(tags[0], "renamed");
+  PCU_ALWAYS_ASSERT(!m->findTag(getName(0).c_str()));
+  PCU_ALWAYS_ASSERT(m->findTag("renamed") == tags[0]);
+  m->renameTag(tags[0], getName(0).c_str());
+  int id = apf::getMdsTagId(m, tags[ntags / 2]);
+  m->destroyTag(tags[ntags / 2]);
+  PCU_ALWAYS_ASSERT(!apf::getMdsTag(m, id));
+  tags[ntags / 2] = m->createDoubleTag(getName(ntags / 2).c_str(), 1);
+  PCU_ALWAYS_ASSERT(apf::getMdsTagId(m, tags[ntags / 2]) == id);
+  checkTags(m, tags);
+  apf::reorderMdsMesh(m);
+  checkTags(m, tags);
+  double find = timeFind(m, ntags, lookups);
+  double byId = timeIds(m, tags, lookups);
+  int reps = lookups / m->count(0) + 1;
+  double ghost = timeGhostQueries(m, reps);
+  if (!PCU_Comm_Self()) {
+    printf("%ld lookups among %d tags\n", lookups, ntags);
+    printf("by name %f s (%e lookups/second), by id %f s\n",
+        find, lookups / find, byId);
+    printf("isGhost on %ld vertices %f s\n", reps * (long)m->count(0), ghost);
+  }
+  for (int i = 0; i < ntags; ++i)
+    m->destroyTag(tags[i]);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}
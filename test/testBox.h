@@ -0,0 +1,45 @@
+#ifndef TEST_BOX_H
+#define TEST_BOX_H
+
+/* mesh setup shared by the test drivers that work on an MDS box */
+
+#include <apfMDS.h>
+#include <apfBox.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <PCU.h>
+
+namespace test {
+
+/* the unit cube cut into n x n x n hexahedra, each split into tets */
+inline apf::Mesh2* makeBox(int n)
+{
+  return apf::makeMdsBox(n, n, n, 1, 1, 1, true);
+}
+
+/* sends the elements of this part with centroids at x < 0.5
+   to part (to); a part that names itself sends nothing.
+   This is collective. */
+inline void migrateHalf(apf::Mesh2* m, int to)
+{
+  apf::Migration* plan = new apf::Migration(m);
+  if (to != PCU_Comm_Self()) {
+    apf::MeshEntity* e;
+    apf::MeshIterator* it = m->begin(3);
+    while ((e = m->iterate(it)))
+      if (apf::getLinearCentroid(m, e).x() < 0.5)
+        plan->send(e, to);
+    m->end(it);
+  }
+  m->migrate(plan);
+}
+
+/* every part sends its half to the next part */
+inline void migrateHalfToNext(apf::Mesh2* m)
+{
+  migrateHalf(m, (PCU_Comm_Self() + 1) % PCU_Comm_Peers());
+}
+
+}
+
+#endif
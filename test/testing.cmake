@@ -22,6 +22,26 @@ mpi_test(integrate 1 ./integrate)
 mpi_test(qr_test 1 ./qr)
 mpi_test(base64 1 ./base64)
 mpi_test(tensor_test 1 ./tensor)
+mpi_test(mdsRange 1 ./mdsRange 8 3)
+mpi_test(freezeAdjacency 1 ./freezeAdjacency 6 3)
+mpi_test(pcuNeighbors 4 ./pcuNeighbors 100 1024)
+mpi_test(pcuPack 4 ./pcuPack 100000 3)
+mpi_test(migrateBox 4 ./migrateBox 6 4)
+mpi_test(smbContainer 4 ./smbContainer 4 box.smbc)
+mpi_test(smbMapped 4 ./smbMapped 8 mapbox.smb mapbox.smbm)
+mpi_test(fieldRange 1 ./fieldRange 8 100)
+mpi_test(tagLookup 1 ./tagLookup 128 1000000)
+mpi_test(sfcReorder 1 ./sfcReorder 10 4)
+mpi_test(pcuThreads 4 ./pcuThreads 10000)
+mpi_test(remotePeers 4 ./remotePeers 8 20)
+mpi_test(shapeBatch 1 ./shapeBatch 16)
+mpi_test(geometryCache 1 ./geometryCache 12 10)
+mpi_test(sprThreads 2 ./sprThreads 10)
+mpi_test(vtuStream 1 ./vtuStream 20)
+mpi_test(maProfile 2 ./maProfile 6)
+mpi_test(edgeLengths 1 ./edgeLengths 12)
+mpi_test(cavityThreads 1 ./cavityThreads 12 2)
+mpi_test(mdsArena 1 ./mdsArena 8 2)
 
 
 if(ENABLE_SIMMETRIX)
@@ -191,6 +211,21 @@ mpi_test(uniform_serial 1
   "${MDIR}/pipe.${GXT}"
   "pipe.smb"
   "pipe_unif.smb")
+set(CODEC_OUTS "pipe_raw.smb")
+if(PCU_COMPRESS)
+  list(APPEND CODEC_OUTS "pipe_raw.smb.bz2")
+endif()
+if(PCU_ZSTD)
+  list(APPEND CODEC_OUTS "pipe_raw.smb.zst")
+endif()
+if(PCU_LZ4)
+  list(APPEND CODEC_OUTS "pipe_raw.smb.lz4")
+endif()
+mpi_test(smbCodecs 1
+  ./smbCodecs
+  "${MDIR}/pipe.${GXT}"
+  "pipe.smb"
+  ${CODEC_OUTS})
 if(ENABLE_SIMMETRIX)
   mpi_test(snap_serial 1
     ./snap
@@ -367,6 +402,7 @@ mpi_test(construct 4
   ./construct
   "${MDIR}/cube.dmg"
   "${MDIR}/pumi7k/4/cube.smb")
+mpi_test(constructBox 4 ./constructBox 12)
 set(MDIR ${MESHES}/spr)
 mpi_test(spr_3D 4
   ./spr_test
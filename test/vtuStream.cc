@@ -0,0 +1,199 @@
+#include <gmi_mesh.h>
+#include <apfMDS.h>
+#include <apfMesh2.h>
+#include <apf.h>
+#include <lionBase64.h>
+#include <lionCompress.h>
+#include <PCU.h>
+#include <pcu_util.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "testBox.h"
+
+namespace {
+
+std::string readFile(const char* path)
+{
+  std::ifstream in(path);
+  PCU_ALWAYS_ASSERT(in.is_open());
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+double timeWriting(void (*write)(const char*, apf::Mesh*, int),
+    const char* prefix, apf::Mesh* m, std::string& file)
+{
+  double t0 = PCU_Time();
+  write(prefix, m, -1);
+  double t = PCU_Time() - t0;
+  file = readFile((std::string(prefix) + "/0/0.vtu").c_str());
+  PCU_ALWAYS_ASSERT(file.compare(file.size() - 11, 11, "</VTKFile>\n") == 0);
+  return t;
+}
+
+/* the size of the length header at the start of an array */
+std::size_t countHeaderBytes(const char* header)
+{
+  if (!lion::can_compress)
+    return sizeof(unsigned);
+  long nblocks;
+  memcpy(&nblocks, header, sizeof(long));
+  return (3 + nblocks) * sizeof(long);
+}
+
+/* checks the length header of an array of (bytes) and
+   returns the size of the (compressed) data after it */
+std::size_t checkHeader(const char* header, std::size_t bytes)
+{
+  if (!lion::can_compress) {
+    unsigned len;
+    memcpy(&len, header, sizeof(len));
+    PCU_ALWAYS_ASSERT(len == bytes);
+    return bytes;
+  }
+  long lens[3];
+  memcpy(lens, header, sizeof(lens));
+  PCU_ALWAYS_ASSERT(lens[0] >= 1);
+  PCU_ALWAYS_ASSERT((lens[0] - 1) * lens[1] + lens[2] == long(bytes));
+  std::size_t compressed = 0;
+  for (long i = 0; i < lens[0]; ++i) {
+    long len;
+    memcpy(&len, header + (3 + i) * sizeof(long), sizeof(long));
+    compressed += len;
+  }
+  return compressed;
+}
+
+/* returns the raw bytes of an array when it was not compressed */
+std::string readEncoded(std::string const& file, const char* name,
+    std::size_t bytes)
+{
+  std::string key = std::string("Name=\"") + name + "\"";
+  std::size_t at = file.find(key);
+  PCU_ALWAYS_ASSERT(at != std::string::npos);
+  PCU_ALWAYS_ASSERT(file.find("format=\"binary\"", at) < file.find('\n', at));
+  std::size_t begin = file.find('\n', at) + 1;
+  std::size_t end = file.find('\n', begin);
+  PCU_ALWAYS_ASSERT(file.compare(end + 1, 12, "</DataArray>") == 0);
+  std::string line = file.substr(begin, end - begin);
+  std::string start = lion::base64Decode(line.substr(0, 12));
+  std::size_t headerBytes = countHeaderBytes(start.data());
+  std::size_t headerChars = lion::base64EncodedLength(headerBytes);
+  std::string header = lion::base64Decode(line.substr(0, headerChars));
+  std::size_t dataBytes = checkHeader(header.data(), bytes);
+  PCU_ALWAYS_ASSERT(line.size() ==
+      headerChars + lion::base64EncodedLength(dataBytes));
+  if (lion::can_compress)
+    return std::string();
+  return lion::base64Decode(line.substr(headerChars));
+}
+
+std::string readAppended(std::string const& file, const char* name,
+    std::size_t bytes)
+{
+  std::string key = std::string("Name=\"") + name + "\"";
+  std::size_t at = file.find(key);
+  PCU_ALWAYS_ASSERT(at != std::string::npos);
+  std::string format = " format=\"appended\" offset=\"";
+  at = file.find(format, at);
+  PCU_ALWAYS_ASSERT(at < file.find('\n', at));
+  std::size_t offset = strtoul(&file[at + format.size()], 0, 10);
+  std::string section = "<AppendedData encoding=\"raw\">\n_";
+  std::size_t base = file.find(section) + section.size();
+  PCU_ALWAYS_ASSERT(base + offset < file.size());
+  const char* header = &file[base + offset];
+  std::size_t headerBytes = countHeaderBytes(header);
+  std::size_t dataBytes = checkHeader(header, bytes);
+  PCU_ALWAYS_ASSERT(base + offset + headerBytes + dataBytes < file.size());
+  if (lion::can_compress)
+    return std::string();
+  return file.substr(base + offset + headerBytes, dataBytes);
+}
+
+typedef std::string (*ArrayReader)(std::string const& file,
+    const char* name, std::size_t bytes);
+
+void checkArrays(std::string const& file, ArrayReader read, apf::Mesh* m)
+{
+  std::size_t nv = m->count(0);
+  std::size_t ne = m->count(3);
+  std::string points = read(file, "coordinates", 3 * nv * sizeof(double));
+  std::string values = read(file, "u", 3 * nv * sizeof(double));
+  PCU_ALWAYS_ASSERT(points == values);
+  std::string offsets = read(file, "offsets", ne * sizeof(int));
+  if (!offsets.empty()) {
+    int last;
+    memcpy(&last, &offsets[offsets.size() - sizeof(int)], sizeof(int));
+    PCU_ALWAYS_ASSERT(last == int(4 * ne));
+  }
+  read(file, "types", ne);
+  read(file, "connectivity", 4 * ne * sizeof(int));
+  read(file, "apf_part", ne * sizeof(int));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc,&argv);
+  PCU_Comm_Init();
+  if (argc != 2) {
+    if (!PCU_Comm_Self())
+      printf("Usage: %s <box divisions>\n", argv[0]);
+    MPI_Finalize();
+    exit(EXIT_FAILURE);
+  }
+  PCU_ALWAYS_ASSERT(PCU_Comm_Peers() == 1);
+  int n = atoi(argv[1]);
+  gmi_register_mesh();
+  apf::Mesh2* m = test::makeBox(n);
+  /* a field equal to the coordinates must come out as the points do */
+  apf::Field* u = apf::createLagrangeField(m, "u", apf::VECTOR, 1);
+  apf::MeshEntity* v;
+  apf::MeshIterator* it = m->begin(0);
+  while ((v = m->iterate(it))) {
+    apf::Vector3 x;
+    m->getPoint(v, 0, x);
+    apf::setVector(u, v, 0, x);
+  }
+  m->end(it);
+  std::string binary;
+  double binaryTime = timeWriting(apf::writeVtkFiles, "stream_vtu", m, binary);
+  checkArrays(binary, readEncoded, m);
+  std::string appended;
+  double appendedTime = timeWriting(apf::writeAppendedVtkFiles,
+      "stream_appended", m, appended);
+  checkArrays(appended, readAppended, m);
+  PCU_ALWAYS_ASSERT(appended.compare(appended.size() - 28, 28,
+        "\n</AppendedData>\n</VTKFile>\n") == 0);
+  PCU_ALWAYS_ASSERT(appended.size() < binary.size());
+  std::size_t nv = m->count(0);
+  std::size_t ne = m->count(3);
+  /* the arrays of the mesh and its fields */
+  double mb = (6 * nv * sizeof(double) + 10 * ne * sizeof(int) + ne) / 1e6;
+  printf("%lu tets, %.1f MB of arrays\n", (unsigned long)ne, mb);
+  printf("binary: %f s (%.1f MB/s), %.1f MB file\n",
+      binaryTime, mb / binaryTime, binary.size() / 1e6);
+  printf("appended: %f s (%.1f MB/s), %.1f MB file\n",
+      appendedTime, mb / appendedTime, appended.size() / 1e6);
+  /* ASCII text goes out in pieces as it is written */
+  apf::writeASCIIVtkFiles("stream_ascii", m);
+  std::string file = readFile("stream_ascii/0/0.vtu");
+  PCU_ALWAYS_ASSERT(file.compare(file.size() - 11, 11, "</VTKFile>\n") == 0);
+  std::size_t lines = 0;
+  for (std::size_t i = 0; i < file.size(); ++i)
+    lines += (file[i] == '\n');
+  /* points, u, connectivity, offsets, types and the cell part ids
+     each take a line per entry */
+  PCU_ALWAYS_ASSERT(lines > 2 * nv + 4 * ne);
+  apf::destroyField(u);
+  m->destroyNative();
+  apf::destroyMesh(m);
+  PCU_Comm_Free();
+  MPI_Finalize();
+}